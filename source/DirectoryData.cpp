@@ -8,84 +8,945 @@
 
 #include "DirectoryData.hpp"
 #include <filesystem>
+#include <fstream>
+#include <cstring>
+#include <ctime>
+#include <unordered_map>
 using namespace filesystem;
 
+//items are stored by value for every file, keep them small
+static_assert(sizeof(DirectoryData) <= 48, "DirectoryData has grown");
+
+/**
+ Create a tree containing only the root folder
+ @param rootPath the path to the root folder
+ */
+DirectoryTree::DirectoryTree(const string& rootPath){
+	nodeIndex r = allocate(1);
+	DirectoryData* root = at(r);
+	root->isFolder = true;
+	root->slot = allocateFolders(1);
+	root->name = names.intern(rootPath);
+}
+
+/**
+ Layout of a snapshot file: this header, then the item records, then the folder records, then the hard-linked bytes
+ of each item, then the allocated bytes of each item, then the times of each item,
+ then the owner of each item, then the mode of each item,
+ then the name pool's storage.
+ Each section starts on a page boundary so that it can be used in place once mapped.
+ */
+struct snapshotHeader{
+	char magic[8];
+	//bump when DirectoryData or the name pool's layout changes
+	uint32_t version;
+	uint32_t recordSize;
+	//snapshots are only loaded on machines with the same byte order
+	uint32_t byteOrder;
+	uint32_t reserved;
+	uint64_t numNodes;
+	uint64_t nodesOffset;
+	uint64_t numFolders;
+	uint64_t foldersOffset;
+	uint64_t linkedOffset;
+	uint64_t allocatedOffset;
+	uint64_t timesOffset;
+	uint64_t ownersOffset;
+	uint64_t modesOffset;
+	uint64_t namesLength;
+	uint64_t namesOffset;
+	int64_t savedAt;
+	int64_t agesFrom;
+	uint32_t agesBy;
+	uint32_t agesMode;
+};
+static constexpr char snapshotMagic[8] = {'F','F','F','S','C','A','N','\0'};
+static constexpr uint32_t snapshotVersion = 10;
+static constexpr uint32_t snapshotByteOrder = 0x01020304;
+static constexpr uint64_t snapshotAlign = 4096;
+
+/**
+ Save the tree to a snapshot file, which can be opened later with load.
+ The file is written next to its destination and then moved into place.
+ @param file the path to the snapshot file
+ @throws runtime_error if the file cannot be written
+ @note the tree must not be sizing while it is saved
+ */
+void DirectoryTree::save(const string& file) const{
+	auto alignUp = [](uint64_t value){
+		return (value + snapshotAlign - 1) & ~(snapshotAlign - 1);
+	};
+	snapshotHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, snapshotMagic, sizeof(header.magic));
+	header.version = snapshotVersion;
+	header.recordSize = sizeof(DirectoryData);
+	header.byteOrder = snapshotByteOrder;
+	header.numNodes = count;
+	header.nodesOffset = alignUp(sizeof(header));
+	header.numFolders = folderCount;
+	header.foldersOffset = alignUp(header.nodesOffset + header.numNodes * sizeof(DirectoryData));
+	header.linkedOffset = alignUp(header.foldersOffset + header.numFolders * sizeof(folderRecord));
+	header.namesLength = names.bytes();
+	header.allocatedOffset = alignUp(header.linkedOffset + header.numNodes * sizeof(fileSize));
+	header.timesOffset = alignUp(header.allocatedOffset + header.numNodes * sizeof(fileSize));
+	header.ownersOffset = alignUp(header.timesOffset + header.numNodes * sizeof(itemTimes));
+	header.modesOffset = alignUp(header.ownersOffset + header.numNodes * sizeof(itemOwner));
+	header.namesOffset = alignUp(header.modesOffset + header.numNodes * sizeof(itemMode));
+	header.savedAt = time(nullptr);
+	header.agesFrom = agesFrom;
+	header.agesBy = (uint32_t)agesBy;
+	header.agesMode = (uint32_t)agesMode;
+
+	string temp = file + ".tmp";
+	{
+		ofstream out(temp, ios::binary | ios::trunc);
+		auto pad = [&](uint64_t offset){
+			static const char zeros[snapshotAlign] = {};
+			out.write(zeros, offset - (uint64_t)out.tellp());
+		};
+		out.write((const char*)&header, sizeof(header));
+		pad(header.nodesOffset);
+		//write the items chunk by chunk
+		for (uint64_t i = 0; i < header.numNodes; i += nodes.chunkSize){
+			uint64_t num = min<uint64_t>(nodes.chunkSize, header.numNodes - i);
+			out.write((const char*)nodes.at(i), num * sizeof(DirectoryData));
+		}
+		pad(header.foldersOffset);
+		for (uint64_t i = 0; i < header.numFolders; i += folders.chunkSize){
+			uint64_t num = min<uint64_t>(folders.chunkSize, header.numFolders - i);
+			out.write((const char*)folders.at(i), num * sizeof(folderRecord));
+		}
+		pad(header.linkedOffset);
+		for (uint64_t i = 0; i < header.numNodes; i += linked.chunkSize){
+			uint64_t num = min<uint64_t>(linked.chunkSize, header.numNodes - i);
+			out.write((const char*)linked.at(i), num * sizeof(fileSize));
+		}
+		pad(header.allocatedOffset);
+		for (uint64_t i = 0; i < header.numNodes; i += allocated.chunkSize){
+			uint64_t num = min<uint64_t>(allocated.chunkSize, header.numNodes - i);
+			out.write((const char*)allocated.at(i), num * sizeof(fileSize));
+		}
+		pad(header.timesOffset);
+		for (uint64_t i = 0; i < header.numNodes; i += times.chunkSize){
+			uint64_t num = min<uint64_t>(times.chunkSize, header.numNodes - i);
+			out.write((const char*)times.at(i), num * sizeof(itemTimes));
+		}
+		pad(header.ownersOffset);
+		for (uint64_t i = 0; i < header.numNodes; i += owners.chunkSize){
+			uint64_t num = min<uint64_t>(owners.chunkSize, header.numNodes - i);
+			out.write((const char*)owners.at(i), num * sizeof(itemOwner));
+		}
+		pad(header.modesOffset);
+		for (uint64_t i = 0; i < header.numNodes; i += modes.chunkSize){
+			uint64_t num = min<uint64_t>(modes.chunkSize, header.numNodes - i);
+			out.write((const char*)modes.at(i), num * sizeof(itemMode));
+		}
+		pad(header.namesOffset);
+		for (uint64_t i = 0; i < header.namesLength; i += namePool::chunkBytes){
+			uint64_t num = min<uint64_t>(namePool::chunkBytes, header.namesLength - i);
+			out.write(names.bytesAt(i), num);
+		}
+		out.flush();
+		if (!out){
+			throw runtime_error("Cannot write " + temp);
+		}
+	}
+	error_code ec;
+	rename(temp, file, ec);
+	if (ec){
+		throw runtime_error("Cannot write " + file + ": " + ec.message());
+	}
+}
+
+/**
+ Check that the items reachable from a snapshot's root only refer to items, folder records and names inside the snapshot,
+ so that a damaged file is reported instead of being read out of bounds. Each item is visited at most once.
+ @param header the snapshot's header, whose sections are known to fit in the file
+ @param data the start of the file
+ @return true if the items can be used
+ */
+static bool validSnapshot(const snapshotHeader& header, const char* data){
+	const DirectoryData* nodes = (const DirectoryData*)(data + header.nodesOffset);
+	const folderRecord* records = (const folderRecord*)(data + header.foldersOffset);
+	//every name is terminated before the end of the names, so reading one never runs past them
+	if (header.namesLength == 0 || data[header.namesOffset + header.namesLength - 1] != '\0'){
+		return false;
+	}
+	//flags are read as bytes first, since a damaged byte is not a valid bool
+	auto validFlags = [](const DirectoryData& item){
+		uint8_t folder, symlink;
+		memcpy(&folder, &item.isFolder, 1);
+		memcpy(&symlink, &item.isSymlink, 1);
+		return folder <= 1 && symlink <= 1;
+	};
+	if (!validFlags(nodes[0]) || nodes[0].parent != noNode || !nodes[0].isFolder){
+		return false;
+	}
+	vector<bool> visited(header.numNodes);
+	vector<bool> slotUsed(header.numFolders);
+	vector<nodeIndex> pending{0};
+	visited[0] = true;
+	while (pending.size() > 0){
+		nodeIndex index = pending.back();
+		pending.pop_back();
+		const DirectoryData& item = nodes[index];
+		if (namePool::offsetOf(item.name) >= header.namesLength){
+			return false;
+		}
+		if (!item.isFolder){
+			if (item.numChildren() > 0){
+				return false;
+			}
+			continue;
+		}
+		if (item.slot >= header.numFolders || slotUsed[item.slot]){
+			return false;
+		}
+		slotUsed[item.slot] = true;
+		uint64_t reserved = max<uint64_t>(records[item.slot].capacity, item.numChildren());
+		if (reserved == 0){
+			continue;
+		}
+		if ((uint64_t)item.firstChild + reserved > header.numNodes){
+			return false;
+		}
+		for (uint32_t i = 0; i < item.numChildren(); i++){
+			nodeIndex child = item.firstChild + i;
+			if (visited[child] || !validFlags(nodes[child]) || nodes[child].parent != index || nodes[child].isFolder != (i < item.numFolders)){
+				return false;
+			}
+			visited[child] = true;
+			pending.push_back(child);
+		}
+	}
+	return true;
+}
+
+/**
+ Open a snapshot file written by save. The file is mapped and its items and names are used in place,
+ so opening takes about the same time regardless of the size of the tree.
+ @param file the path to the snapshot file
+ @return the tree, which the caller owns
+ @throws runtime_error if the file is not a snapshot, or was written by an incompatible version
+ */
+DirectoryTree* DirectoryTree::load(const string& file){
+	unique_ptr<mappedFile> mapped;
+	try{
+		mapped = make_unique<mappedFile>(file);
+	}
+	catch(system_error& e){
+		throw runtime_error(e.what());
+	}
+	snapshotHeader header;
+	if (mapped->size() < sizeof(header)){
+		throw runtime_error(file + " is not a snapshot");
+	}
+	memcpy(&header, mapped->data(), sizeof(header));
+	if (memcmp(header.magic, snapshotMagic, sizeof(header.magic)) != 0){
+		throw runtime_error(file + " is not a snapshot");
+	}
+	if (header.version != snapshotVersion || header.recordSize != sizeof(DirectoryData) || header.byteOrder != snapshotByteOrder){
+		throw runtime_error(file + " was saved by a different version or platform");
+	}
+	if (header.numNodes == 0 || header.numNodes >= noNode || header.numFolders == 0 || header.numFolders >= noFolder
+		|| header.nodesOffset % snapshotAlign != 0 || header.foldersOffset % snapshotAlign != 0
+		|| header.linkedOffset % snapshotAlign != 0 || header.allocatedOffset % snapshotAlign != 0 || header.namesOffset % snapshotAlign != 0
+		|| header.timesOffset % snapshotAlign != 0 || header.ownersOffset % snapshotAlign != 0 || header.modesOffset % snapshotAlign != 0
+		|| header.nodesOffset + header.numNodes * sizeof(DirectoryData) > mapped->size()
+		|| header.foldersOffset + header.numFolders * sizeof(folderRecord) > mapped->size()
+		|| header.linkedOffset + header.numNodes * sizeof(fileSize) > mapped->size()
+		|| header.allocatedOffset + header.numNodes * sizeof(fileSize) > mapped->size()
+		|| header.timesOffset + header.numNodes * sizeof(itemTimes) > mapped->size()
+		|| header.ownersOffset + header.numNodes * sizeof(itemOwner) > mapped->size()
+		|| header.modesOffset + header.numNodes * sizeof(itemMode) > mapped->size()
+		|| header.agesBy > (uint32_t)ageBasis::used || header.agesMode > (uint32_t)sizeMode::allocated
+		|| header.namesOffset + header.namesLength > mapped->size()
+		|| !validSnapshot(header, mapped->data())){
+		throw runtime_error(file + " is damaged");
+	}
+
+	DirectoryTree* tree = new DirectoryTree();
+	tree->nodes.adopt((DirectoryData*)(mapped->data() + header.nodesOffset), header.numNodes);
+	tree->folders.adopt((folderRecord*)(mapped->data() + header.foldersOffset), header.numFolders);
+	tree->linked.adopt((fileSize*)(mapped->data() + header.linkedOffset), header.numNodes);
+	tree->allocated.adopt((fileSize*)(mapped->data() + header.allocatedOffset), header.numNodes);
+	tree->times.adopt((itemTimes*)(mapped->data() + header.timesOffset), header.numNodes);
+	tree->owners.adopt((itemOwner*)(mapped->data() + header.ownersOffset), header.numNodes);
+	tree->modes.adopt((itemMode*)(mapped->data() + header.modesOffset), header.numNodes);
+	tree->agesFrom = header.agesFrom;
+	tree->agesBy = (ageBasis)header.agesBy;
+	tree->agesMode = (sizeMode)header.agesMode;
+	tree->count = (nodeIndex)header.numNodes;
+	tree->folderCount = (folderSlot)header.numFolders;
+	tree->names.adopt(mapped->data() + header.namesOffset, header.namesLength);
+	tree->snapshot = move(mapped);
+	return tree;
+}
+
 /**
- Clear variables, including deallocating all sub-objects stored in vectors
+ Reserve a contiguous range of items. Safe to call from multiple threads.
+ @param num the number of items to reserve
+ @return the index of the first item
  */
-void DirectoryData::resetStats(){
-	   //deallocate each of the files
-	   for (DirectoryData* file : files) {
-		   delete file;
-	   }
-	   //deallocate each of the subfolders
-	   for (DirectoryData* folder : subFolders) {
-		   delete folder;
-	   }
-	   subFolders.clear();
-	   files.clear();
-	   size = 0;
-	   files_size = 0;
-	   num_items = 0;
-   }
+nodeIndex DirectoryTree::allocate(uint32_t num){
+	uint64_t first = count.fetch_add(num);
+	if (first + num >= noNode){
+		throw bad_alloc();
+	}
+	nodes.reserve(first, num);
+	linked.reserve(first, num);
+	allocated.reserve(first, num);
+	times.reserve(first, num);
+	owners.reserve(first, num);
+	modes.reserve(first, num);
+	return (nodeIndex)first;
+}
+
+/**
+ Reserve a contiguous range of folder records. Safe to call from multiple threads.
+ @param num the number of folders
+ @return the slot of the first folder
+ */
+folderSlot DirectoryTree::allocateFolders(uint32_t num){
+	uint64_t first = folderCount.fetch_add(num);
+	if (first + num >= noFolder){
+		throw bad_alloc();
+	}
+	folders.reserve(first, num);
+	return (folderSlot)first;
+}
+
+/**
+ @param item an item in this tree
+ @return the index of the item
+ @note items are found through their parent's range of children, which spans at most a few chunks.
+ Items that are no longer in their parent's range, such as removed items, fall back to a search of every chunk.
+ */
+nodeIndex DirectoryTree::indexOf(const DirectoryData* item) const{
+	if (item->parent == noNode){
+		return item == root() ? 0 : (nodeIndex)nodes.indexOf(item);
+	}
+	const DirectoryData* parent = at(item->parent);
+	if (parent->numChildren() > 0){
+		uint64_t first = parent->firstChild;
+		uint64_t last = first + parent->numChildren() - 1;
+		for (uint64_t start = first - first % nodes.chunkSize; start <= last; start += nodes.chunkSize){
+			const DirectoryData* base = nodes.at(start);
+			if (item >= base && item < base + nodes.chunkSize){
+				uint64_t index = start + (item - base);
+				if (index >= first && index <= last){
+					return (nodeIndex)index;
+				}
+				break;
+			}
+		}
+	}
+	return (nodeIndex)nodes.indexOf(item);
+}
+
+/**
+ @param item an item in this tree
+ @return the item's size, as counted by the tree's size mode
+ */
+fileSize DirectoryTree::sizeOf(const DirectoryData* item) const{
+	switch (mode){
+		case sizeMode::linksOnce:
+			return item->size - *linkedAt(indexOf(item));
+		case sizeMode::allocated:
+			return *allocatedAt(indexOf(item));
+		default:
+			return item->size;
+	}
+}
+
+/**
+ Like sizeOf, for callers that already know the item's index and can skip the search for it
+ @param index the index of an item
+ @return the item's size, as counted by the tree's size mode
+ */
+fileSize DirectoryTree::sizeAt(nodeIndex index) const{
+	switch (mode){
+		case sizeMode::linksOnce:
+			return at(index)->size - *linkedAt(index);
+		case sizeMode::allocated:
+			return *allocatedAt(index);
+		default:
+			return at(index)->size;
+	}
+}
+
+/**
+ @param index the index of a file
+ @return the age bucket of the file, by the tree's age basis, measured from agesFrom
+ */
+size_t DirectoryTree::ageBucketAt(nodeIndex index) const{
+	const itemTimes* t = timesAt(index);
+	int64_t used;
+	switch (agesBy){
+		case ageBasis::modified:
+			used = t->modified;
+			break;
+		case ageBasis::accessed:
+			used = t->accessed;
+			break;
+		default:
+			used = max(t->modified, t->accessed);
+			break;
+	}
+	return ageBuckets::bucketOf(agesFrom - used);
+}
+
+/**
+ @param index the index of an item
+ @return the bytes of the item by age. A folder's are its buckets, a file's are its size in its one bucket.
+ */
+ageBuckets DirectoryTree::agesOf(nodeIndex index) const{
+	if (at(index)->isFolder){
+		return *agesAt(index);
+	}
+	ageBuckets file;
+	file.bytes[ageBucketAt(index)] = sizeAt(index);
+	return file;
+}
+
+/**
+ Apply a change in ages to a folder and all of the folders above it
+ @param index the index of the folder
+ @param change the bytes to add to each bucket
+ @param sign 1 to add the bytes, -1 to remove them
+ */
+void DirectoryTree::addToAges(nodeIndex index, const ageBuckets& change, fileSize sign){
+	for (nodeIndex i = index; i != noNode; i = at(i)->parent){
+		agesAt(i)->add(change, sign);
+	}
+}
+
+/**
+ Count the age buckets of every folder again, after the size mode or age basis changed. Takes one pass over the tree.
+ Ages are still measured from agesFrom.
+ */
+void DirectoryTree::recountAges(){
+	//folders are visited before their contents, and finished after them
+	vector<pair<nodeIndex, bool>> pending{{0, false}};
+	while (pending.size() > 0){
+		auto [index, finished] = pending.back();
+		pending.pop_back();
+		DirectoryData* folder = at(index);
+		ageBuckets* buckets = agesAt(index);
+		if (finished){
+			for (uint32_t i = 0; i < folder->numFolders; i++){
+				buckets->add(*agesAt(folder->firstChild + i));
+			}
+			continue;
+		}
+		*buckets = ageBuckets();
+		if (folder->isSymlink){
+			continue;
+		}
+		for (uint32_t i = folder->numFolders; i < folder->numChildren(); i++){
+			buckets->bytes[ageBucketAt(folder->firstChild + i)] += sizeAt(folder->firstChild + i);
+		}
+		pending.push_back({index, true});
+		for (uint32_t i = 0; i < folder->numFolders; i++){
+			pending.push_back({folder->firstChild + i, false});
+		}
+	}
+	agesMode = mode;
+}
+
+/**
+ @param bucket the index of a bucket
+ @return a description of the ages in the bucket, for display
+ */
+const char* ageBuckets::name(size_t bucket){
+	static const char* names[count] = {"Under a month", "1 to 6 months", "6 months to a year", "1 to 3 years", "Over 3 years"};
+	return names[bucket];
+}
+
+/**
+ @param item an item in this tree
+ @return the folder containing the item, or nullptr for the root
+ */
+DirectoryData* DirectoryTree::parentOf(const DirectoryData* item) const{
+	return item->parent == noNode ? nullptr : at(item->parent);
+}
+
+/**
+ @param folder a folder in this tree
+ @param i the index of the subfolder, less than folder->numFolders
+ @return the subfolder
+ */
+DirectoryData* DirectoryTree::folderOf(const DirectoryData* folder, uint32_t i) const{
+	return at(folder->firstChild + i);
+}
+
+/**
+ @param folder a folder in this tree
+ @param i the index of the file, less than folder->numFiles
+ @return the file
+ */
+DirectoryData* DirectoryTree::fileOf(const DirectoryData* folder, uint32_t i) const{
+	return at(folder->firstChild + folder->numFolders + i);
+}
+
+/**
+ @param item an item in this tree
+ @return the full path to the item
+ */
+string DirectoryTree::pathOf(const DirectoryData* item) const{
+	//collect the names from the item up to the root
+	thread_local vector<const char*> parts;
+	parts.clear();
+	size_t length = 0;
+	for (const DirectoryData* d = item; d != nullptr; d = parentOf(d)){
+		parts.push_back(nameOf(d));
+		length += strlen(parts.back()) + 1;
+	}
+
+	string result;
+	result.reserve(length);
+	for (size_t i = parts.size(); i > 0; i--){
+		//the root may already end in a separator, such as /
+		if (i != parts.size() && (result.size() == 0 || result.back() != path::preferred_separator)){
+			result += (char)path::preferred_separator;
+		}
+		result += parts[i - 1];
+	}
+	return result;
+}
+
+/**
+ Replace the children of a folder. The children are allocated as one contiguous range.
+ Any previous children are left in place, but are no longer reachable.
+ @param index the index of the folder
+ @param childNames buffer containing the null-terminated names of the children
+ @param folders the subfolders to add
+ @param files the files to add
+ @param keepSubfolders true to move the contents and stamp of each previous subfolder to the new subfolder with the same name,
+ so that a rescan can reuse them
+ */
+void DirectoryTree::setChildren(nodeIndex index, const char* childNames, const vector<childItem>& folders, const vector<childItem>& files, bool keepSubfolders){
+	DirectoryData* folder = at(index);
+	nodeIndex oldFirst = folder->firstChild;
+	uint32_t oldFolders = folder->numFolders;
+	uint32_t total = (uint32_t)(folders.size() + files.size());
+	nodeIndex first = noNode;
+	if (total > 0){
+		first = allocate(total);
+		folderSlot firstSlot = folders.size() > 0 ? allocateFolders((uint32_t)folders.size()) : noFolder;
+		
+		//add all the names under one lock
+		thread_local vector<namePool::request> requests;
+		requests.clear();
+		auto request = [&](const childItem& item){
+			const char* name = childNames + item.name;
+			requests.push_back({name, (uint32_t)strlen(name), 0});
+		};
+		for (const childItem& item : folders){
+			request(item);
+		}
+		for (const childItem& item : files){
+			request(item);
+		}
+		names.intern(requests);
+		
+		auto add = [&](nodeIndex i, const childItem& item, bool isFolder){
+			DirectoryData* child = at(i);
+			child->parent = index;
+			child->isFolder = isFolder;
+			child->isSymlink = item.isSymlink;
+			child->size = item.size;
+			child->name = requests[i - first].id;
+			//subfolders come first, so their slots are in the same order
+			child->slot = isFolder ? firstSlot + (i - first) : noFolder;
+			*linkedAt(i) = item.duplicate ? item.size : 0;
+			*allocatedAt(i) = item.allocated;
+			*timesAt(i) = item.times;
+			*ownerAt(i) = item.owner;
+			*modeAt(i) = item.mode;
+			if (isFolder){
+				*agesAt(i) = ageBuckets();
+			}
+		};
+		for (uint32_t i = 0; i < folders.size(); i++){
+			add(first + i, folders[i], true);
+		}
+		for (uint32_t i = 0; i < files.size(); i++){
+			add(first + (uint32_t)folders.size() + i, files[i], false);
+		}
+		
+		if (keepSubfolders && oldFolders > 0 && folders.size() > 0){
+			//names are interned, so equal names have equal ids
+			thread_local unordered_map<nameId, nodeIndex> previous;
+			previous.clear();
+			for (uint32_t i = 0; i < oldFolders; i++){
+				DirectoryData* sub = at(oldFirst + i);
+				if (!sub->isSymlink){
+					previous[sub->name] = oldFirst + i;
+				}
+			}
+			for (uint32_t i = 0; i < folders.size(); i++){
+				DirectoryData* sub = at(first + i);
+				auto found = previous.find(sub->name);
+				if (!sub->isSymlink && found != previous.end()){
+					moveContents(found->second, first + i);
+				}
+			}
+		}
+	}
+	this->folders.at(folder->slot)->capacity = total;
+	//publish the children once they are filled in
+	folder->firstChild = first;
+	folder->numFolders = (uint32_t)folders.size();
+	folder->numFiles = (uint32_t)files.size();
+}
+
+/**
+ Move a folder's contents, totals and stamp to another folder
+ @param from the folder to move from, which is left empty
+ @param to the folder to move to
+ */
+void DirectoryTree::moveContents(nodeIndex from, nodeIndex to){
+	DirectoryData* source = at(from);
+	DirectoryData* dest = at(to);
+	dest->firstChild = source->firstChild;
+	dest->numFolders = source->numFolders;
+	dest->numFiles = source->numFiles;
+	dest->files_size = source->files_size;
+	dest->size = source->size;
+	dest->num_items = source->num_items;
+	*stampAt(to) = *stampAt(from);
+	*linkedAt(to) = *linkedAt(from);
+	*allocatedAt(to) = *allocatedAt(from);
+	*agesAt(to) = *agesAt(from);
+	folders.at(dest->slot)->capacity = folders.at(source->slot)->capacity;
+	folders.at(source->slot)->capacity = 0;
+	for (uint32_t i = 0; i < dest->numChildren(); i++){
+		at(dest->firstChild + i)->parent = to;
+	}
+	source->firstChild = noNode;
+	source->numFolders = 0;
+	source->numFiles = 0;
+}
+
+/**
+ @param index the index of a folder
+ @param name the name of the child to find
+ @return the index of the child with that name, or noNode
+ */
+nodeIndex DirectoryTree::findChild(nodeIndex index, const char* name) const{
+	DirectoryData* folder = at(index);
+	for (uint32_t i = 0; i < folder->numChildren(); i++){
+		if (strcmp(nameOf(at(folder->firstChild + i)), name) == 0){
+			return folder->firstChild + i;
+		}
+	}
+	return noNode;
+}
+
+/**
+ Find an item from its full path
+ @param itemPath the path to the item
+ @return the index of the item, or noNode if the path is not in the tree
+ */
+nodeIndex DirectoryTree::findPath(const string& itemPath) const{
+	path rootPath(nameOf(root()));
+	path relative = path(itemPath).lexically_relative(rootPath);
+	if (relative.empty() || *relative.begin() == ".."){
+		return noNode;
+	}
+	nodeIndex current = 0;
+	for (const path& part : relative){
+		if (part == "."){
+			continue;
+		}
+		current = findChild(current, part.string().c_str());
+		if (current == noNode){
+			return noNode;
+		}
+	}
+	return current;
+}
+
+/**
+ @param index the index of a folder
+ @return the number of items reserved for the folder's children, at least the number of children
+ */
+uint32_t DirectoryTree::capacityOf(nodeIndex index) const{
+	return max(folders.at(at(index)->slot)->capacity, at(index)->numChildren());
+}
+
+/**
+ Take a range of items for a folder's children, reusing a released range if one is large enough
+ @param num the number of items
+ @return the index of the first item
+ */
+nodeIndex DirectoryTree::takeRange(uint32_t num){
+	auto found = freeRanges.lower_bound(num);
+	if (found == freeRanges.end()){
+		return allocate(num);
+	}
+	uint32_t length = found->first;
+	nodeIndex first = found->second;
+	freeRanges.erase(found);
+	//the rest of a larger range stays available
+	if (length > num){
+		freeRanges.insert({length - num, first + num});
+	}
+	return first;
+}
+
+/**
+ Give a folder's range of children back for reuse, along with everything below them
+ @param index the index of the folder, which is left empty
+ @param moved receives each released item, with noNode as its new index
+ */
+void DirectoryTree::releaseContents(nodeIndex index, movedList& moved){
+	vector<nodeIndex> pending{index};
+	while (pending.size() > 0){
+		nodeIndex current = pending.back();
+		pending.pop_back();
+		DirectoryData* folder = at(current);
+		folderRecord* record = folders.at(folder->slot);
+		uint32_t capacity = max(record->capacity, folder->numChildren());
+		for (uint32_t i = 0; i < folder->numChildren(); i++){
+			nodeIndex child = folder->firstChild + i;
+			moved.push_back({child, noNode});
+			if (at(child)->isFolder){
+				pending.push_back(child);
+			}
+		}
+		if (capacity > 0 && folder->firstChild != noNode){
+			freeRanges.insert({capacity, folder->firstChild});
+		}
+		//the folder itself is released by its parent
+		if (current != index){
+			freeSlots.push_back(folder->slot);
+		}
+		folder->firstChild = noNode;
+		folder->numFolders = 0;
+		folder->numFiles = 0;
+		record->capacity = 0;
+	}
+}
+
+/**
+ Move an item to an unused index in the same tree. A folder keeps its record and its children, which are pointed at the new index.
+ @param from the item to move
+ @param to the index to move it to
+ @param moved receives the move
+ */
+void DirectoryTree::relocate(nodeIndex from, nodeIndex to, movedList& moved){
+	DirectoryData* dest = at(to);
+	*dest = *at(from);
+	*linkedAt(to) = *linkedAt(from);
+	*allocatedAt(to) = *allocatedAt(from);
+	*timesAt(to) = *timesAt(from);
+	*ownerAt(to) = *ownerAt(from);
+	*modeAt(to) = *modeAt(from);
+	if (dest->isFolder){
+		for (uint32_t i = 0; i < dest->numChildren(); i++){
+			at(dest->firstChild + i)->parent = to;
+		}
+	}
+	moved.push_back({from, to});
+}
+
+/**
+ Add a single child to a folder. The child is added in place when the folder's range has room. Otherwise the children
+ move to a range twice as large, so that a folder that keeps changing is only moved a few times.
+ @param index the index of the folder
+ @param name the name of the new child
+ @param isFolder true if the child is a folder, which is added without contents
+ @param size the size of the child
+ @param moved receives the items that moved
+ @return the index of the new child
+ @note does not update the totals of the folder or its parents, see addToTotals
+ */
+nodeIndex DirectoryTree::addChild(nodeIndex index, const string& name, bool isFolder, fileSize size, movedList& moved){
+	DirectoryData* folder = at(index);
+	uint32_t total = folder->numChildren();
+	uint32_t capacity = capacityOf(index);
+	if (total == capacity){
+		uint32_t grown = 4;
+		while (grown <= total){
+			grown *= 2;
+		}
+		nodeIndex first = takeRange(grown);
+		for (uint32_t i = 0; i < total; i++){
+			relocate(folder->firstChild + i, first + i, moved);
+		}
+		if (capacity > 0){
+			freeRanges.insert({capacity, folder->firstChild});
+		}
+		folder->firstChild = first;
+		folders.at(folder->slot)->capacity = grown;
+	}
+
+	//subfolders come before files, so a new subfolder takes the place of the first file, which moves to the end
+	nodeIndex added = folder->firstChild + total;
+	if (isFolder){
+		added = folder->firstChild + folder->numFolders;
+		if (folder->numFiles > 0){
+			relocate(added, folder->firstChild + total, moved);
+		}
+		folder->numFolders++;
+	}
+	else{
+		folder->numFiles++;
+	}
+	DirectoryData* dest = at(added);
+	*dest = DirectoryData();
+	dest->parent = index;
+	dest->name = names.intern(name);
+	dest->isFolder = isFolder;
+	dest->size = size;
+	*linkedAt(added) = 0;
+	*allocatedAt(added) = 0;
+	*timesAt(added) = itemTimes();
+	*ownerAt(added) = itemOwner();
+	*modeAt(added) = itemMode();
+	if (isFolder){
+		if (freeSlots.size() > 0){
+			dest->slot = freeSlots.back();
+			freeSlots.pop_back();
+		}
+		else{
+			dest->slot = allocateFolders(1);
+		}
+		folderRecord* record = folders.at(dest->slot);
+		record->stamp = folderStamp();
+		record->ages = ageBuckets();
+		record->capacity = 0;
+	}
+	return added;
+}
+
+/**
+ Remove a single child from a folder, along with everything below it. The last child of the same kind takes its place,
+ so the folder's other children stay where they are and nothing is allocated.
+ @param index the index of the folder
+ @param child the index of the child to remove
+ @param moved receives the items that moved, and each removed item with noNode as its new index
+ @note does not update the totals of the folder or its parents, see addToTotals
+ */
+void DirectoryTree::removeChild(nodeIndex index, nodeIndex child, movedList& moved){
+	DirectoryData* folder = at(index);
+	nodeIndex last = folder->firstChild + folder->numChildren() - 1;
+	if (at(child)->isFolder){
+		releaseContents(child, moved);
+		freeSlots.push_back(at(child)->slot);
+		moved.push_back({child, noNode});
+		nodeIndex lastFolder = folder->firstChild + folder->numFolders - 1;
+		if (child != lastFolder){
+			relocate(lastFolder, child, moved);
+		}
+		//the last file fills the gap the subfolders left
+		if (folder->numFiles > 0){
+			relocate(last, lastFolder, moved);
+		}
+		folder->numFolders--;
+	}
+	else{
+		moved.push_back({child, noNode});
+		if (child != last){
+			relocate(last, child, moved);
+		}
+		folder->numFiles--;
+	}
+}
+
+/**
+ Apply a change in size to a folder and all of the folders above it
+ @param index the index of the folder
+ @param bytes the number of bytes added, negative if removed
+ @param items the number of items added, negative if removed
+ @param linkedBytes the change in bytes that belong to hard links counted elsewhere
+ @param allocatedBytes the change in bytes taken on disk
+ */
+void DirectoryTree::addToTotals(nodeIndex index, fileSize bytes, int64_t items, fileSize linkedBytes, fileSize allocatedBytes){
+	for (nodeIndex i = index; i != noNode; i = at(i)->parent){
+		DirectoryData* d = at(i);
+		d->size += bytes;
+		d->num_items = (uint32_t)(d->num_items + items);
+		*linkedAt(i) += linkedBytes;
+		*allocatedAt(i) += allocatedBytes;
+	}
+}
+
+/**
+ Clear a folder's totals and stamp, and detach its children. The children's storage is released when the tree is destroyed.
+ @param folder the folder to reset
+ */
+void DirectoryTree::resetStats(DirectoryData* folder){
+	nodeIndex index = indexOf(folder);
+	*stampAt(index) = folderStamp();
+	*linkedAt(index) = 0;
+	*allocatedAt(index) = 0;
+	*agesAt(index) = ageBuckets();
+	folders.at(folder->slot)->capacity = 0;
+	folder->firstChild = noNode;
+	folder->numFolders = 0;
+	folder->numFiles = 0;
+	folder->size = 0;
+	folder->files_size = 0;
+	folder->num_items = 0;
+}
 
 /**
  Back-propagate changes made to child objects anywhere in the hierarchy into the parent object
- Does not make filesystem calls, instead uses only the data in the FolderData struct.
- Modifies the properties of the struct.
+ Does not make filesystem calls, instead uses only the data in the tree.
+ Modifies the properties of the item.
+ @param folder the folder to recalculate
  */
-void DirectoryData::recalculateStats(){
-	if (subFolders.size() > 0){
-		num_items = files.size();
+void DirectoryTree::recalculateStats(DirectoryData* folder){
+	if (folder->numFolders > 0){
+		folder->num_items = folder->numFiles;
 		//calculate file size
-		files_size = 1;
-		for (DirectoryData* file : files){
-			files_size += file->size;
+		folder->files_size = 1;
+		for (uint32_t i = 0; i < folder->numFiles; i++){
+			folder->files_size += fileOf(folder, i)->size;
 		}
-		size = files_size;
-		
-		for(DirectoryData* sub : subFolders){
-			//error handle
-			if (sub == nullptr) {continue;}
-			sub->recalculateStats();
-			num_items += sub->num_items + 1;
-			size += sub->size;
-			files_size += sub->files_size;
+		folder->size = folder->files_size;
+
+		for (uint32_t i = 0; i < folder->numFolders; i++){
+			DirectoryData* sub = folderOf(folder, i);
+			recalculateStats(sub);
+			folder->num_items += sub->num_items + 1;
+			folder->size += sub->size;
+			folder->files_size += sub->files_size;
 		}
 	}
 }
 
 /**
 Find all the single super-items on this tree for this node
+@param item the item to start from
 @returns vector of all the pointers that make up a single chain to data
 */
-vector<DirectoryData*> DirectoryData::getSuperFolders(){
+vector<DirectoryData*> DirectoryTree::getSuperFolders(const DirectoryData* item) const{
 	vector<DirectoryData*> folders;
-	//recursively advance up the hierarchy
-	function<DirectoryData*(DirectoryData*)> recurse = [&](DirectoryData* d) -> DirectoryData* {
-		if (d->parent != nullptr){
-			folders.push_back((DirectoryData*)d->parent);
-			return recurse((DirectoryData*)d->parent);
-		}
-		else{
-			return d;
-		}
-	};
-	recurse(this);
-	
+	for (DirectoryData* d = parentOf(item); d != nullptr; d = parentOf(d)){
+		folders.push_back(d);
+	}
 	return folders;
 }
 
 /**
-Return a string representing the item's % size of the superitem
-@returns size rounded to 1 decimal place e.g (5.2%)
+Return the item's % size of the superitem
+@param item the item to compare to its parent
+@returns size as a percentage, or 100 for the root
 */
-long double DirectoryData::percentOfParent(){
-//	if (parent == nullptr){return "[waiting]";}
-//	//round to 2 decimal places, then attach unit
-//	char buffer[10];
-//	sprintf(buffer,"%.1Lf",(long double)size / (long double)parent->size * 100);
-//	return string(buffer) + "%";
-	
-	return (long double)size / (long double)parent->size * 100;
+long double DirectoryTree::percentOfParent(const DirectoryData* item) const{
+	DirectoryData* parent = parentOf(item);
+	if (parent == nullptr){
+		return 100;
+	}
+	//a folder of sparse or empty files may take no space
+	fileSize parentSize = sizeOf(parent);
+	if (parentSize <= 0){
+		return 0;
+	}
+	return (long double)sizeOf(item) / (long double)parentSize * 100;
 }
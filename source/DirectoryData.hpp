@@ -6,44 +6,364 @@
 //
 
 #pragma once
-#include "globals.h"
+#include "platform.h"
+#include "arena.hpp"
+#include "name_pool.hpp"
+#include "mapped_file.hpp"
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
 using namespace std;
 
+//position of an item in a DirectoryTree
+typedef uint32_t nodeIndex;
+static constexpr nodeIndex noNode = UINT32_MAX;
+//position of a folder's record in a DirectoryTree's table of folders
+typedef uint32_t folderSlot;
+static constexpr folderSlot noFolder = UINT32_MAX;
+
+/**
+ A single file or folder. Items live in a DirectoryTree and refer to each other by index.
+ A folder's children are stored contiguously: its subfolders first, then its files.
+ */
 class DirectoryData{
 public:
-	string Path;
 	//see typedefs for platform-specific types
-	fileSize size;
-	fileSize files_size;
-	unsigned long num_items;
-	bool isFolder;
-	bool isSymlink;
-	
+	fileSize size = 0;
+	fileSize files_size = 0;
+	//the item's own name in the tree's name pool. For the root, this is the full path.
+	nameId name = 0;
+
 	//for back navigation
-	DirectoryData* parent = nullptr;
-	
+	nodeIndex parent = noNode;
+
 	//for holding items
-	vector<DirectoryData*> subFolders;
-	vector<DirectoryData*> files;
-	
-	DirectoryData(const string& inPath, bool folder){
-		Path = inPath;
-		isFolder = folder;
-		size = 0;
-		files_size = 1;
-		num_items = 0;
-		isSymlink = false;
-	}
-	DirectoryData(const string& inPath, fileSize inSize) : DirectoryData(inPath, false){
-		size = inSize;
-	}
-	//destructor
-	~DirectoryData(){
-		resetStats();
-	}
-	
-	void resetStats();
-	void recalculateStats();
-	vector<DirectoryData*> getSuperFolders();
-	long double percentOfParent();
+	nodeIndex firstChild = noNode;
+	uint32_t numFolders = 0;
+	uint32_t numFiles = 0;
+	uint32_t num_items = 0;
+
+	//the folder's record in the tree's table of folders, noFolder for files
+	folderSlot slot = noFolder;
+	bool isFolder = false;
+	bool isSymlink = false;
+
+	uint32_t numChildren() const{
+		return numFolders + numFiles;
+	}
+};
+
+/**
+ Identifies the state of a folder's entries when it was last read. Any change to the entries
+ (adding, removing or renaming an item) changes the folder's modification and change times.
+ */
+struct folderStamp{
+	int64_t mtime = 0;
+	int64_t ctime = 0;
+	uint64_t inode = 0;
+	uint64_t device = 0;
+
+	/**
+	 @return true if the stamp was recorded when the folder was read
+	 */
+	bool valid() const{
+		return inode != 0 || ctime != 0;
+	}
+	bool operator==(const folderStamp& other) const{
+		return mtime == other.mtime && ctime == other.ctime && inode == other.inode && device == other.device;
+	}
+};
+
+/**
+ The times of an item, in seconds since the epoch, kept from the stat that sized it
+ */
+struct itemTimes{
+	int64_t modified = 0;
+	int64_t accessed = 0;
+	//when the item's metadata last changed, or when it was created on Windows
+	int64_t changed = 0;
+};
+
+/**
+ The user and group that own an item, kept from the stat that sized it. Both are 0 where the platform has no owners.
+ */
+struct itemOwner{
+	uint32_t user = 0;
+	uint32_t group = 0;
+};
+
+/**
+ The type and permissions of an item, and its number of hard links, kept from the stat that sized it
+ */
+struct itemMode{
+	//st_mode, 0 if the item was never stat'ed
+	uint32_t mode = 0;
+	uint32_t links = 0;
+
+	/**
+	 @return true if the mode was read when the item was sized
+	 */
+	bool known() const{
+		return mode != 0;
+	}
+	bool operator==(const itemMode& other) const{
+		return mode == other.mode && links == other.links;
+	}
+};
+
+/**
+ The bytes below a folder, split by how long ago each file was last used
+ */
+struct ageBuckets{
+	static constexpr size_t count = 5;
+	//the youngest age, in seconds, of each bucket after the first. Files from the future are counted in the first.
+	static constexpr int64_t bounds[count - 1] = {30 * 86400, 182 * 86400, 365 * 86400, 3 * 365 * 86400};
+	fileSize bytes[count] = {};
+
+	/**
+	 @param age the seconds since a file was last used
+	 @return the bucket the file belongs in
+	 */
+	static size_t bucketOf(int64_t age){
+		size_t bucket = 0;
+		while (bucket < count - 1 && age >= bounds[bucket]){
+			bucket++;
+		}
+		return bucket;
+	}
+	static const char* name(size_t);
+
+	/**
+	 Add or remove the bytes of other buckets
+	 @param other the buckets to add
+	 @param sign 1 to add, -1 to remove
+	 */
+	void add(const ageBuckets& other, fileSize sign = 1){
+		for (size_t i = 0; i < count; i++){
+			bytes[i] += sign * other.bytes[i];
+		}
+	}
+	/**
+	 @param bucket the youngest bucket to count
+	 @return the bytes in that bucket and every older one
+	 */
+	fileSize from(size_t bucket) const{
+		fileSize total = 0;
+		for (size_t i = bucket; i < count; i++){
+			total += bytes[i];
+		}
+		return total;
+	}
+};
+
+/**
+ What a tree keeps for folders only. Records are stored in their own table, reached through each folder's slot,
+ so that files do not pay for them.
+ */
+struct folderRecord{
+	folderStamp stamp;
+	//the bytes of the files below the folder, by age
+	ageBuckets ages;
+	//the items reserved for the folder's children, which may be more than it has so that the watcher can add to them in place
+	uint32_t capacity = 0;
+	//number of subfolders still being sized, plus one while the folder's own files are sized
+	atomic<uint32_t> pendingChildren{0};
+};
+
+/**
+ Owns the items of a sized folder. Items and their names are allocated in large chunks and
+ freed all at once, so building or discarding a tree does not cost an allocation per item.
+ Items only store their own name. Full paths are rebuilt from the chain of parents when needed.
+ A tree can be saved as a snapshot file and loaded again by mapping the file, without reading every item.
+ The root is always at index 0.
+ */
+class DirectoryTree{
+public:
+	/**
+	 Description of a child to add with setChildren
+	 */
+	struct childItem{
+		//offset of the item's name in the names buffer passed to setChildren
+		size_t name = 0;
+		fileSize size = 0;
+		bool isSymlink = false;
+		//a hard link to a file that was already counted elsewhere in the same sizing
+		bool duplicate = false;
+		//the bytes the item takes on disk, 0 for a duplicate
+		fileSize allocated = 0;
+		itemTimes times = {};
+		itemOwner owner = {};
+		itemMode mode = {};
+	};
+
+	/**
+	 How the sizes of items are reported by sizeOf
+	 */
+	enum class sizeMode{
+		//the sum of the sizes of every entry, counting hard-linked files once per link
+		apparent,
+		//hard-linked files are counted once, at the first link found
+		linksOnce,
+		//the bytes the items take on disk, including the folders themselves, with hard-linked files counted once
+		allocated
+	};
+	sizeMode mode = sizeMode::apparent;
+
+	/**
+	 Which of a file's times decides its age
+	 */
+	enum class ageBasis : uint8_t{
+		modified,
+		accessed,
+		//the later of the two, so a file counts as used if it was either read or written
+		used
+	};
+	ageBasis agesBy = ageBasis::used;
+	//the time ages are measured from, in seconds since the epoch. Set when the root is sized.
+	int64_t agesFrom = 0;
+	//the size mode the age buckets were counted in, see recountAges
+	sizeMode agesMode = sizeMode::apparent;
+
+	DirectoryTree(const string& rootPath);
+	static DirectoryTree* load(const string&);
+	void save(const string&) const;
+
+	DirectoryData* root() const{
+		return at(0);
+	}
+	/**
+	 @param index the index of the item
+	 @return the item at that index
+	 */
+	DirectoryData* at(nodeIndex index) const{
+		return nodes.at(index);
+	}
+	/**
+	 @return the number of items in the tree, including any that were replaced by reloading a folder
+	 */
+	size_t size() const{
+		return count;
+	}
+
+	nodeIndex indexOf(const DirectoryData*) const;
+	DirectoryData* parentOf(const DirectoryData*) const;
+	DirectoryData* folderOf(const DirectoryData*, uint32_t) const;
+	DirectoryData* fileOf(const DirectoryData*, uint32_t) const;
+	/**
+	 @param item an item in this tree
+	 @return the item's name, or the full path for the root
+	 */
+	const char* nameOf(const DirectoryData* item) const{
+		return names.at(item->name);
+	}
+	string pathOf(const DirectoryData*) const;
+	/**
+	 @param index the index of a folder
+	 @return the folder's stamp, which is not valid until the folder has been read
+	 */
+	folderStamp* stampAt(nodeIndex index) const{
+		return &folders.at(at(index)->slot)->stamp;
+	}
+	/**
+	 @param index the index of a folder
+	 @return the number of the folder's subfolders still being sized, used by the sizer
+	 */
+	atomic<uint32_t>* pendingAt(nodeIndex index) const{
+		return &folders.at(at(index)->slot)->pendingChildren;
+	}
+	/**
+	 @param index the index of an item
+	 @return the bytes in the item's size that belong to hard links counted elsewhere.
+	 For a file this is its size or 0, for a folder it is the sum of its contents.
+	 */
+	fileSize* linkedAt(nodeIndex index) const{
+		return linked.at(index);
+	}
+	/**
+	 @param index the index of an item
+	 @return the bytes the item takes on disk. For a folder this includes its contents and its own entries.
+	 */
+	fileSize* allocatedAt(nodeIndex index) const{
+		return allocated.at(index);
+	}
+	/**
+	 @param index the index of an item
+	 @return the item's times. For a folder these are the folder's own times, not those of its contents.
+	 */
+	itemTimes* timesAt(nodeIndex index) const{
+		return times.at(index);
+	}
+	/**
+	 @param index the index of an item
+	 @return the item's owner. For a folder this is the folder's own owner, not the owners of its contents.
+	 */
+	itemOwner* ownerAt(nodeIndex index) const{
+		return owners.at(index);
+	}
+	/**
+	 @param index the index of an item
+	 @return the item's type, permissions and link count
+	 */
+	itemMode* modeAt(nodeIndex index) const{
+		return modes.at(index);
+	}
+	/**
+	 @param index the index of a folder
+	 @return the bytes of the files below the folder, by age, counted in agesMode. Not used for files, see agesOf.
+	 */
+	ageBuckets* agesAt(nodeIndex index) const{
+		return &folders.at(at(index)->slot)->ages;
+	}
+	fileSize sizeOf(const DirectoryData*) const;
+	fileSize sizeAt(nodeIndex) const;
+	size_t ageBucketAt(nodeIndex) const;
+	ageBuckets agesOf(nodeIndex) const;
+	void addToAges(nodeIndex, const ageBuckets&, fileSize sign = 1);
+	void recountAges();
+
+	void setChildren(nodeIndex, const char*, const vector<childItem>&, const vector<childItem>&, bool keepSubfolders = false);
+
+	//items that moved to a new index as (old, new), or were removed as (old, noNode), in the order it happened
+	typedef vector<pair<nodeIndex, nodeIndex>> movedList;
+	nodeIndex findChild(nodeIndex, const char*) const;
+	nodeIndex findPath(const string&) const;
+	nodeIndex addChild(nodeIndex, const string&, bool isFolder, fileSize, movedList&);
+	void removeChild(nodeIndex, nodeIndex, movedList&);
+	void addToTotals(nodeIndex, fileSize, int64_t, fileSize linkedBytes = 0, fileSize allocatedBytes = 0);
+	void resetStats(DirectoryData*);
+	void recalculateStats(DirectoryData*);
+	vector<DirectoryData*> getSuperFolders(const DirectoryData*) const;
+	long double percentOfParent(const DirectoryData*) const;
+
+private:
+	//the snapshot the tree was loaded from, if any. The arenas borrow its pages.
+	unique_ptr<mappedFile> snapshot;
+
+	chunkArena<DirectoryData, 16> nodes;
+	//indexed by each folder's slot
+	chunkArena<folderRecord, 16> folders;
+	atomic<folderSlot> folderCount{0};
+	//kept beside the items rather than in them, so that the items stay small
+	chunkArena<fileSize, 16> linked;
+	chunkArena<fileSize, 16> allocated;
+	chunkArena<itemTimes, 16> times;
+	chunkArena<itemOwner, 16> owners;
+	chunkArena<itemMode, 16> modes;
+	atomic<nodeIndex> count{0};
+	//ranges of items released by the watcher, by length, and the slots of removed folders. Only used while not sizing.
+	multimap<uint32_t, nodeIndex> freeRanges;
+	vector<folderSlot> freeSlots;
+
+	namePool names;
+
+	DirectoryTree(){}
+	nodeIndex allocate(uint32_t);
+	folderSlot allocateFolders(uint32_t);
+	void moveContents(nodeIndex, nodeIndex);
+	uint32_t capacityOf(nodeIndex) const;
+	nodeIndex takeRange(uint32_t);
+	void releaseContents(nodeIndex, movedList&);
+	void relocate(nodeIndex, nodeIndex, movedList&);
 };
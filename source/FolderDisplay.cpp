@@ -6,13 +6,13 @@
 //
 
 #include "FolderDisplay.hpp"
-#include <array>
 #include <thread>
 
 wxBEGIN_EVENT_TABLE(FolderDisplay, wxPanel)
 EVT_DATAVIEW_SELECTION_CHANGED(FDISP, FolderDisplay::OnSelectionChanged)
 EVT_DATAVIEW_ITEM_ACTIVATED(FDISP, FolderDisplay::OnSelectionActivated)
-EVT_COMMAND(PROGEVT, progEvt, FolderDisplay::OnUpdateUI)
+EVT_DATAVIEW_COLUMN_SORTED(FDISP, FolderDisplay::OnColumnSorted)
+EVT_TIMER(wxID_ANY, FolderDisplay::OnProgressTimer)
 wxEND_EVENT_TABLE()
 
 using namespace std;
@@ -22,12 +22,27 @@ using namespace std::filesystem;
  Constructs a FolderDisplay given an event parent and a model
  @param parentWindow the parent wxWindow
  @param eventWindow the wxWindow to send events to
+ @param contentsTree the tree that owns the contents
  @param contents the FolderData to represent in this FolderDisplay
  @note Must call display() to display the contents (or update them)
  */
-FolderDisplay::FolderDisplay(wxWindow* parentWindow, wxWindow* eventWindow, DirectoryData* contents) : FolderDisplayBase(parentWindow){
+FolderDisplay::FolderDisplay(wxWindow* parentWindow, wxWindow* eventWindow, DirectoryTree* contentsTree, DirectoryData* contents) : FolderDisplayBase(parentWindow), progressTimer(this){
 	eventManager = eventWindow;
+	tree = contentsTree;
 	data = contents;
+	model = new FolderModel(tree, data);
+	ListCtrl->AssociateModel(model);
+	model->DecRef();
+}
+
+/**
+ Stops any sizing in progress, and waits for it to finish before the display goes away
+ */
+FolderDisplay::~FolderDisplay(){
+	if (worker.joinable()){
+		sizer.control.cancel();
+		worker.join();
+	}
 }
 
 /**
@@ -35,12 +50,15 @@ Activated when the selection in the view is changed
 @param event the event raised by the dataview
 */
 void FolderDisplay::OnSelectionChanged(wxDataViewEvent& event){
-	//notify parent to update sidebar display
-	wxCommandEvent* evt = new wxCommandEvent(progEvt, SELEVT);
-	//pass along the address to the DirectoryData to the event
-	uintptr_t* addr = new uintptr_t((ListCtrl->GetItemData(event.GetItem())));
-	evt->SetClientData(addr);
-	eventManager->GetEventHandler()->QueueEvent(evt);
+	DirectoryData* item = model->ItemAt(event.GetItem());
+	if (item != nullptr){
+		//notify parent to update sidebar display
+		wxCommandEvent* evt = new wxCommandEvent(progEvt, SELEVT);
+		//pass along the address to the DirectoryData to the event
+		uintptr_t* addr = new uintptr_t((uintptr_t)item);
+		evt->SetClientData(addr);
+		eventManager->GetEventHandler()->QueueEvent(evt);
+	}
 	event.Skip();
 }
 
@@ -50,9 +68,9 @@ Activated when the selection in the view is activated (double clicked or enter p
 */
 void FolderDisplay::OnSelectionActivated(wxDataViewEvent& event){
 	wxCommandEvent* evt = new wxCommandEvent(progEvt, ACTEVT);
-	auto item = event.GetItem();
+	DirectoryData* item = model->ItemAt(event.GetItem());
 	if (item != nullptr){
-		uintptr_t* addr = new uintptr_t((ListCtrl->GetItemData(item)));
+		uintptr_t* addr = new uintptr_t((uintptr_t)item);
 		evt->SetClientData(addr);
 		eventManager->GetEventHandler()->QueueEvent(evt);
 	}
@@ -60,220 +78,129 @@ void FolderDisplay::OnSelectionActivated(wxDataViewEvent& event){
 	event.Skip();
 }
 
+/**
+Activated when a column header is clicked to sort the view
+@param event the event raised by the dataview
+*/
+void FolderDisplay::OnColumnSorted(wxDataViewEvent& event){
+	//the model is virtual, so it orders the rows itself
+	wxDataViewColumn* column = ListCtrl->GetSortingColumn();
+	if (column != nullptr){
+		model->SortBySize(column->IsSortOrderAscending());
+	}
+	event.Skip();
+}
+
 /**
  Displays the items in the DirectoryData in the data grid
  @pre data must not be nullptr
  */
 void FolderDisplay::display(){
-	ItemName->SetLabel(path(data->Path).filename().string() + " - " + sizeToString(data->size));
-	auto addItems = [&](vector<DirectoryData*>& list){
-		for (DirectoryData* folder : list){
-			AddItem(folder);
-		}
-	};
-	addItems(data->subFolders);
-	addItems(data->files);
+	ItemName->SetLabel(path(tree->pathOf(data)).filename().string() + " - " + sizeToString(tree->sizeOf(data)));
+	model->SetFolder(tree, data);
+	model->ShowAll();
 }
 
 /**
- Add an item to the display
- @param folder the item to add to the display
+ Size the model representing this display on a background thread
+ @param callback the function to call for progress updates. Called on the main thread at a fixed rate while sizing, and once more when sizing finishes.
+ @param limits which folders to enter
+ @param incremental true to only read the folders that changed since they were last sized
  */
-void FolderDisplay::AddItem(DirectoryData* folder){
-	//no parent set? use the current associated model as the parent
-	if (folder->parent == nullptr){
-		folder->parent = data;
+void FolderDisplay::Size(const progCallback& callback, const scanLimits& limits, bool incremental){
+	//a previous sizing must finish before the tree is changed again
+	Stop();
+	//reset items
+	model->SetFolder(tree, data);
+	sizer.control.reset();
+	progressCallback = callback;
+	finished.clear();
+	sizing = true;
+	
+	//reset / deallocate
+	sizer.incremental = incremental;
+	sizer.limits = limits;
+	if (!incremental){
+		tree->resetStats(data);
 	}
-	wxVector<wxVariant> items(3);
-	path p = path(folder->Path);
-	items[0] = iconForExtension(folder) + p.filename().string();
-	items[1] = wxAny((long)(folder->percentOfParent()));
-	items[2] = sizeToString(folder->size);
-	//store the address that the pointer is referencing as the client data for the item
-	//wxUIntPtr clientdata((uintptr_t)(folder));
-	ListCtrl->AppendItem(items,(uintptr_t)(folder));
+	//clear the previous run's progress before the timer can see it
+	sizer.progress.reset();
+	
+	nodeIndex index = tree->indexOf(data);
+	worker = thread([=](){
+		auto logcallback = [&](const string& msg){
+			Log(msg);
+		};
+		sizer.Size(tree, index, logcallback);
+	});
+	progressTimer.Start(progressInterval);
 }
 
 /**
- Formats a raw file size to a string with a unit
- @param fileSize the size of the item in bytes
- @returns unitized string, example "12 KB"
+ Stop sizing, and wait for the workers to finish the folders they started. Folders that were not read
+ are left without contents, and without a stamp so that an incremental rescan reads them.
+ The display then shows the partial sizes, and the progress callback is called as if sizing had finished.
  */
-string FolderDisplay::sizeToString(const fileSize& fileSize){
-	string formatted = "";
-	int size = 1000;		//MB = 1000, MiB = 1024
-	array<string,5> suffix { " bytes", " KB", " MB", " GB", " TB" };
-
-	for (int i = 0; i < suffix.size(); i++)
-	{
-		double compare = pow(size, i);
-		if (fileSize <= compare)
-		{
-			int minus = 0;
-			if (i > 0)
-			{
-				minus = 1;
-			}
-			//round to 2 decimal places, then attach unit
-			char buffer[10];
-			sprintf(buffer,"%.2f",fileSize / pow(size,i-minus));
-			formatted = string(buffer) + suffix[i - minus];
-			break;
-		}
+void FolderDisplay::Stop(){
+	if (!worker.joinable()){
+		return;
+	}
+	sizer.control.cancel();
+	worker.join();
+	if (sizing){
+		UpdateProgress();
 	}
-
-	return formatted;
 }
 
 /**
- Calculate the size of a folder, including the size of subfolders
- @param folder the path to the folder to size
- @param progress the std::function to call with progress updates
+ Pause or resume sizing. While paused, workers finish the folder they are reading and wait before the next,
+ and everything sized so far stays in the tree.
+ @param paused true to pause, false to resume
  */
-DirectoryData* FolderDisplay::SizeItem(const string& folder, const progCallback& progress){
-	DirectoryData* fd = new DirectoryData(folder, true);
-	
-	if (abort || path_too_long(folder)) {
-		return fd;
-	}
-	
-	//skip symbolic links
-	std::error_code ec;
-	if (is_symlink(path(folder),ec)){
-		fd->size = 1;
-		fd->isSymlink = true;
-		return fd;
+void FolderDisplay::SetPaused(bool paused){
+	if (paused){
+		sizer.control.pause();
 	}
-	
-	//calculate the size of the immediate files in the folder
-	try{
-		sizeImmediate(fd);
-	}
-	catch(filesystem_error e){
-		//notify user
-		Log("Error sizing directory" + folder + "\n" + e.what());
-		return fd;
-	}
-	
-	fd->size = fd->files_size;
-	fd->num_items = fd->files.size();
-	
-	//recursively size the folders in the folder
-	for (int i = 0; i < fd->subFolders.size(); i++){
-		fd->subFolders[i] = SizeItem(fd->subFolders[i]->Path, nullptr);
-		
-		//update parent
-		if (fd->subFolders[i] != nullptr){
-			fd->subFolders[i]->parent = fd;
-			fd->num_items += fd->subFolders[i]->num_items + 1;
-			fd->size += fd->subFolders[i]->size;
-			//check for zero size
-			if (fd->size == 0){
-				fd->size = 1;
-			}
-		}
-		if (progress != nullptr) {
-			progress((float)(i + 1) / fd->subFolders.size(), fd);
-		}
+	else{
+		sizer.control.resume();
 	}
-
-	return fd;
 }
 
 /**
- Calculate the size of the immediate files in the folder
- @param data the FolderData struct to calculate
+ Called at a fixed rate while sizing
+ @param event the timer event (unused)
  */
-void FolderDisplay::sizeImmediate(DirectoryData* data, const bool& skipFolders){
-	//clear to prevent dupes
-	data->files.clear();
-	data->files_size = 1;
-	if (!skipFolders){
-		data->subFolders.clear();
-	}
-	// iterate through the items in the folder
-	for(auto& p : directory_iterator(data->Path,directory_options::skip_permission_denied)){
-		//is the item a folder? if so, defer sizing it
-		//check if can read the file
-		try {
-			file_status s = status(p.path());
-			if (/*!is_symlink(s) &&*/ can_access(s))
-			{
-				if (is_directory(p)) {
-					if (!skipFolders) {
-						DirectoryData* sub = new DirectoryData(p.path().string(), true);
-						data->subFolders.push_back(sub);
-					}
-				}
-				else {
-					//size the file, add its details to the structure
-					DirectoryData* file = new DirectoryData(p.path().string(), stat_file_size(p.path().string()));
-					data->files_size += file->size;
-					file->parent = data;
-					data->files.push_back(file);
-					//cout << file->Path << ": " << file->size << endl;
-				}
-			}
-		}
-		catch (filesystem_error e) {
-			Log("Error sizing file " + p.path().string() + "\n" + e.what());
-		}
-	}
+void FolderDisplay::OnProgressTimer(wxTimerEvent& event){
+	UpdateProgress();
 }
 
 /**
- Size the model representing this display on a background thread
- @param callback the function to call for progress updates
+ Show the subfolders that finished since the last call, and every item once the whole folder has finished
  */
-void FolderDisplay::Size(const progCallback& callback){
-	//reset items
-	displayStartIndex = 0;
-	ListCtrl->DeleteAllItems();
-	abort = false;
+void FolderDisplay::UpdateProgress(){
+	progressSnapshot snapshot = sizer.progress.read();
 	
-	//reset / deallocate
-	data->resetStats();
-	
-	worker = thread([&](){
-		auto uicallback = [&](float prog, DirectoryData* updated){
-			wxCommandEvent event(progEvt);
-			event.SetId(PROGEVT);
-			event.SetInt(prog * 100);
-			event.SetClientData(updated);
-			
-			//invoke event to notify needs to update UI
-			wxPostEvent(this, event);
-		};
-		//called on progress updates
-		SizeItem(data->Path, uicallback);
-	});
-	worker.detach();
-}
-
-void FolderDisplay::OnUpdateUI(wxCommandEvent& event){
-	//update pointer
-	DirectoryData* fd = (DirectoryData*)event.GetClientData();
-	data = fd;
-	//add the current folder
-	AddItem(fd->subFolders[displayStartIndex]);
-	
-	
-	++displayStartIndex;
-	//update progress
-	int prog = event.GetInt();
-		
-	//add files once
-	if (prog == 100){
-		//update percents
-		auto count = data->subFolders.size();
-		for (int i = 0; i < count; i++){
-			wxVariant v = wxAny((long)(data->subFolders[i]->percentOfParent()));
-			ListCtrl->SetValue(v, i, 1);
+	//subfolders finish in any order, add the ones that finished since the last update
+	finished.clear();
+	sizer.progress.takeFinished(finished);
+	if (!snapshot.done){
+		for (nodeIndex folder : finished){
+			model->AddRow(tree->at(folder));
 		}
-		for (DirectoryData* file : fd->files){
-			AddItem(file);
+	}
+	else{
+		//everything has finished: show every item, with final percents
+		progressTimer.Stop();
+		sizing = false;
+		//the workers have already finished, only the sizing thread is left to exit
+		if (worker.joinable()){
+			worker.join();
 		}
+		ItemName->SetLabel(path(tree->pathOf(data)).filename().string() + " - " + sizeToString(tree->sizeOf(data)));
+		model->ShowAll();
 	}
 	
-	//progressBar->SetValue(prog);
+	if (progressCallback != nullptr){
+		progressCallback(snapshot, data);
+	}
 }
@@ -6,30 +6,79 @@
 //
 
 #pragma once
+#include "globals.h"
 #include "interface.h"
 #include "DirectoryData.hpp"
-#include <filesystem>
-#include <unordered_map>
+#include "folder_sizer.hpp"
+#include "FolderModel.hpp"
+#include "file_types.hpp"
 #include <thread>
 
-//callback definitions
-typedef function<void(float progress, DirectoryData* data)> progCallback;
-
 class FolderDisplay : public FolderDisplayBase{
 public:
+	DirectoryTree* tree;
 	DirectoryData* data;
 	
-	FolderDisplay(wxWindow*,wxWindow*, DirectoryData*);
+	FolderDisplay(wxWindow*,wxWindow*, DirectoryTree*, DirectoryData*);
+	~FolderDisplay();
 	
-	void Size(const progCallback&);
+	void Size(const progCallback&, const scanLimits&, bool incremental = false);
+	void Stop();
+	void SetPaused(bool);
 	
 	void display();
-	static string sizeToString(const fileSize&);
-	bool abort = false;
+	/**
+	 @return true while the display's folder is sizing
+	 */
+	bool IsSizing() const{
+		return sizing;
+	}
+	/**
+	 @return true if the display's sizing is paused
+	 */
+	bool IsPaused() const{
+		return sizing && sizer.control.paused();
+	}
+	/**
+	 @return the largest files and folders found by the display's last sizing
+	 */
+	const largestItems& Largest() const{
+		return sizer.largest;
+	}
+	/**
+	 @return the types of the files found by the display's last sizing
+	 */
+	const typeHistogram& Types() const{
+		return sizer.types;
+	}
+	/**
+	 @return the owners of the files found by the display's last sizing
+	 */
+	const ownerHistogram& Owners() const{
+		return sizer.owners;
+	}
+	/**
+	 Forget the largest items, file types and owners of the last sizing, when the display is given a tree it did not size
+	 */
+	void ClearResults(){
+		sizer.largest.reset(0, 0);
+		sizer.types.clear();
+		sizer.owners.clear();
+	}
 private:
 	wxWindow* eventManager = nullptr;
+	//joined when sizing finishes or is stopped, so a new sizing never overlaps an old one
 	std::thread worker;
-	int displayStartIndex = 0;
+	folderSizer sizer;
+	//owned by ListCtrl
+	FolderModel* model;
+	
+	//the sizer's progress is polled at a fixed rate instead of being pushed for every folder
+	static constexpr int progressInterval = 1000 / 30;
+	wxTimer progressTimer;
+	progCallback progressCallback;
+	vector<nodeIndex> finished;
+	bool sizing = false;
 	
 	/**
 	Display a message in the log
@@ -40,57 +89,45 @@ private:
 		evt->SetString(msg);
 		eventManager->GetEventHandler()->QueueEvent(evt);
 	}
-	DirectoryData* SizeItem(const string&, const progCallback&);
-	void sizeImmediate(DirectoryData*, const bool& skipFolders = false);
-	void AddItem(DirectoryData*);
-	
 	//event handlers
 	void OnSelectionChanged(wxDataViewEvent&);
+	void OnColumnSorted(wxDataViewEvent&);
 	void OnSelectionActivated(wxDataViewEvent&);
-	void OnUpdateUI(wxCommandEvent&);
+	void OnProgressTimer(wxTimerEvent&);
+	void UpdateProgress();
 	wxDECLARE_EVENT_TABLE();
 	
 public:
 	#if defined __APPLE__ || defined __linux__
+		/**
+		 @param category a kind of file
+		 @returns an emoji representing the kind of file
+		 */
+		static wxString iconForCategory(fileCategory category){
+			//for drawing icons next to items in the list, in the order of fileCategory
+			static const wxString icons[numCategories] = {L"📟", L"💾", L"💿", L"🎨", L"🎵", L"🎞", L"📦", L"📝", L"📄"};
+			return icons[(size_t)category];
+		}
 		/**
 		 Return the icon for a file type
-		 @param data the directorydata of the file
+		 @param name the name of the item
+		 @param isFolder true if the item is a folder
 		 @returns an emoji representing the file type
 		 */
-		static wxString iconForExtension(const DirectoryData* data){
-			//for drawing icons next to items in the list
-			static const std::unordered_map<string,wxString> icons = {
-				{"exe", L"💾" },{"dll", L"💾" },{"bat", L"💾" },{"jar", "💾" },
-				{"iso", L"💿" },{"bin", L"💿"},
-				{"ai",L"🎨" },{"bmp", L"🎨" },{"gif", L"🎨" },{"ico", L"🎨" },{"jpeg", L"🎨" },{"jpg", L"🎨" },{"png",L"🎨" },{"psd",L"🎨" },{"svg",L"🎨" },{"tif",L"🎨" },
-				{"mp3",L"🎵" },{"aif", L"🎵" },{"ogg", L"🎵" },{"wav", L"🎵" },{"wma", L"🎵" },{"m4a", L"🎵" },
-				{ "mp4",L"🎞"},{ "avi", L"🎞"},{ "flv", L"🎞"},{ "h264", L"🎞"},{ "m4v", L"🎞"},{ "mkv", L"🎞"},{ "mov",L"🎞"},{ "mpg",L"🎞"},{ "wmv",L"🎞"},
-				{ "7z",L"📦"},{ "arj", L"📦"},{ "pkg", L"📦"},{ "rar", L"📦"},{ "rpm", L"📦"},{ "tar.gz", L"📦"},{ "z", L"📦"},{ "zip",L"📦"},
-				{ "doc",L"📝"},{ "docx", L"📝"},{ "odt", L"📝"},{ "pdf", L"📝"},{ "rtf", L"📝"},{ "tex", L"📝"}
-			};
+		static wxString iconForExtension(const string& name, bool isFolder){
 			static const wxString FolderIcon = L"📁";
-			//avoid crash checking unordered map for empty string
-			if (!data->isFolder){
-				string extension = std::filesystem::path(data->Path).extension();
-				if (extension.size() == 0){
-					return L"📟";
-				}
-				try{
-					extension = extension.substr(1,extension.size());
-					return icons.at(extension);
-				}
-				catch(exception e){
-					return L"📄";
-				}
-			}
-			else{
+			if (isFolder){
 				return FolderIcon;
 			}
+			return iconForCategory(classifyName(name).category);
 		}
 	#elif defined _WIN32
 		//on Windows, unicode is not supported (for now)
 		static const wxString FolderIcon = "";
-		static wxString iconForExtension(const DirectoryData* data) {
+		static wxString iconForExtension(const string& name, bool isFolder) {
+			return "";
+		}
+		static wxString iconForCategory(fileCategory category) {
 			return "";
 		}
 	#endif
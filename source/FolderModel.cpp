@@ -0,0 +1,135 @@
+//
+//  FolderModel.cpp
+//  mac
+//
+//  Copyright © 2020 Ravbug. All rights reserved.
+//
+
+#include "FolderModel.hpp"
+#include "FolderDisplay.hpp"
+#include <algorithm>
+
+/**
+ Create a model that shows no rows
+ @param folderTree the tree that owns the folder
+ @param contents the folder whose children to show
+ */
+FolderModel::FolderModel(DirectoryTree* folderTree, DirectoryData* contents) : wxDataViewVirtualListModel(0){
+	tree = folderTree;
+	folder = contents;
+}
+
+/**
+ Change the folder the model represents. No rows are shown until ShowAll or AddRow is called.
+ @param folderTree the tree that owns the folder
+ @param contents the folder whose children to show
+ */
+void FolderModel::SetFolder(DirectoryTree* folderTree, DirectoryData* contents){
+	tree = folderTree;
+	folder = contents;
+	ShowNone();
+}
+
+/**
+ Show every child of the folder, subfolders first. Call once the folder has finished sizing.
+ */
+void FolderModel::ShowAll(){
+	rows.clear();
+	rows.shrink_to_fit();
+	showAll = true;
+	Reset(NumRows());
+}
+
+/**
+ Remove all rows, for example before the folder is sized again
+ */
+void FolderModel::ShowNone(){
+	rows.clear();
+	showAll = false;
+	Reset(0);
+}
+
+/**
+ Append a single row, used while the folder is still sizing
+ @param item the item to add
+ */
+void FolderModel::AddRow(DirectoryData* item){
+	if (showAll){
+		return;
+	}
+	rows.push_back(item);
+	RowAppended();
+}
+
+/**
+ Order the rows by size. Only builds a row list when the user asks for a sort.
+ @param ascending true to show the smallest items first
+ */
+void FolderModel::SortBySize(bool ascending){
+	if (showAll && rows.size() == 0){
+		rows.reserve(folder->numChildren());
+		for (uint32_t i = 0; i < folder->numChildren(); i++){
+			rows.push_back(tree->at(folder->firstChild + i));
+		}
+	}
+	stable_sort(rows.begin(), rows.end(), [&](const DirectoryData* a, const DirectoryData* b){
+		return ascending ? tree->sizeOf(a) < tree->sizeOf(b) : tree->sizeOf(a) > tree->sizeOf(b);
+	});
+	Reset(NumRows());
+}
+
+/**
+ @param item an item in the control
+ @return the DirectoryData the item represents, or nullptr if the item is not valid
+ */
+DirectoryData* FolderModel::ItemAt(const wxDataViewItem& item) const{
+	if (!item.IsOk()){
+		return nullptr;
+	}
+	unsigned int row = GetRow(item);
+	return row < NumRows() ? RowAt(row) : nullptr;
+}
+
+/**
+ @return the number of rows currently shown
+ */
+unsigned int FolderModel::NumRows() const{
+	if (rows.size() > 0 || !showAll){
+		return (unsigned int)rows.size();
+	}
+	return folder->numChildren();
+}
+
+/**
+ @param row the row to get
+ @return the item shown in the row
+ */
+DirectoryData* FolderModel::RowAt(unsigned int row) const{
+	if (rows.size() > 0 || !showAll){
+		return rows[row];
+	}
+	return tree->at(folder->firstChild + row);
+}
+
+/**
+ Format a single cell. Called by the control only for rows it draws.
+ @param variant populated with the cell's value
+ @param row the row of the cell
+ @param col the column of the cell
+ */
+void FolderModel::GetValueByRow(wxVariant& variant, unsigned int row, unsigned int col) const{
+	DirectoryData* item = RowAt(row);
+	switch(col){
+		case nameColumn:{
+			string name = tree->nameOf(item);
+			variant = FolderDisplay::iconForExtension(name, item->isFolder) + wxString::FromUTF8(name.c_str());
+			break;
+		}
+		case percentColumn:
+			variant = (long)tree->percentOfParent(item);
+			break;
+		case sizeColumn:
+			variant = wxString(sizeToString(tree->sizeOf(item)));
+			break;
+	}
+}
@@ -0,0 +1,55 @@
+//
+//  FolderModel.hpp
+//  mac
+//
+//  Copyright © 2020 Ravbug. All rights reserved.
+//
+
+#pragma once
+#include <wx/dataview.h>
+#include "DirectoryData.hpp"
+
+/**
+ Presents the children of a folder to a wxDataViewCtrl. Cells are read from the tree and formatted
+ only when the control draws them, so the control keeps no copy of the items.
+ */
+class FolderModel : public wxDataViewVirtualListModel{
+public:
+	enum column{
+		nameColumn,
+		percentColumn,
+		sizeColumn,
+		numColumns
+	};
+
+	FolderModel(DirectoryTree*, DirectoryData*);
+
+	void SetFolder(DirectoryTree*, DirectoryData*);
+	void ShowAll();
+	void ShowNone();
+	void AddRow(DirectoryData*);
+	void SortBySize(bool ascending);
+	DirectoryData* ItemAt(const wxDataViewItem&) const;
+
+	//wxDataViewVirtualListModel
+	unsigned int GetColumnCount() const override{
+		return numColumns;
+	}
+	wxString GetColumnType(unsigned int col) const override{
+		return col == percentColumn ? "long" : "string";
+	}
+	void GetValueByRow(wxVariant&, unsigned int row, unsigned int col) const override;
+	bool SetValueByRow(const wxVariant&, unsigned int, unsigned int) override{
+		return false;
+	}
+
+private:
+	DirectoryTree* tree;
+	DirectoryData* folder;
+	//rows in display order. When empty and all children are shown, rows map straight onto the folder's children.
+	vector<DirectoryData*> rows;
+	bool showAll = false;
+
+	DirectoryData* RowAt(unsigned int) const;
+	unsigned int NumRows() const;
+};
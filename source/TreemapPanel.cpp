@@ -0,0 +1,241 @@
+//
+//  TreemapPanel.cpp
+//  mac
+//
+//  Copyright © 2020 Ravbug. All rights reserved.
+//
+
+#include "TreemapPanel.hpp"
+#include "file_types.hpp"
+#include <wx/dcbuffer.h>
+#include <cmath>
+
+wxBEGIN_EVENT_TABLE(TreemapPanel, wxPanel)
+EVT_PAINT(TreemapPanel::OnPaint)
+EVT_SIZE(TreemapPanel::OnSize)
+EVT_LEFT_DOWN(TreemapPanel::OnLeftDown)
+EVT_LEFT_DCLICK(TreemapPanel::OnLeftDClick)
+EVT_RIGHT_DOWN(TreemapPanel::OnRightDown)
+EVT_MOTION(TreemapPanel::OnMotion)
+wxEND_EVENT_TABLE()
+
+using namespace std;
+
+/**
+ Constructs an empty treemap
+ @param parentWindow the parent wxWindow
+ @param eventWindow the wxWindow to send selection events to
+ */
+TreemapPanel::TreemapPanel(wxWindow* parentWindow, wxWindow* eventWindow) : wxPanel(parentWindow, wxID_ANY, wxDefaultPosition, wxSize(-1, 200)){
+	eventManager = eventWindow;
+	//every pixel is painted from the bitmap, so erasing the background first would only flicker
+	SetBackgroundStyle(wxBG_STYLE_PAINT);
+}
+
+/**
+ Show a tree, starting from its root
+ @param contentsTree the tree to show, or nullptr to show nothing, such as while the tree is sized
+ */
+void TreemapPanel::SetTree(DirectoryTree* contentsTree){
+	tree = contentsTree;
+	root = 0;
+	highlighted = noNode;
+	hovered = noNode;
+	layout.clear();
+	tiles.clear();
+	UnsetToolTip();
+	stale = true;
+	Refresh();
+}
+
+/**
+ Draw the map again after sizes in the tree changed. Only the folders that changed are laid out again.
+ */
+void TreemapPanel::Changed(){
+	stale = true;
+	Refresh();
+}
+
+/**
+ Follow items that moved to a new index. A map of a folder that was removed shows the whole tree instead.
+ @param moved the items that moved as (old, new), or were removed as (old, noNode)
+ */
+void TreemapPanel::Moved(const DirectoryTree::movedList& moved){
+	for (const auto& move : moved){
+		if (root == move.first){
+			root = move.second == noNode ? 0 : move.second;
+		}
+		if (highlighted == move.first){
+			highlighted = move.second;
+		}
+	}
+	hovered = noNode;
+	stale = true;
+}
+
+/**
+ Lay out the map for the panel's current size, and draw it into the bitmap
+ */
+void TreemapPanel::Redraw(){
+	stale = false;
+	wxSize size = GetClientSize();
+	tiles.clear();
+	if (size.x <= 0 || size.y <= 0){
+		return;
+	}
+	if (!rendered.IsOk() || rendered.GetWidth() != size.x || rendered.GetHeight() != size.y){
+		rendered = wxBitmap(size.x, size.y);
+	}
+	wxMemoryDC dc(rendered);
+	dc.SetBackground(wxBrush(wxSystemSettings::GetColour(wxSYS_COLOUR_APPWORKSPACE)));
+	dc.Clear();
+	if (tree == nullptr){
+		return;
+	}
+	layout.render(*tree, root, size.x, size.y, tiles);
+	for (const treemapTile& tile : tiles){
+		//round the edges rather than the sizes, so that neighbors meet without gaps
+		int left = (int)lround(tile.rect.x);
+		int top = (int)lround(tile.rect.y);
+		int right = (int)lround(tile.rect.x + tile.rect.w);
+		int bottom = (int)lround(tile.rect.y + tile.rect.h);
+		wxColour color = ColorOf(*tree, tile);
+		dc.SetBrush(wxBrush(color));
+		dc.SetPen(wxPen(color.ChangeLightness(70)));
+		dc.DrawRectangle(left, top, right - left, bottom - top);
+	}
+}
+
+/**
+ Fill the panel with a folder
+ @param folder the index of the folder
+ */
+void TreemapPanel::ZoomTo(nodeIndex folder){
+	root = folder;
+	hovered = noNode;
+	UnsetToolTip();
+	stale = true;
+	Refresh();
+}
+
+/**
+ @param point a position in the panel
+ @return the deepest item drawn at the point, or nullptr if there is none
+ */
+const treemapTile* TreemapPanel::TileAt(const wxPoint& point) const{
+	if (tree == nullptr || stale){
+		return nullptr;
+	}
+	return treemapLayout::hitTest(tiles, point.x, point.y);
+}
+
+/**
+ @param contentsTree the tree the tile is from
+ @param tile a tile
+ @return the color to fill the tile with. Files are colored by category, folders are shaded darker the deeper they are.
+ */
+wxColour TreemapPanel::ColorOf(const DirectoryTree& contentsTree, const treemapTile& tile){
+	if (tile.isFolder){
+		unsigned char shade = 235 - 12 * min<uint32_t>(tile.depth, 8);
+		return wxColour(shade, shade, shade);
+	}
+	//in the order of fileCategory
+	static const wxColour palette[numCategories] = {
+		wxColour(160, 160, 160), wxColour(214, 96, 77), wxColour(156, 110, 190), wxColour(98, 176, 98), wxColour(234, 160, 60),
+		wxColour(205, 90, 160), wxColour(170, 130, 90), wxColour(80, 140, 210), wxColour(100, 180, 180)
+	};
+	return palette[(size_t)classifyName(contentsTree.nameOf(contentsTree.at(tile.index))).category];
+}
+
+/**
+ Copy the map to the screen, drawing it again first if it is out of date, and outline the selected item
+ @param event (unused) the paint event
+ */
+void TreemapPanel::OnPaint(wxPaintEvent& event){
+	wxAutoBufferedPaintDC dc(this);
+	if (stale){
+		Redraw();
+	}
+	if (!rendered.IsOk()){
+		dc.SetBackground(wxBrush(wxSystemSettings::GetColour(wxSYS_COLOUR_APPWORKSPACE)));
+		dc.Clear();
+		return;
+	}
+	dc.DrawBitmap(rendered, 0, 0);
+	for (const treemapTile& tile : tiles){
+		if (tile.index == highlighted){
+			dc.SetBrush(*wxTRANSPARENT_BRUSH);
+			dc.SetPen(wxPen(*wxWHITE, 2));
+			dc.DrawRectangle((int)lround(tile.rect.x), (int)lround(tile.rect.y), (int)lround(tile.rect.w), (int)lround(tile.rect.h));
+			break;
+		}
+	}
+}
+
+/**
+ Called when the panel is resized. The layouts cached for the old size are replaced as the map is drawn again.
+ @param event the size event
+ */
+void TreemapPanel::OnSize(wxSizeEvent& event){
+	stale = true;
+	Refresh();
+	event.Skip();
+}
+
+/**
+ Select the item that was clicked, and show it in the sidebar
+ @param event the mouse event
+ */
+void TreemapPanel::OnLeftDown(wxMouseEvent& event){
+	const treemapTile* tile = TileAt(event.GetPosition());
+	if (tile != nullptr){
+		highlighted = tile->index;
+		Refresh();
+		//notify parent to update sidebar display
+		wxCommandEvent* evt = new wxCommandEvent(progEvt, SELEVT);
+		uintptr_t* addr = new uintptr_t((uintptr_t)tree->at(tile->index));
+		evt->SetClientData(addr);
+		eventManager->GetEventHandler()->QueueEvent(evt);
+	}
+	event.Skip();
+}
+
+/**
+ Zoom into the folder that was double clicked
+ @param event the mouse event
+ */
+void TreemapPanel::OnLeftDClick(wxMouseEvent& event){
+	const treemapTile* tile = TileAt(event.GetPosition());
+	if (tile != nullptr && tile->isFolder && tile->index != root){
+		ZoomTo(tile->index);
+	}
+}
+
+/**
+ Zoom out to the parent of the folder filling the panel
+ @param event the mouse event
+ */
+void TreemapPanel::OnRightDown(wxMouseEvent& event){
+	if (tree != nullptr && root != 0){
+		ZoomTo(tree->indexOf(tree->parentOf(tree->at(root))));
+	}
+}
+
+/**
+ Show the path and size of the item under the mouse
+ @param event the mouse event
+ */
+void TreemapPanel::OnMotion(wxMouseEvent& event){
+	const treemapTile* tile = TileAt(event.GetPosition());
+	nodeIndex index = tile != nullptr ? tile->index : noNode;
+	if (index == hovered){
+		return;
+	}
+	hovered = index;
+	if (tile == nullptr){
+		UnsetToolTip();
+		return;
+	}
+	DirectoryData* item = tree->at(index);
+	SetToolTip(wxString::FromUTF8(tree->pathOf(item).c_str()) + "\n" + sizeToString(tree->sizeOf(item)));
+}
@@ -0,0 +1,53 @@
+//
+//  TreemapPanel.hpp
+//  mac
+//
+//  Copyright © 2020 Ravbug. All rights reserved.
+//
+
+#pragma once
+#include "globals.h"
+#include "DirectoryData.hpp"
+#include "treemap_layout.hpp"
+
+/**
+ Draws a sized tree as a treemap. The map is drawn once into a bitmap, and only drawn again when the tree or the panel's size changes,
+ so repainting, such as when the selection moves, only copies the bitmap.
+ Clicking an item selects it, double clicking a folder zooms into it, and right clicking zooms back out.
+ */
+class TreemapPanel : public wxPanel{
+public:
+	TreemapPanel(wxWindow*, wxWindow*);
+
+	void SetTree(DirectoryTree*);
+	void Changed();
+	void Moved(const DirectoryTree::movedList&);
+
+private:
+	wxWindow* eventManager = nullptr;
+	//nullptr while the tree is being sized, since the sizes are still changing
+	DirectoryTree* tree = nullptr;
+	//the folder that fills the panel
+	nodeIndex root = 0;
+	nodeIndex highlighted = noNode;
+	nodeIndex hovered = noNode;
+
+	treemapLayout layout;
+	vector<treemapTile> tiles;
+	wxBitmap rendered;
+	bool stale = true;
+
+	void Redraw();
+	void ZoomTo(nodeIndex);
+	const treemapTile* TileAt(const wxPoint&) const;
+	static wxColour ColorOf(const DirectoryTree&, const treemapTile&);
+
+	//event handlers
+	void OnPaint(wxPaintEvent&);
+	void OnSize(wxSizeEvent&);
+	void OnLeftDown(wxMouseEvent&);
+	void OnLeftDClick(wxMouseEvent&);
+	void OnRightDown(wxMouseEvent&);
+	void OnMotion(wxMouseEvent&);
+	wxDECLARE_EVENT_TABLE();
+};
@@ -0,0 +1,114 @@
+//
+//  arena.hpp
+//  mac
+//
+//  Copyright © 2020 Ravbug. All rights reserved.
+//
+
+#pragma once
+#include <atomic>
+#include <memory>
+#include <new>
+#include <cstring>
+#include <stdint.h>
+
+/**
+ Storage for a large number of T, addressed by index and allocated in fixed-size chunks.
+ Chunks are allocated on first use and never move, so pointers into them stay valid until the arena is destroyed,
+ and the arena can be read while other threads are reserving space. Destroying the arena frees every chunk at once.
+ The leading chunks can also be borrowed from an existing buffer, such as a memory-mapped file, with adopt.
+ @note T must be trivially destructible, its destructor is never run
+ */
+template<typename T, unsigned int chunkBits, unsigned int tableBits = 16>
+class chunkArena{
+public:
+	static constexpr uint64_t chunkSize = uint64_t(1) << chunkBits;
+	static constexpr uint64_t capacity = chunkSize << tableBits;
+
+	chunkArena() : table(new std::atomic<T*>[size_t(1) << tableBits]()){}
+	~chunkArena(){
+		//adopted chunks belong to the caller
+		for (size_t i = adopted; i < (size_t(1) << tableBits); i++){
+			delete[] table[i].load(std::memory_order_relaxed);
+		}
+	}
+	chunkArena(const chunkArena&) = delete;
+	chunkArena& operator=(const chunkArena&) = delete;
+
+	/**
+	 @param index the index of the element
+	 @return a pointer to the element. The chunk containing it must have been reserved.
+	 */
+	T* at(uint64_t index) const{
+		return table[index >> chunkBits].load(std::memory_order_acquire) + (index & (chunkSize - 1));
+	}
+
+	/**
+	 Ensure that the chunks covering a range of indices exist. Safe to call from multiple threads.
+	 @param first the first index in the range
+	 @param count the number of elements in the range
+	 */
+	void reserve(uint64_t first, uint64_t count){
+		if (count == 0){
+			return;
+		}
+		if (first + count > capacity){
+			throw std::bad_alloc();
+		}
+		for (uint64_t c = first >> chunkBits; c <= (first + count - 1) >> chunkBits; c++){
+			if (table[c].load(std::memory_order_acquire) != nullptr){
+				continue;
+			}
+			T* chunk = new T[chunkSize]();
+			T* expected = nullptr;
+			//another thread may have allocated the same chunk
+			if (!table[c].compare_exchange_strong(expected, chunk, std::memory_order_acq_rel)){
+				delete[] chunk;
+			}
+		}
+	}
+
+	/**
+	 Use an existing buffer as the first elements of the arena, without copying the whole chunks it covers.
+	 Anything previously stored in that range is discarded.
+	 The elements after the last whole chunk are copied into a chunk of the arena's own, so the arena can grow past them.
+	 @param buffer the elements. Must stay valid, and writable if the elements will be modified, for the life of the arena.
+	 @param count the number of elements in the buffer
+	 @note call at most once
+	 */
+	void adopt(T* buffer, uint64_t count){
+		if (count > capacity){
+			throw std::bad_alloc();
+		}
+		adopted = (size_t)(count >> chunkBits);
+		for (size_t c = 0; c < adopted; c++){
+			delete[] table[c].exchange(buffer + (uint64_t(c) << chunkBits), std::memory_order_acq_rel);
+		}
+		uint64_t tail = count & (chunkSize - 1);
+		if (tail > 0){
+			reserve(count - tail, tail);
+			memcpy((void*)at(count - tail), buffer + (count - tail), tail * sizeof(T));
+		}
+	}
+
+	/**
+	 Find the index of an element from its address
+	 @param ptr pointer to an element in this arena
+	 @return the index of the element, or UINT64_MAX if the pointer is not in this arena
+	 @note linear in the number of chunks
+	 */
+	uint64_t indexOf(const T* ptr) const{
+		for (size_t c = 0; c < (size_t(1) << tableBits); c++){
+			T* chunk = table[c].load(std::memory_order_acquire);
+			if (chunk != nullptr && ptr >= chunk && ptr < chunk + chunkSize){
+				return (uint64_t(c) << chunkBits) + (ptr - chunk);
+			}
+		}
+		return UINT64_MAX;
+	}
+
+private:
+	std::unique_ptr<std::atomic<T*>[]> table;
+	//number of leading chunks borrowed with adopt
+	size_t adopted = 0;
+};
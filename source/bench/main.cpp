@@ -0,0 +1,387 @@
+//
+//  main.cpp
+//  bench
+//
+//  Copyright © 2020 Ravbug. All rights reserved.
+//
+// This file contains the sizer benchmark. It generates synthetic trees, sizes each one with every
+// scan backend in a separate process, and reports the speed, system calls and memory of each run.
+
+#include "../platform.h"
+#include "../folder_sizer.hpp"
+#include "tree_generator.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/ptrace.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/vfs.h>
+#include <sys/wait.h>
+using namespace std;
+
+#ifndef PTRACE_GET_SYSCALL_INFO
+#define PTRACE_GET_SYSCALL_INFO 0x420e
+#endif
+//f_type of a tmpfs, from linux/magic.h
+static constexpr long tmpfsMagic = 0x01021994;
+
+/**
+ The start of the kernel's ptrace_syscall_info, which older C libraries do not declare
+ */
+struct syscallInfo{
+	uint8_t op;
+	uint8_t pad[3];
+	uint32_t arch;
+	uint64_t instructionPointer;
+	uint64_t stackPointer;
+	uint64_t nr;
+	uint64_t args[6];
+};
+static constexpr uint8_t syscallEntry = 1;
+
+/**
+ The benchmark's options
+ */
+struct options{
+	string folder;
+	unsigned int scale = 1;
+	int runs = 3;
+	unsigned int threads = thread::hardware_concurrency();
+	bool csv = false;
+	bool countSyscalls = true;
+};
+
+/**
+ What a child process reports about one scan
+ */
+struct scanResult{
+	uint64_t items = 0;
+	fileSize size = 0;
+	uint64_t nanoseconds = 0;
+};
+
+/**
+ The combined measurements for one tree and backend
+ */
+struct benchResult{
+	scanResult scan;
+	//the fastest run
+	uint64_t bestNanoseconds = UINT64_MAX;
+	//in kilobytes, the largest of the runs
+	long peakRss = 0;
+	//-1 if they could not be counted
+	long syscalls = -1;
+};
+
+static const char* usage =
+"Usage: FatFileFinder-bench [options] <folder>\n"
+"Generate synthetic trees in a folder, preferably on a tmpfs, and size each one with every backend.\n"
+"\n"
+"  -s, --scale N       multiply the number of items in each tree (default 1)\n"
+"  -r, --runs N        time each backend N times and keep the fastest (default 3)\n"
+"  -j, --threads N     number of sizing threads (default: one per core)\n"
+"      --csv           print comma separated values instead of a table\n"
+"      --no-syscalls   skip counting system calls, which runs each scan again under ptrace\n"
+"  -h, --help          show this message\n";
+
+/**
+ @param backend a scan backend
+ @return the name of the backend
+ */
+static const char* backendName(scanBackend backend){
+	switch (backend){
+		case scanBackend::standard:
+			return "standard";
+		case scanBackend::getdents:
+			return "getdents";
+		case scanBackend::uring:
+			return "uring";
+	}
+	return "";
+}
+
+/**
+ Size a tree. getppid brackets the scan so that a tracer can tell which system calls belong to it.
+ @param folder the root of the tree
+ @param backend the backend to use
+ @param threads the number of sizing threads
+ @return the totals and the time taken
+ */
+static scanResult scan(const string& folder, scanBackend backend, unsigned int threads){
+	DirectoryTree tree(folder);
+	folderSizer sizer(threads);
+	sizer.backend = backend;
+	getppid();
+	auto start = chrono::steady_clock::now();
+	sizer.Size(&tree, 0, [](const string& msg){
+		fprintf(stderr, "%s\n", msg.c_str());
+	});
+	auto end = chrono::steady_clock::now();
+	getppid();
+	scanResult result;
+	result.items = tree.root()->num_items;
+	result.size = tree.root()->size;
+	result.nanoseconds = chrono::duration_cast<chrono::nanoseconds>(end - start).count();
+	return result;
+}
+
+/**
+ Run a scan in a child process, so each run starts with a fresh heap and its peak memory can be measured alone
+ @param folder the root of the tree
+ @param backend the backend to use
+ @param threads the number of sizing threads
+ @param traced true to count the scan's system calls with ptrace
+ @param result receives the child's scan
+ @param peakRss receives the child's peak resident set size in kilobytes
+ @param syscalls receives the number of system calls made while sizing, if traced
+ @return true if the child finished normally
+ */
+static bool runChild(const string& folder, scanBackend backend, unsigned int threads, bool traced, scanResult& result, long& peakRss, long& syscalls){
+	int fds[2];
+	if (pipe(fds) != 0){
+		return false;
+	}
+	fflush(stdout);
+	fflush(stderr);
+	pid_t child = fork();
+	if (child < 0){
+		close(fds[0]);
+		close(fds[1]);
+		return false;
+	}
+	if (child == 0){
+		close(fds[0]);
+		if (traced){
+			if (ptrace(PTRACE_TRACEME, 0, nullptr, nullptr) != 0){
+				_exit(3);
+			}
+			raise(SIGSTOP);
+		}
+		scanResult childResult = scan(folder, backend, threads);
+		write(fds[1], &childResult, sizeof(childResult));
+		_exit(0);
+	}
+	close(fds[1]);
+
+	int status = 0;
+	if (traced){
+		//follow every thread, counting the system calls they enter between the two getppid markers
+		syscalls = 0;
+		int markers = 0;
+		bool started = false;
+		pid_t pid;
+		while ((pid = waitpid(-1, &status, __WALL)) > 0){
+			if (!WIFSTOPPED(status)){
+				continue;
+			}
+			int stop = WSTOPSIG(status);
+			int signal = 0;
+			if (!started){
+				started = true;
+				ptrace(PTRACE_SETOPTIONS, pid, nullptr, PTRACE_O_TRACESYSGOOD | PTRACE_O_TRACECLONE | PTRACE_O_EXITKILL);
+			}
+			else if (stop == (SIGTRAP | 0x80)){
+				syscallInfo info;
+				if (ptrace((__ptrace_request)PTRACE_GET_SYSCALL_INFO, pid, (void*)sizeof(info), &info) > 0 && info.op == syscallEntry){
+					if (info.nr == SYS_getppid){
+						markers++;
+					}
+					else if (markers == 1){
+						syscalls++;
+					}
+				}
+			}
+			else if (stop != SIGTRAP && stop != SIGSTOP){
+				//pass real signals on, swallow the stops ptrace causes
+				signal = stop;
+			}
+			ptrace(PTRACE_SYSCALL, pid, nullptr, (void*)(intptr_t)signal);
+		}
+		if (markers < 2){
+			syscalls = -1;
+		}
+		peakRss = 0;
+	}
+	else{
+		rusage usage;
+		wait4(child, &status, 0, &usage);
+		peakRss = usage.ru_maxrss;
+	}
+	bool complete = read(fds[0], &result, sizeof(result)) == sizeof(result);
+	close(fds[0]);
+	return complete;
+}
+
+/**
+ Parse the command line
+ @param argc the number of arguments
+ @param argv the arguments
+ @param opts receives the options
+ @return an error message, or an empty string on success
+ */
+static string parseOptions(int argc, char** argv, options& opts){
+	for (int i = 1; i < argc; i++){
+		string arg = argv[i];
+		auto number = [&]() -> long{
+			return i + 1 < argc ? atol(argv[++i]) : 0;
+		};
+		if (arg == "-h" || arg == "--help"){
+			fputs(usage, stdout);
+			exit(0);
+		}
+		else if (arg == "-s" || arg == "--scale"){
+			long value = number();
+			if (value <= 0){
+				return "--scale needs a positive number";
+			}
+			opts.scale = value;
+		}
+		else if (arg == "-r" || arg == "--runs"){
+			long value = number();
+			if (value <= 0){
+				return "--runs needs a positive number";
+			}
+			opts.runs = value;
+		}
+		else if (arg == "-j" || arg == "--threads"){
+			long value = number();
+			if (value <= 0){
+				return "--threads needs a positive number";
+			}
+			opts.threads = value;
+		}
+		else if (arg == "--csv"){
+			opts.csv = true;
+		}
+		else if (arg == "--no-syscalls"){
+			opts.countSyscalls = false;
+		}
+		else if (arg.size() > 1 && arg[0] == '-'){
+			return "unknown option " + arg;
+		}
+		else if (opts.folder.empty()){
+			opts.folder = arg;
+		}
+		else{
+			return "only one folder can be used";
+		}
+	}
+	if (opts.folder.empty()){
+		return "no folder given";
+	}
+	return "";
+}
+
+/**
+ Generate a tree unless an identical one is already there. A marker file next to the tree records
+ that it was generated completely, and how many items it holds.
+ @param folder the folder to create the tree in
+ @param shape the kind of tree
+ @param scale the scale of the tree
+ @param items set to the number of items in the tree, not counting its root
+ @return the path to the tree
+ @throws system_error if the tree cannot be created
+ */
+static string prepareTree(const string& folder, treeShape shape, unsigned int scale, uint64_t& items){
+	string tree = folder + "/" + shapeName(shape) + "-" + to_string(scale);
+	string marker = tree + ".done";
+	//a marker without a count is regenerated
+	items = 0;
+	if (ifstream(marker) >> items && items > 0){
+		return tree;
+	}
+	fprintf(stderr, "Generating %s...\n", tree.c_str());
+	filesystem::remove_all(tree);
+	items = generateTree(tree, shape, scale);
+	ofstream(marker) << items << "\n";
+	return tree;
+}
+
+int main(int argc, char** argv){
+	options opts;
+	string error = parseOptions(argc, argv, opts);
+	if (!error.empty()){
+		fprintf(stderr, "FatFileFinder-bench: %s\n\n%s", error.c_str(), usage);
+		return 2;
+	}
+	error_code ec;
+	filesystem::create_directories(opts.folder, ec);
+	struct statfs fs;
+	if (statfs(opts.folder.c_str(), &fs) != 0){
+		fprintf(stderr, "FatFileFinder-bench: cannot use %s\n", opts.folder.c_str());
+		return 1;
+	}
+	if (fs.f_type != tmpfsMagic){
+		fprintf(stderr, "Warning: %s is not on a tmpfs, so the results include the disk and its cache\n", opts.folder.c_str());
+	}
+
+	if (opts.csv){
+		printf("shape,backend,items,wall_ms,items_per_sec,syscalls_per_item,peak_rss_kb\n");
+	}
+	else{
+		printf("%-9s %-9s %9s %10s %12s %14s %13s\n", "Shape", "Backend", "Items", "Wall ms", "Items/s", "Syscalls/item", "Peak RSS MB");
+	}
+	//set when a scan finds a different number of items than were generated
+	bool mismatched = false;
+	for (treeShape shape : allShapes){
+		string tree;
+		uint64_t expectedItems = 0;
+		try{
+			tree = prepareTree(opts.folder, shape, opts.scale, expectedItems);
+		}
+		catch(exception& e){
+			fprintf(stderr, "FatFileFinder-bench: %s\n", e.what());
+			return 1;
+		}
+		for (scanBackend backend : {scanBackend::standard, scanBackend::getdents, scanBackend::uring}){
+			benchResult bench;
+			bool complete = true;
+			for (int run = 0; run < opts.runs && complete; run++){
+				long peakRss = 0;
+				long unused;
+				complete = runChild(tree, backend, opts.threads, false, bench.scan, peakRss, unused);
+				bench.bestNanoseconds = min(bench.bestNanoseconds, bench.scan.nanoseconds);
+				bench.peakRss = max(bench.peakRss, peakRss);
+			}
+			if (complete && opts.countSyscalls){
+				scanResult traced;
+				long unused;
+				if (!runChild(tree, backend, opts.threads, true, traced, unused, bench.syscalls)){
+					bench.syscalls = -1;
+				}
+			}
+			if (!complete){
+				fprintf(stderr, "FatFileFinder-bench: the %s scan of %s failed\n", backendName(backend), tree.c_str());
+				continue;
+			}
+			//every backend must find exactly what was generated, or its timing means nothing
+			if (bench.scan.items != expectedItems){
+				fprintf(stderr, "FatFileFinder-bench: %s found %llu items in %s, but %llu were generated\n", backendName(backend), (unsigned long long)bench.scan.items, tree.c_str(), (unsigned long long)expectedItems);
+				mismatched = true;
+			}
+
+			double ms = bench.bestNanoseconds / 1e6;
+			double itemsPerSecond = bench.scan.items / (bench.bestNanoseconds / 1e9);
+			double syscallsPerItem = bench.syscalls < 0 ? -1 : (double)bench.syscalls / max<uint64_t>(bench.scan.items, 1);
+			if (opts.csv){
+				printf("%s,%s,%llu,%.3f,%.0f,%.3f,%ld\n", shapeName(shape), backendName(backend), (unsigned long long)bench.scan.items, ms, itemsPerSecond, syscallsPerItem, bench.peakRss);
+			}
+			else{
+				char syscallText[32] = "n/a";
+				if (syscallsPerItem >= 0){
+					snprintf(syscallText, sizeof(syscallText), "%.3f", syscallsPerItem);
+				}
+				printf("%-9s %-9s %9llu %10.1f %12.0f %14s %13.1f\n", shapeName(shape), backendName(backend), (unsigned long long)bench.scan.items, ms, itemsPerSecond, syscallText, bench.peakRss / 1024.0);
+			}
+			fflush(stdout);
+		}
+	}
+	return mismatched ? 1 : 0;
+}
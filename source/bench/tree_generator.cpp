@@ -0,0 +1,220 @@
+//
+//  tree_generator.cpp
+//  bench
+//
+//  Copyright © 2020 Ravbug. All rights reserved.
+//
+
+#include "tree_generator.hpp"
+#include <system_error>
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+using namespace std;
+
+/**
+ A small deterministic random number generator (splitmix64). The standard library's distributions
+ differ between implementations, which would make the trees differ between machines.
+ */
+class treeRandom{
+public:
+	treeRandom(uint64_t seed) : state(seed){}
+	/**
+	 @param bound the upper limit
+	 @return a number in [0, bound)
+	 */
+	uint64_t below(uint64_t bound){
+		uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+		return (z ^ (z >> 31)) % bound;
+	}
+private:
+	uint64_t state;
+};
+
+/**
+ Creates entries relative to folder descriptors, so that deep trees never build long paths
+ */
+class treeWriter{
+public:
+	uint64_t items = 0;
+
+	/**
+	 Create a folder
+	 @param parent the descriptor of the parent folder
+	 @param name the name of the new folder
+	 @return a descriptor for the new folder, to be closed with done
+	 @throws system_error if the folder cannot be created
+	 */
+	int folder(int parent, const string& name){
+		if (mkdirat(parent, name.c_str(), 0755) != 0 && errno != EEXIST){
+			throw system_error(errno, system_category(), "Cannot create folder " + name);
+		}
+		int fd = openat(parent, name.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+		if (fd < 0){
+			throw system_error(errno, system_category(), "Cannot open folder " + name);
+		}
+		items++;
+		return fd;
+	}
+	/**
+	 Create a file. The file is sparse, so its size costs no memory on a tmpfs.
+	 @param parent the descriptor of the folder to create it in
+	 @param name the name of the file
+	 @param size the apparent size of the file in bytes
+	 @throws system_error if the file cannot be created
+	 */
+	void file(int parent, const string& name, uint64_t size){
+		int fd = openat(parent, name.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+		if (fd < 0){
+			throw system_error(errno, system_category(), "Cannot create file " + name);
+		}
+		int result = ftruncate(fd, size);
+		int err = errno;
+		close(fd);
+		if (result != 0){
+			throw system_error(err, system_category(), "Cannot size file " + name);
+		}
+		items++;
+	}
+	/**
+	 Create a symbolic link
+	 @param parent the descriptor of the folder to create it in
+	 @param name the name of the link
+	 @param target what the link points to, which need not exist
+	 @throws system_error if the link cannot be created
+	 */
+	void link(int parent, const string& name, const string& target){
+		if (symlinkat(target.c_str(), parent, name.c_str()) != 0 && errno != EEXIST){
+			throw system_error(errno, system_category(), "Cannot create link " + name);
+		}
+		items++;
+	}
+	/**
+	 Close a folder returned by folder
+	 @param fd the descriptor
+	 */
+	void done(int fd){
+		close(fd);
+	}
+};
+
+/**
+ @param prefix the start of the name
+ @param number the number to append
+ @return a name like "f000042"
+ */
+static string numbered(const char* prefix, uint64_t number){
+	char name[32];
+	snprintf(name, sizeof(name), "%s%06llu", prefix, (unsigned long long)number);
+	return name;
+}
+
+/**
+ @param shape a tree shape
+ @return the name of the shape, also used as the name of its folder
+ */
+const char* shapeName(treeShape shape){
+	switch (shape){
+		case treeShape::wide:
+			return "wide";
+		case treeShape::deep:
+			return "deep";
+		case treeShape::tiny:
+			return "tiny";
+		case treeShape::huge:
+			return "huge";
+		case treeShape::symlinks:
+			return "symlinks";
+	}
+	return "";
+}
+
+/**
+ Create a synthetic tree. The same shape and scale always produce the same names, sizes and links.
+ @param root the folder to create the tree in. It is created if needed, and should be empty.
+ @param shape the kind of tree to create
+ @param scale multiplies the number of items in the tree
+ @return the number of items created, not counting the root
+ @throws system_error if an item cannot be created
+ */
+uint64_t generateTree(const string& root, treeShape shape, unsigned int scale){
+	treeWriter writer;
+	treeRandom random((uint64_t)shape * 7919 + scale);
+	int rootFd = writer.folder(AT_FDCWD, root);
+	writer.items = 0;
+
+	switch (shape){
+		case treeShape::wide:
+			for (int i = 0; i < 4; i++){
+				int fd = writer.folder(rootFd, numbered("d", i));
+				for (uint64_t j = 0; j < 25000ull * scale; j++){
+					writer.file(fd, numbered("f", j), random.below(1 << 20));
+				}
+				writer.done(fd);
+			}
+			break;
+		case treeShape::deep:
+			for (uint64_t i = 0; i < 20ull * scale; i++){
+				int fd = writer.folder(rootFd, numbered("chain", i));
+				for (int depth = 0; depth < 400; depth++){
+					writer.file(fd, "a", random.below(1 << 16));
+					writer.file(fd, "b", random.below(1 << 16));
+					int next = writer.folder(fd, "d");
+					writer.done(fd);
+					fd = next;
+				}
+				writer.done(fd);
+			}
+			break;
+		case treeShape::tiny:
+			for (uint64_t i = 0; i < 1000ull * scale; i++){
+				int fd = writer.folder(rootFd, numbered("d", i));
+				for (int j = 0; j < 100; j++){
+					writer.file(fd, numbered("f", j), random.below(64));
+				}
+				writer.done(fd);
+			}
+			break;
+		case treeShape::huge:
+			for (int i = 0; i < 4; i++){
+				int fd = writer.folder(rootFd, numbered("d", i));
+				for (unsigned int j = 0; j < 16 * scale; j++){
+					writer.file(fd, numbered("f", j), (random.below(16) + 1) << 30);
+				}
+				writer.done(fd);
+			}
+			break;
+		case treeShape::symlinks:
+			for (uint64_t i = 0; i < 100ull * scale; i++){
+				int fd = writer.folder(rootFd, numbered("d", i));
+				for (int j = 0; j < 100; j++){
+					writer.file(fd, numbered("f", j), random.below(1 << 16));
+				}
+				for (int j = 0; j < 400; j++){
+					string name = numbered("l", j);
+					switch (random.below(4)){
+						case 0:
+							writer.link(fd, name, numbered("f", random.below(100)));
+							break;
+						case 1:
+							writer.link(fd, name, "../" + numbered("d", random.below(100ull * scale)));
+							break;
+						case 2:
+							writer.link(fd, name, numbered("missing", j));
+							break;
+						default:
+							writer.link(fd, name, ".");
+							break;
+					}
+				}
+				writer.done(fd);
+			}
+			break;
+	}
+	writer.done(rootFd);
+	return writer.items;
+}
@@ -0,0 +1,31 @@
+//
+//  tree_generator.hpp
+//  bench
+//
+//  Copyright © 2020 Ravbug. All rights reserved.
+//
+
+#pragma once
+#include <string>
+#include <stdint.h>
+
+/**
+ The kinds of synthetic trees the benchmark sizes, each stressing a different part of the sizer
+ */
+enum class treeShape{
+	//a few folders with tens of thousands of files each
+	wide,
+	//long chains of nested folders with a couple of files per level
+	deep,
+	//many folders of very small files
+	tiny,
+	//a handful of very large sparse files
+	huge,
+	//folders where most entries are symbolic links to files, folders, nothing, or themselves
+	symlinks
+};
+
+static constexpr treeShape allShapes[] = {treeShape::wide, treeShape::deep, treeShape::tiny, treeShape::huge, treeShape::symlinks};
+
+const char* shapeName(treeShape);
+uint64_t generateTree(const std::string&, treeShape, unsigned int scale);
@@ -0,0 +1,799 @@
+//
+//  main.cpp
+//  cli
+//
+//  Copyright © 2020 Ravbug. All rights reserved.
+//
+// This file contains the command-line version of FatFileFinder. It sizes a folder with the same
+// sizer as the app, without wxWidgets, and prints the largest items or every item.
+
+#include "../platform.h"
+#include "../folder_sizer.hpp"
+#include "../duplicate_finder.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace std;
+
+enum class outputFormat{
+	table,
+	jsonl,
+	csv
+};
+
+enum class itemFilter{
+	all,
+	files,
+	folders
+};
+
+/**
+ The command line options
+ */
+struct options{
+	string root;
+	size_t top = 20;
+	bool all = false;
+	//print the space each type of file takes instead of items
+	bool types = false;
+	//print the space each user and group owns instead of items
+	bool owners = false;
+	//print groups of files with the same contents instead of items
+	bool duplicates = false;
+	fileSize minimumDuplicate = 1;
+	//print the bytes by how long ago they were last used instead of items
+	bool ages = false;
+	DirectoryTree::ageBasis agesBy = DirectoryTree::ageBasis::used;
+	outputFormat format = outputFormat::table;
+	itemFilter filter = itemFilter::all;
+	unsigned int threads = thread::hardware_concurrency();
+	bool backendSet = false;
+	scanBackend backend = scanBackend::standard;
+	string savePath;
+	DirectoryTree::sizeMode mode = DirectoryTree::sizeMode::apparent;
+	scanLimits limits;
+};
+
+static const char* usage =
+"Usage: FatFileFinder-cli [options] <folder>\n"
+"Size a folder and print its largest items.\n"
+"\n"
+"  -n, --top N            number of items to print (default 20)\n"
+"  -a, --all              print every item instead of the largest. Each top-level\n"
+"                         folder is printed as soon as it is sized, then the\n"
+"                         files directly in <folder>\n"
+"  -T, --types            print the space each category and extension of file takes,\n"
+"                         with at most --top extensions\n"
+"  -O, --owners           print the space each user and group owns, at most --top of each\n"
+"  -D, --duplicates       print the --top groups of files with the same contents,\n"
+"                         the group that frees the most space first\n"
+"      --min-size BYTES   with --duplicates, ignore files smaller than this (default 1)\n"
+"  -A, --ages             print the bytes by how long ago files were last used, then the\n"
+"                         --top folders with the most bytes not used in over a year\n"
+"      --age-by TIME      with --ages, modified, accessed or used, the later of the two (default used)\n"
+"  -f, --format FORMAT    table, jsonl or csv (default table)\n"
+"  -t, --type TYPE        all, files or folders (default all)\n"
+"  -j, --threads N        number of sizing threads (default: one per core)\n"
+"  -b, --backend BACKEND  standard, getdents or uring\n"
+"  -s, --save FILE        also save the scan, so the app can open it without sizing again\n"
+"  -l, --count-links-once count a file with several hard links once, instead of once per link\n"
+"  -d, --disk-usage       show the space items take on disk, like du, instead of their sizes\n"
+"  -x, --one-file-system  do not enter other file systems or mount points\n"
+"  -X, --exclude-type T   comma-separated file system types not to enter,\n"
+"                         or virtual for /proc, /sys and the like\n"
+"  -e, --exclude PATTERN  skip files and folders whose names match a glob, such as node_modules or *.o\n"
+"  -i, --include PATTERN  only size files whose names match a glob. Folders are still entered.\n"
+"      --max-ops N        start at most N stats and folder reads each second\n"
+"      --max-reads N      read at most N folders at once\n"
+"      --low-priority     size at idle I/O priority and the lowest CPU priority\n"
+"  -h, --help             show this message\n";
+
+/**
+ Parse the command line
+ @param argc the number of arguments
+ @param argv the arguments
+ @param opts receives the options
+ @return an error message, or an empty string on success
+ */
+static string parseOptions(int argc, char** argv, options& opts){
+	for (int i = 1; i < argc; i++){
+		string arg = argv[i];
+		//options that take a value
+		auto value = [&]() -> const char*{
+			return i + 1 < argc ? argv[++i] : nullptr;
+		};
+		if (arg == "-h" || arg == "--help"){
+			fputs(usage, stdout);
+			exit(0);
+		}
+		else if (arg == "-a" || arg == "--all"){
+			opts.all = true;
+		}
+		else if (arg == "-T" || arg == "--types"){
+			opts.types = true;
+		}
+		else if (arg == "-O" || arg == "--owners"){
+			opts.owners = true;
+		}
+		else if (arg == "-D" || arg == "--duplicates"){
+			opts.duplicates = true;
+		}
+		else if (arg == "-A" || arg == "--ages"){
+			opts.ages = true;
+		}
+		else if (arg == "--age-by"){
+			const char* v = value();
+			string basis = v != nullptr ? v : "";
+			if (basis == "modified"){
+				opts.agesBy = DirectoryTree::ageBasis::modified;
+			}
+			else if (basis == "accessed"){
+				opts.agesBy = DirectoryTree::ageBasis::accessed;
+			}
+			else if (basis == "used"){
+				opts.agesBy = DirectoryTree::ageBasis::used;
+			}
+			else{
+				return "--age-by needs modified, accessed or used";
+			}
+		}
+		else if (arg == "--min-size"){
+			const char* v = value();
+			if (v == nullptr || atoll(v) <= 0){
+				return "--min-size needs a positive number";
+			}
+			opts.minimumDuplicate = atoll(v);
+		}
+		else if (arg == "-l" || arg == "--count-links-once"){
+			//disk usage already counts links once
+			if (opts.mode == DirectoryTree::sizeMode::apparent){
+				opts.mode = DirectoryTree::sizeMode::linksOnce;
+			}
+		}
+		else if (arg == "-d" || arg == "--disk-usage"){
+			opts.mode = DirectoryTree::sizeMode::allocated;
+		}
+		else if (arg == "-n" || arg == "--top"){
+			const char* v = value();
+			if (v == nullptr || atoll(v) <= 0){
+				return "--top needs a positive number";
+			}
+			opts.top = atoll(v);
+		}
+		else if (arg == "-j" || arg == "--threads"){
+			const char* v = value();
+			if (v == nullptr || atoi(v) <= 0){
+				return "--threads needs a positive number";
+			}
+			opts.threads = atoi(v);
+		}
+		else if (arg == "-f" || arg == "--format"){
+			const char* v = value();
+			string format = v == nullptr ? "" : v;
+			if (format == "table"){
+				opts.format = outputFormat::table;
+			}
+			else if (format == "jsonl"){
+				opts.format = outputFormat::jsonl;
+			}
+			else if (format == "csv"){
+				opts.format = outputFormat::csv;
+			}
+			else{
+				return "--format must be table, jsonl or csv";
+			}
+		}
+		else if (arg == "-t" || arg == "--type"){
+			const char* v = value();
+			string type = v == nullptr ? "" : v;
+			if (type == "all"){
+				opts.filter = itemFilter::all;
+			}
+			else if (type == "files"){
+				opts.filter = itemFilter::files;
+			}
+			else if (type == "folders"){
+				opts.filter = itemFilter::folders;
+			}
+			else{
+				return "--type must be all, files or folders";
+			}
+		}
+		else if (arg == "-b" || arg == "--backend"){
+			const char* v = value();
+			string backend = v == nullptr ? "" : v;
+			opts.backendSet = true;
+			if (backend == "standard"){
+				opts.backend = scanBackend::standard;
+			}
+			else if (backend == "getdents"){
+				opts.backend = scanBackend::getdents;
+			}
+			else if (backend == "uring"){
+				opts.backend = scanBackend::uring;
+			}
+			else{
+				return "--backend must be standard, getdents or uring";
+			}
+		}
+		else if (arg == "-x" || arg == "--one-file-system"){
+			opts.limits.oneFileSystem = true;
+		}
+		else if (arg == "-X" || arg == "--exclude-type"){
+			const char* v = value();
+			if (v == nullptr){
+				return "--exclude-type needs a file system type";
+			}
+			string types = v;
+			for (size_t start = 0; start <= types.size();){
+				size_t end = min(types.find(',', start), types.size());
+				string type = types.substr(start, end - start);
+				if (type == "virtual"){
+					vector<string> all = scanLimits::virtualTypes();
+					opts.limits.excludedTypes.insert(opts.limits.excludedTypes.end(), all.begin(), all.end());
+				}
+				else if (!type.empty()){
+					opts.limits.excludedTypes.push_back(type);
+				}
+				start = end + 1;
+			}
+		}
+		else if (arg == "-e" || arg == "--exclude" || arg == "-i" || arg == "--include"){
+			const char* v = value();
+			if (v == nullptr){
+				return arg + " needs a pattern";
+			}
+			try{
+				if (arg == "-e" || arg == "--exclude"){
+					opts.limits.names.exclude(v);
+				}
+				else{
+					opts.limits.names.include(v);
+				}
+			}
+			catch(invalid_argument& e){
+				return e.what();
+			}
+		}
+		else if (arg == "--max-ops"){
+			const char* v = value();
+			if (v == nullptr || atoll(v) <= 0){
+				return "--max-ops needs a positive number";
+			}
+			opts.limits.rate.operationsPerSecond = (uint32_t)min(atoll(v), (long long)UINT32_MAX);
+		}
+		else if (arg == "--max-reads"){
+			const char* v = value();
+			if (v == nullptr || atoi(v) <= 0){
+				return "--max-reads needs a positive number";
+			}
+			opts.limits.rate.concurrentReads = atoi(v);
+		}
+		else if (arg == "--low-priority"){
+			opts.limits.rate.lowPriority = true;
+		}
+		else if (arg == "-s" || arg == "--save"){
+			const char* v = value();
+			if (v == nullptr){
+				return "--save needs a file";
+			}
+			opts.savePath = v;
+		}
+		else if (arg.size() > 1 && arg[0] == '-'){
+			return "unknown option " + arg;
+		}
+		else if (opts.root.empty()){
+			opts.root = arg;
+		}
+		else{
+			return "only one folder can be sized";
+		}
+	}
+	if (opts.root.empty()){
+		return "no folder given";
+	}
+	return "";
+}
+
+/**
+ Write a string as a JSON string literal
+ @param out the stream to write to
+ @param str the string to write. Bytes that are not valid UTF-8 are written unchanged.
+ */
+static void writeJsonString(FILE* out, const string& str){
+	putc('"', out);
+	for (unsigned char c : str){
+		switch (c){
+			case '"':
+				fputs("\\\"", out);
+				break;
+			case '\\':
+				fputs("\\\\", out);
+				break;
+			case '\n':
+				fputs("\\n", out);
+				break;
+			case '\t':
+				fputs("\\t", out);
+				break;
+			default:
+				if (c < 0x20){
+					fprintf(out, "\\u%04x", c);
+				}
+				else{
+					putc(c, out);
+				}
+		}
+	}
+	putc('"', out);
+}
+
+/**
+ Write a string as a CSV field, quoting it if needed
+ @param out the stream to write to
+ @param str the string to write
+ */
+static void writeCsvField(FILE* out, const string& str){
+	if (str.find_first_of(",\"\r\n") == string::npos){
+		fputs(str.c_str(), out);
+		return;
+	}
+	putc('"', out);
+	for (char c : str){
+		if (c == '"'){
+			putc('"', out);
+		}
+		putc(c, out);
+	}
+	putc('"', out);
+}
+
+/**
+ @param item the item to describe
+ @return the type of an item, as printed
+ */
+static const char* typeOf(const DirectoryData* item){
+	return item->isSymlink ? "symlink" : item->isFolder ? "folder" : "file";
+}
+
+/**
+ Print the column names, if the format has them
+ @param format the output format
+ */
+static void writeHeader(outputFormat format){
+	if (format == outputFormat::csv){
+		fputs("path,type,size,items\n", stdout);
+	}
+	else if (format == outputFormat::table){
+		printf("%14s %10s  %s\n", "Size", "Items", "Path");
+	}
+}
+
+/**
+ Print one item
+ @param format the output format
+ @param item the item to print
+ @param size the size of the item, as counted by the size mode
+ @param path the full path of the item
+ */
+static void writeItem(outputFormat format, const DirectoryData* item, fileSize size, const string& path){
+	switch (format){
+		case outputFormat::table:
+			printf("%14s %10u  %s\n", sizeToString(size).c_str(), item->isFolder ? item->num_items : 1, path.c_str());
+			break;
+		case outputFormat::jsonl:
+			fputs("{\"path\":", stdout);
+			writeJsonString(stdout, path);
+			printf(",\"type\":\"%s\",\"size\":%lld,\"items\":%u}\n", typeOf(item), (long long)size, item->isFolder ? item->num_items : 1);
+			break;
+		case outputFormat::csv:
+			writeCsvField(stdout, path);
+			printf(",%s,%lld,%u\n", typeOf(item), (long long)size, item->isFolder ? item->num_items : 1);
+			break;
+	}
+}
+
+/**
+ Print the space each category and extension of file takes, largest first
+ @param format the output format
+ @param types the counts from sizing
+ @param numExtensions the most extensions to print
+ */
+static void writeTypes(outputFormat format, const typeHistogram& types, size_t numExtensions){
+	typeTotals total = types.total();
+	auto writeRow = [&](const char* kind, const string& name, const typeTotals& totals){
+		double percent = total.bytes > 0 ? (double)totals.bytes / total.bytes * 100 : 0;
+		switch (format){
+			case outputFormat::table:
+				printf("%14s %10llu %7.2f%%  %s\n", sizeToString(totals.bytes).c_str(), (unsigned long long)totals.files, percent, name.c_str());
+				break;
+			case outputFormat::jsonl:
+				printf("{\"%s\":", kind);
+				writeJsonString(stdout, name);
+				printf(",\"size\":%lld,\"files\":%llu,\"percent\":%.2f}\n", (long long)totals.bytes, (unsigned long long)totals.files, percent);
+				break;
+			case outputFormat::csv:
+				printf("%s,", kind);
+				writeCsvField(stdout, name);
+				printf(",%lld,%llu,%.2f\n", (long long)totals.bytes, (unsigned long long)totals.files, percent);
+				break;
+		}
+	};
+	if (format == outputFormat::csv){
+		fputs("kind,name,size,files,percent\n", stdout);
+	}
+	else if (format == outputFormat::table){
+		printf("%14s %10s %8s  %s\n", "Size", "Files", "Percent", "Category");
+	}
+	vector<size_t> order;
+	for (size_t i = 0; i < numCategories; i++){
+		if (types.categories[i].files > 0){
+			order.push_back(i);
+		}
+	}
+	stable_sort(order.begin(), order.end(), [&](size_t a, size_t b){
+		return types.categories[a].bytes > types.categories[b].bytes;
+	});
+	for (size_t i : order){
+		writeRow("category", categoryName((fileCategory)i), types.categories[i]);
+	}
+	if (format == outputFormat::table){
+		printf("\n%14s %10s %8s  %s\n", "Size", "Files", "Percent", "Extension");
+	}
+	for (const auto& [extension, totals] : types.largestExtensions(numExtensions)){
+		writeRow("extension", extensionName(extension), totals);
+	}
+}
+
+/**
+ Print the space each user and group owns, largest first
+ @param format the output format
+ @param owners the counts from sizing
+ @param numOwners the most users, and the most groups, to print
+ */
+static void writeOwners(outputFormat format, const ownerHistogram& owners, size_t numOwners){
+	ownerTotals total = owners.total();
+	auto writeRow = [&](const char* kind, const string& name, const ownerTotals& totals){
+		double percent = total.bytes > 0 ? (double)totals.bytes / total.bytes * 100 : 0;
+		switch (format){
+			case outputFormat::table:
+				printf("%14s %10llu %7.2f%%  %s\n", sizeToString(totals.bytes).c_str(), (unsigned long long)totals.files, percent, name.c_str());
+				break;
+			case outputFormat::jsonl:
+				printf("{\"%s\":", kind);
+				writeJsonString(stdout, name);
+				printf(",\"size\":%lld,\"files\":%llu,\"percent\":%.2f}\n", (long long)totals.bytes, (unsigned long long)totals.files, percent);
+				break;
+			case outputFormat::csv:
+				printf("%s,", kind);
+				writeCsvField(stdout, name);
+				printf(",%lld,%llu,%.2f\n", (long long)totals.bytes, (unsigned long long)totals.files, percent);
+				break;
+		}
+	};
+	if (format == outputFormat::csv){
+		fputs("kind,name,size,files,percent\n", stdout);
+	}
+	else if (format == outputFormat::table){
+		printf("%14s %10s %8s  %s\n", "Size", "Files", "Percent", "User");
+	}
+	for (const auto& [user, totals] : owners.largestUsers(numOwners)){
+		writeRow("user", userName(user), totals);
+	}
+	if (format == outputFormat::table){
+		printf("\n%14s %10s %8s  %s\n", "Size", "Files", "Percent", "Group");
+	}
+	for (const auto& [group, totals] : owners.largestGroups(numOwners)){
+		writeRow("group", groupName(group), totals);
+	}
+}
+
+/**
+ Print groups of duplicate files
+ @param format the output format
+ @param groups the groups, the group that frees the most first
+ @param count the most groups to print
+ */
+static void writeDuplicates(outputFormat format, const vector<duplicateGroup>& groups, size_t count){
+	fileSize reclaimable = 0;
+	for (const duplicateGroup& group : groups){
+		reclaimable += group.reclaimable();
+	}
+	if (format == outputFormat::csv){
+		fputs("group,size,reclaimable,path\n", stdout);
+	}
+	else if (format == outputFormat::table){
+		printf("%14s %14s  %s\n", "Reclaimable", "Size", "Copies");
+	}
+	for (size_t i = 0; i < min(count, groups.size()); i++){
+		const duplicateGroup& group = groups[i];
+		switch (format){
+			case outputFormat::table:
+				printf("%14s %14s  %zu copies\n", sizeToString(group.reclaimable()).c_str(), sizeToString(group.size).c_str(), group.paths.size());
+				for (const string& path : group.paths){
+					printf("%31s%s\n", "", path.c_str());
+				}
+				break;
+			case outputFormat::jsonl:
+				printf("{\"size\":%lld,\"reclaimable\":%lld,\"paths\":[", (long long)group.size, (long long)group.reclaimable());
+				for (size_t j = 0; j < group.paths.size(); j++){
+					if (j > 0){
+						putc(',', stdout);
+					}
+					writeJsonString(stdout, group.paths[j]);
+				}
+				fputs("]}\n", stdout);
+				break;
+			case outputFormat::csv:
+				for (const string& path : group.paths){
+					printf("%zu,%lld,%lld,", i + 1, (long long)group.size, (long long)group.reclaimable());
+					writeCsvField(stdout, path);
+					putc('\n', stdout);
+				}
+				break;
+		}
+	}
+	if (format == outputFormat::table){
+		printf("\n%zu groups of duplicates, %s reclaimable\n", groups.size(), sizeToString(reclaimable).c_str());
+	}
+}
+
+/**
+ Print the bytes of the tree by age, then the folders with the most bytes not used in over a year
+ @param format the output format
+ @param tree the sized tree
+ @param count the most folders to print
+ */
+static void writeAges(outputFormat format, const DirectoryTree& tree, size_t count){
+	//the first bucket of files not used in over a year
+	constexpr size_t stale = 3;
+	auto writeRow = [&](const char* kind, const string& name, fileSize bytes, fileSize of){
+		double percent = of > 0 ? (double)bytes / of * 100 : 0;
+		switch (format){
+			case outputFormat::table:
+				printf("%14s %7.2f%%  %s\n", sizeToString(bytes).c_str(), percent, name.c_str());
+				break;
+			case outputFormat::jsonl:
+				printf("{\"%s\":", kind);
+				writeJsonString(stdout, name);
+				printf(",\"size\":%lld,\"percent\":%.2f}\n", (long long)bytes, percent);
+				break;
+			case outputFormat::csv:
+				printf("%s,", kind);
+				writeCsvField(stdout, name);
+				printf(",%lld,%.2f\n", (long long)bytes, percent);
+				break;
+		}
+	};
+	if (format == outputFormat::csv){
+		fputs("kind,name,size,percent\n", stdout);
+	}
+	else if (format == outputFormat::table){
+		printf("%14s %8s  %s\n", "Size", "Percent", "Last used");
+	}
+	const ageBuckets& total = *tree.agesAt(0);
+	for (size_t i = 0; i < ageBuckets::count; i++){
+		writeRow("age", ageBuckets::name(i), total.bytes[i], total.from(0));
+	}
+
+	//a folder's stale bytes include its subfolders', so folders are ranked the way the largest folders are
+	vector<pair<fileSize, nodeIndex>> folders;
+	vector<nodeIndex> pending{0};
+	while (pending.size() > 0){
+		const DirectoryData* folder = tree.at(pending.back());
+		pending.pop_back();
+		if (folder->isSymlink){
+			continue;
+		}
+		for (uint32_t i = 0; i < folder->numFolders; i++){
+			nodeIndex sub = folder->firstChild + i;
+			folders.push_back({tree.agesAt(sub)->from(stale), sub});
+			pending.push_back(sub);
+		}
+	}
+	count = min(count, folders.size());
+	partial_sort(folders.begin(), folders.begin() + count, folders.end(), [](const pair<fileSize, nodeIndex>& a, const pair<fileSize, nodeIndex>& b){
+		return a.first > b.first;
+	});
+	if (format == outputFormat::table){
+		printf("\n%14s %8s  %s\n", "Over a year", "Percent", "Folder");
+	}
+	for (size_t i = 0; i < count && folders[i].first > 0; i++){
+		writeRow("folder", tree.pathOf(tree.at(folders[i].second)), folders[i].first, tree.agesAt(folders[i].second)->from(0));
+	}
+}
+
+/**
+ @param filter the kinds of items wanted
+ @param item the item to check
+ @return true if the item should be printed
+ */
+static bool wanted(itemFilter filter, const DirectoryData* item){
+	switch (filter){
+		case itemFilter::files:
+			return !item->isFolder;
+		case itemFilter::folders:
+			return item->isFolder;
+		default:
+			return true;
+	}
+}
+
+/**
+ Visit every item below a folder in depth-first order, building each path from its parent's
+ instead of walking up the tree for every item
+ @param tree the tree to walk
+ @param from the folder whose contents to visit
+ @param visit called with each item's index, the item and its full path
+ */
+template<typename visitor>
+static void walk(const DirectoryTree& tree, nodeIndex from, const visitor& visit){
+	const char separator = filesystem::path::preferred_separator;
+	string path = tree.pathOf(tree.at(from));
+	if (path.empty() || path.back() != separator){
+		path += separator;
+	}
+	//items to visit, and the length of their parent's path including the separator
+	vector<pair<nodeIndex, size_t>> pending;
+	auto pushChildren = [&](const DirectoryData* folder, size_t length){
+		if (folder->isSymlink){
+			return;
+		}
+		for (uint32_t i = folder->numChildren(); i > 0; i--){
+			pending.push_back({folder->firstChild + i - 1, length});
+		}
+	};
+	pushChildren(tree.at(from), path.size());
+	while (pending.size() > 0){
+		auto [index, length] = pending.back();
+		pending.pop_back();
+		const DirectoryData* item = tree.at(index);
+		path.resize(length);
+		path += tree.nameOf(item);
+		visit(index, item, path);
+		if (item->isFolder){
+			path += separator;
+			pushChildren(item, path.size());
+		}
+	}
+}
+
+int main(int argc, char** argv){
+	options opts;
+	string error = parseOptions(argc, argv, opts);
+	if (!error.empty()){
+		fprintf(stderr, "FatFileFinder-cli: %s\n\n%s", error.c_str(), usage);
+		return 2;
+	}
+	error_code ec;
+	if (!filesystem::is_directory(opts.root, ec)){
+		fprintf(stderr, "FatFileFinder-cli: %s is not a folder\n", opts.root.c_str());
+		return 1;
+	}
+	//output can be large, write it in big blocks
+	static char outputBuffer[1 << 16];
+	setvbuf(stdout, outputBuffer, _IOFBF, sizeof(outputBuffer));
+
+	auto start = chrono::steady_clock::now();
+	DirectoryTree tree(opts.root);
+	tree.mode = opts.mode;
+	tree.agesBy = opts.agesBy;
+	folderSizer sizer(opts.threads);
+	if (opts.backendSet){
+		sizer.backend = opts.backend;
+	}
+	sizer.limits = opts.limits;
+	//the sizer finds the largest items as it goes, so they need no walk of the tree afterwards
+	sizer.numLargest = opts.all || opts.types || opts.owners || opts.duplicates || opts.ages ? 0 : opts.top;
+	sizer.countTypes = opts.types;
+	sizer.countOwners = opts.owners;
+	auto logError = [](const string& msg){
+		fprintf(stderr, "%s\n", msg.c_str());
+	};
+	//every item is printed while sizing continues, one of the root's subfolders at a time as each finishes
+	bool streaming = opts.all && !opts.types && !opts.owners && !opts.ages && !opts.duplicates;
+	auto writeWanted = [&](nodeIndex index, const DirectoryData* item, const string& path){
+		if (wanted(opts.filter, item)){
+			writeItem(opts.format, item, tree.sizeAt(index), path);
+		}
+	};
+	if (streaming){
+		writeHeader(opts.format);
+		atomic<bool> sized{false};
+		thread sizing([&]{
+			sizer.Size(&tree, 0, logError);
+			sized.store(true, memory_order_release);
+		});
+		vector<nodeIndex> finished;
+		bool last = false;
+		while (!last){
+			last = sized.load(memory_order_acquire);
+			if (!last){
+				this_thread::sleep_for(chrono::milliseconds(50));
+			}
+			finished.clear();
+			sizer.progress.takeFinished(finished);
+			for (nodeIndex folder : finished){
+				writeWanted(folder, tree.at(folder), tree.pathOf(tree.at(folder)));
+				walk(tree, folder, writeWanted);
+			}
+			if (finished.size() > 0){
+				fflush(stdout);
+			}
+		}
+		sizing.join();
+	}
+	else{
+		sizer.Size(&tree, 0, logError);
+	}
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	if (!opts.savePath.empty()){
+		try{
+			tree.save(opts.savePath);
+		}
+		catch(exception& e){
+			fprintf(stderr, "FatFileFinder-cli: cannot save scan: %s\n", e.what());
+		}
+	}
+
+	if (opts.types){
+		writeTypes(opts.format, sizer.types, opts.top);
+	}
+	else if (opts.owners){
+		writeOwners(opts.format, sizer.owners, opts.top);
+	}
+	else if (opts.ages){
+		writeAges(opts.format, tree, opts.top);
+	}
+	else if (opts.duplicates){
+		duplicateFinder finder(opts.threads);
+		finder.minimumSize = opts.minimumDuplicate;
+		vector<duplicateGroup> groups = finder.find(tree, 0, [](const string& msg){
+			fprintf(stderr, "%s\n", msg.c_str());
+		});
+		writeDuplicates(opts.format, groups, opts.top);
+	}
+	else if (streaming){
+		//the root's own files, which are only final once the root has finished
+		const DirectoryData* root = tree.root();
+		const char separator = filesystem::path::preferred_separator;
+		string path = tree.pathOf(root);
+		if (path.empty() || path.back() != separator){
+			path += separator;
+		}
+		for (uint32_t i = root->numFolders; i < root->numChildren(); i++){
+			nodeIndex file = root->firstChild + i;
+			writeWanted(file, tree.at(file), path + tree.nameOf(tree.at(file)));
+		}
+	}
+	else{
+		writeHeader(opts.format);
+		//the largest files and the largest folders are kept separately, so the largest of either kind is among the two lists
+		vector<largestItems::ranked> largest;
+		if (opts.filter != itemFilter::folders){
+			largest.insert(largest.end(), sizer.largest.files().begin(), sizer.largest.files().end());
+		}
+		if (opts.filter != itemFilter::files){
+			largest.insert(largest.end(), sizer.largest.folders().begin(), sizer.largest.folders().end());
+		}
+		stable_sort(largest.begin(), largest.end(), [](const largestItems::ranked& a, const largestItems::ranked& b){
+			return a.size > b.size;
+		});
+		largest.resize(min(largest.size(), opts.top));
+		for (const largestItems::ranked& item : largest){
+			writeItem(opts.format, tree.at(item.index), item.size, item.path);
+		}
+	}
+	if (opts.format == outputFormat::table){
+		const DirectoryData* root = tree.root();
+		printf("\n%s in %u items, sized in %.2f s\n", sizeToString(tree.sizeOf(root)).c_str(), root->num_items, seconds);
+	}
+	return 0;
+}
@@ -0,0 +1,102 @@
+//
+//  dir_reader.cpp
+//  mac
+//
+//  Copyright © 2020 Ravbug. All rights reserved.
+//
+
+#if defined __linux__
+#include "dir_reader.hpp"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+//layout of the records returned by getdents64
+struct linux_dirent64{
+	ino64_t d_ino;
+	off64_t d_off;
+	unsigned short d_reclen;
+	unsigned char d_type;
+	char d_name[];
+};
+
+/**
+ Create a directory reader
+ @param bufferSize the number of bytes to request from the kernel in each batch
+ */
+directoryReader::directoryReader(size_t bufferSize) : buffer(bufferSize){}
+
+directoryReader::~directoryReader(){
+	close();
+}
+
+/**
+ Open a directory for reading, closing the previously open directory
+ @param path the path to the directory
+ @return true if the directory was opened, false otherwise (see error())
+ */
+bool directoryReader::open(const std::string& path){
+	close();
+	dirfd = ::open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (dirfd < 0){
+		err = errno;
+		return false;
+	}
+	return true;
+}
+
+/**
+ Read the next entry from the directory, skipping . and ..
+ @param item the entry to populate
+ @return true if an entry was read, false at the end of the directory or on error (see error())
+ */
+bool directoryReader::next(entry& item){
+	while(true){
+		if (pos >= end){
+			long read = syscall(SYS_getdents64, dirfd, buffer.data(), buffer.size());
+			if (read <= 0){
+				err = read < 0 ? errno : 0;
+				return false;
+			}
+			pos = 0;
+			end = read;
+		}
+		linux_dirent64* d = (linux_dirent64*)(buffer.data() + pos);
+		pos += d->d_reclen;
+		//skip the self and parent entries
+		if (d->d_name[0] == '.' && (d->d_name[1] == '\0' || (d->d_name[1] == '.' && d->d_name[2] == '\0'))){
+			continue;
+		}
+		item.name = d->d_name;
+		item.type = d->d_type;
+		return true;
+	}
+}
+
+/**
+ Stat an entry relative to the open directory
+ @param name the name of the entry
+ @param buf the stat struct to populate
+ @param follow true to follow symbolic links, false to stat the link itself
+ @return true on success
+ */
+bool directoryReader::stat(const char* name, struct stat& buf, bool follow) const{
+	return fstatat(dirfd, name, &buf, follow ? 0 : AT_SYMLINK_NOFOLLOW) == 0;
+}
+
+/**
+ Close the open directory, if any
+ */
+void directoryReader::close(){
+	if (dirfd >= 0){
+		::close(dirfd);
+	}
+	dirfd = -1;
+	err = 0;
+	pos = 0;
+	end = 0;
+}
+#endif
@@ -0,0 +1,55 @@
+//
+//  dir_reader.hpp
+//  mac
+//
+//  Copyright © 2020 Ravbug. All rights reserved.
+//
+
+#pragma once
+#if defined __linux__
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+
+/**
+ Reads the entries of a directory in large batches using getdents64.
+ The directory is opened once, and entries can be stat'ed relative to its file descriptor,
+ so the kernel does not need to resolve the full path of every item.
+ */
+class directoryReader{
+public:
+	struct entry{
+		//points into the reader's buffer, valid until the next call to next()
+		const char* name;
+		//DT_ constant from dirent.h. May be DT_UNKNOWN on filesystems that do not report types.
+		unsigned char type;
+	};
+
+	directoryReader(size_t bufferSize = 128 * 1024);
+	~directoryReader();
+
+	bool open(const std::string&);
+	bool next(entry&);
+	bool stat(const char*, struct stat&, bool follow = false) const;
+	void close();
+
+	/**
+	 @return the file descriptor of the open directory, or -1 if none is open
+	 */
+	int fd() const{
+		return dirfd;
+	}
+	/**
+	 @return the errno of the last failed operation, or 0 if there was none
+	 */
+	int error() const{
+		return err;
+	}
+private:
+	int dirfd = -1;
+	int err = 0;
+	std::vector<char> buffer;
+	size_t pos = 0;
+	size_t end = 0;
+};
+#endif
@@ -0,0 +1,338 @@
+//
+//  duplicate_finder.cpp
+//  mac
+//
+//  Copyright © 2020 Ravbug. All rights reserved.
+//
+
+#include "duplicate_finder.hpp"
+#include "hash64.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <system_error>
+#if defined _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+//bytes hashed from each end of a file before deciding whether to read the rest
+static constexpr size_t endBytes = 4096;
+//bytes read at once when hashing a whole file
+static constexpr size_t readBytes = 1 << 20;
+
+/**
+ A file opened for reading. Symbolic links are not followed, so a link is never read as its target.
+ */
+class readOnlyFile{
+public:
+	/**
+	 Open a file, and tell the system it will be read from start to end
+	 @param path the path to the file
+	 */
+	readOnlyFile(const string& path){
+#if defined _WIN32
+		handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN | FILE_FLAG_OPEN_REPARSE_POINT, nullptr);
+		if (handle == INVALID_HANDLE_VALUE){
+			handle = nullptr;
+			err = GetLastError();
+		}
+#else
+		fd = open(path.c_str(), O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+		if (fd < 0){
+			err = errno;
+			return;
+		}
+#if defined __linux__
+		posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#elif defined __APPLE__
+		fcntl(fd, F_RDAHEAD, 1);
+#endif
+#endif
+	}
+	~readOnlyFile(){
+#if defined _WIN32
+		if (handle != nullptr){
+			CloseHandle(handle);
+		}
+#else
+		if (fd >= 0){
+			close(fd);
+		}
+#endif
+	}
+	readOnlyFile(const readOnlyFile&) = delete;
+	readOnlyFile& operator=(const readOnlyFile&) = delete;
+
+	/**
+	 @return the error from opening or reading the file, or 0
+	 */
+	int error() const{
+		return err;
+	}
+
+	/**
+	 @return true if the file could not be opened because it is a symbolic link
+	 */
+	bool isLink() const{
+#if defined _WIN32
+		return false;
+#else
+		return err == ELOOP;
+#endif
+	}
+
+	/**
+	 Read bytes from a position in the file, retrying short reads
+	 @param buffer receives the bytes
+	 @param length the number of bytes to read
+	 @param offset the position of the first byte
+	 @return true if every byte was read. False if the file could not be read, or is now shorter.
+	 */
+	bool read(unsigned char* buffer, size_t length, uint64_t offset){
+		if (err != 0){
+			return false;
+		}
+		while (length > 0){
+#if defined _WIN32
+			OVERLAPPED position = {};
+			position.Offset = (DWORD)offset;
+			position.OffsetHigh = (DWORD)(offset >> 32);
+			DWORD count = 0;
+			if (!ReadFile(handle, buffer, (DWORD)min<size_t>(length, UINT32_MAX), &count, &position)){
+				err = GetLastError();
+				return false;
+			}
+#else
+			ssize_t count = pread(fd, buffer, length, offset);
+			if (count < 0){
+				if (errno == EINTR){
+					continue;
+				}
+				err = errno;
+				return false;
+			}
+#endif
+			if (count == 0){
+				return false;
+			}
+			buffer += count;
+			length -= count;
+			offset += count;
+		}
+		return true;
+	}
+
+private:
+#if defined _WIN32
+	HANDLE handle = nullptr;
+#else
+	int fd = -1;
+#endif
+	int err = 0;
+};
+
+/**
+ Create a duplicate finder
+ @param threads the number of files to read at once. If 0, one is read at a time.
+ */
+duplicateFinder::duplicateFinder(unsigned int threads){
+	numThreads = max(threads, 1u);
+}
+
+/**
+ Find the files below a folder that have the same contents. Blocks until every stage has finished, or the search was stopped.
+ @param tree a sized tree, which must not change during the search
+ @param folder the folder to search
+ @param logCallback the function to call with the files that could not be read. Invoked from the reading threads.
+ @return the groups of duplicates, the group that frees the most bytes first
+ */
+vector<duplicateGroup> duplicateFinder::find(const DirectoryTree& tree, nodeIndex folder, const logCallback& logCallback){
+	log = &logCallback;
+	filesRead = 0;
+	bytesRead = 0;
+
+	//files can only match files of the same size, so most are ruled out before anything is read
+	vector<pair<fileSize, nodeIndex>> files;
+	vector<nodeIndex> folders{folder};
+	while (folders.size() > 0){
+		const DirectoryData* item = tree.at(folders.back());
+		folders.pop_back();
+		if (item->isSymlink){
+			continue;
+		}
+		for (uint32_t i = 0; i < item->numFolders; i++){
+			folders.push_back(item->firstChild + i);
+		}
+		for (uint32_t i = item->numFolders; i < item->numChildren(); i++){
+			nodeIndex file = item->firstChild + i;
+			//a hard link to a file counted elsewhere shares its contents, and removing it frees nothing
+			fileSize size = tree.at(file)->size;
+			if (size >= minimumSize && *tree.linkedAt(file) == 0){
+				files.push_back({size, file});
+			}
+		}
+	}
+	sort(files.begin(), files.end());
+	vector<candidate> candidates;
+	for (size_t start = 0, end; start < files.size(); start = end){
+		for (end = start + 1; end < files.size() && files[end].first == files[start].first; end++);
+		if (end - start < 2){
+			continue;
+		}
+		for (size_t i = start; i < end; i++){
+			candidate c;
+			c.path = tree.pathOf(tree.at(files[i].second));
+			c.size = files[i].first;
+			candidates.push_back(move(c));
+		}
+	}
+	files = {};
+
+	//hash the ends of files of equal size. Small files are read whole.
+	forEach(candidates, [&](candidate& c, vector<unsigned char>& buffer){
+		hashEnds(c, buffer);
+	});
+	keepMatches(candidates);
+
+	//only files whose ends match are read in full, the largest first so that the threads finish together
+	for (candidate& c : candidates){
+		c.ok = c.whole;
+	}
+	stable_sort(candidates.begin(), candidates.end(), [](const candidate& a, const candidate& b){
+		return a.size > b.size;
+	});
+	forEach(candidates, [&](candidate& c, vector<unsigned char>& buffer){
+		if (!c.whole){
+			hashWhole(c, buffer);
+		}
+	});
+	keepMatches(candidates);
+
+	vector<duplicateGroup> groups;
+	for (size_t start = 0, end; start < candidates.size(); start = end){
+		duplicateGroup group{candidates[start].size, candidates[start].hash, {}};
+		for (end = start; end < candidates.size() && candidates[end].size == group.size && candidates[end].hash == group.hash; end++){
+			group.paths.push_back(move(candidates[end].path));
+		}
+		sort(group.paths.begin(), group.paths.end());
+		groups.push_back(move(group));
+	}
+	stable_sort(groups.begin(), groups.end(), [](const duplicateGroup& a, const duplicateGroup& b){
+		return a.reclaimable() > b.reclaimable();
+	});
+	log = nullptr;
+	return groups;
+}
+
+/**
+ Run a stage on every candidate, spread over the threads. Each thread has its own read buffer.
+ Candidates not reached before the search is stopped are left unread.
+ @param candidates the files to process
+ @param work called with each candidate and the calling thread's buffer
+ */
+void duplicateFinder::forEach(vector<candidate>& candidates, const function<void(candidate&, vector<unsigned char>&)>& work){
+	pending = candidates.size();
+	atomic<size_t> next{0};
+	auto worker = [&]{
+		vector<unsigned char> buffer(readBytes);
+		for (size_t i = next++; i < candidates.size(); i = next++){
+			if (!control.checkpoint()){
+				return;
+			}
+			work(candidates[i], buffer);
+			--pending;
+		}
+	};
+	vector<thread> threads;
+	for (unsigned int i = 1; i < min<size_t>(numThreads, candidates.size()); i++){
+		threads.emplace_back(worker);
+	}
+	worker();
+	for (thread& t : threads){
+		t.join();
+	}
+	pending = 0;
+}
+
+/**
+ Hash the first and last blocks of a file, or the whole file if it is no larger than the two blocks
+ @param c the file to hash
+ @param buffer space for the blocks
+ */
+void duplicateFinder::hashEnds(candidate& c, vector<unsigned char>& buffer){
+	readOnlyFile file(c.path);
+	hash64 h;
+	if ((uint64_t)c.size <= 2 * endBytes){
+		c.ok = file.read(buffer.data(), c.size, 0);
+		h.update(buffer.data(), c.size);
+		c.whole = true;
+	}
+	else{
+		c.ok = file.read(buffer.data(), endBytes, 0) && file.read(buffer.data() + endBytes, endBytes, c.size - endBytes);
+		h.update(buffer.data(), 2 * endBytes);
+	}
+	if (!c.ok){
+		//links are listed as files, but are not compared
+		if (!file.isLink()){
+			Log("Cannot compare " + c.path + "\n" + (file.error() != 0 ? system_category().message(file.error()) : "The file changed while it was read"));
+		}
+		return;
+	}
+	c.hash = h.digest();
+	filesRead.fetch_add(1, memory_order_relaxed);
+	bytesRead.fetch_add(min<fileSize>(c.size, 2 * endBytes), memory_order_relaxed);
+}
+
+/**
+ Hash a whole file in large sequential reads. The search can be stopped part way through a large file.
+ @param c the file to hash
+ @param buffer space for each read
+ */
+void duplicateFinder::hashWhole(candidate& c, vector<unsigned char>& buffer){
+	readOnlyFile file(c.path);
+	hash64 h;
+	for (uint64_t offset = 0; offset < (uint64_t)c.size; offset += buffer.size()){
+		if (control.cancelled()){
+			return;
+		}
+		size_t length = (size_t)min<uint64_t>(buffer.size(), c.size - offset);
+		if (!file.read(buffer.data(), length, offset)){
+			Log("Cannot compare " + c.path + "\n" + (file.error() != 0 ? system_category().message(file.error()) : "The file changed while it was read"));
+			return;
+		}
+		h.update(buffer.data(), length);
+		bytesRead.fetch_add(length, memory_order_relaxed);
+	}
+	c.hash = h.digest();
+	c.whole = true;
+	c.ok = true;
+	filesRead.fetch_add(1, memory_order_relaxed);
+}
+
+/**
+ Keep only the files that were read and share their size and hash with another file, grouped together
+ @param candidates the files to filter
+ */
+void duplicateFinder::keepMatches(vector<candidate>& candidates){
+	candidates.erase(remove_if(candidates.begin(), candidates.end(), [](const candidate& c){
+		return !c.ok;
+	}), candidates.end());
+	sort(candidates.begin(), candidates.end(), [](const candidate& a, const candidate& b){
+		return a.size != b.size ? a.size < b.size : a.hash < b.hash;
+	});
+	size_t kept = 0;
+	for (size_t start = 0, end; start < candidates.size(); start = end){
+		for (end = start + 1; end < candidates.size() && candidates[end].size == candidates[start].size && candidates[end].hash == candidates[start].hash; end++);
+		if (end - start < 2){
+			continue;
+		}
+		for (size_t i = start; i < end; i++, kept++){
+			if (kept != i){
+				candidates[kept] = move(candidates[i]);
+			}
+		}
+	}
+	candidates.resize(kept);
+}
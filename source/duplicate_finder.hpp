@@ -0,0 +1,86 @@
+//
+//  duplicate_finder.hpp
+//  mac
+//
+//  Copyright © 2020 Ravbug. All rights reserved.
+//
+
+#pragma once
+#include "folder_sizer.hpp"
+#include <atomic>
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ Files found to have the same contents
+ */
+struct duplicateGroup{
+	//the size of each copy
+	fileSize size;
+	//the hash of the contents
+	uint64_t hash;
+	//the copies, sorted
+	vector<string> paths;
+
+	/**
+	 @return the bytes that would be freed by keeping only one copy
+	 */
+	fileSize reclaimable() const{
+		return size * (fileSize)(paths.size() - 1);
+	}
+};
+
+/**
+ Finds files with the same contents in a sized tree. Each stage only reads the files that the previous stage could not tell apart:
+ first files are grouped by size, which needs no reading. Then the first and last blocks of files of equal size are hashed.
+ Only files that still match are read in full, in large sequential reads. Reads are spread over a pool of threads.
+ Files that are hard links to a file counted elsewhere, and symbolic links, are never reported, since removing them frees nothing.
+ */
+class duplicateFinder{
+public:
+	//lets another thread stop the search, in which case the groups confirmed so far are returned
+	scanControl control;
+	//files smaller than this are not compared
+	fileSize minimumSize = 1;
+	//files waiting to be read in the current stage, and files and bytes read so far
+	atomic<uint64_t> pending{0};
+	atomic<uint64_t> filesRead{0};
+	atomic<uint64_t> bytesRead{0};
+
+	duplicateFinder(unsigned int threads = thread::hardware_concurrency());
+
+	vector<duplicateGroup> find(const DirectoryTree&, nodeIndex, const logCallback&);
+
+private:
+	/**
+	 A file that might have a duplicate
+	 */
+	struct candidate{
+		string path;
+		fileSize size;
+		uint64_t hash = 0;
+		//true once the hash covers the whole file
+		bool whole = false;
+		//true once the file has been hashed, false if it could not be read or was not reached before a stop
+		bool ok = false;
+	};
+
+	unsigned int numThreads;
+	const logCallback* log = nullptr;
+
+	void forEach(vector<candidate>&, const function<void(candidate&, vector<unsigned char>&)>&);
+	void hashEnds(candidate&, vector<unsigned char>&);
+	void hashWhole(candidate&, vector<unsigned char>&);
+	static void keepMatches(vector<candidate>&);
+
+	/**
+	 Send a message to the log callback, if one was provided
+	 @param msg the string to log
+	 */
+	void Log(const string& msg){
+		if (log != nullptr && *log != nullptr){
+			(*log)(msg);
+		}
+	}
+};
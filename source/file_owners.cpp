@@ -0,0 +1,138 @@
+//
+//  file_owners.cpp
+//  mac
+//
+//  Copyright © 2020 Ravbug. All rights reserved.
+//
+
+#include "file_owners.hpp"
+#include <algorithm>
+#if !defined _WIN32
+#include <cerrno>
+#include <grp.h>
+#include <pwd.h>
+#endif
+using namespace std;
+
+/**
+ @param id a user id
+ @return the user's name, or the id if the user is not known, such as on another machine or on Windows
+ */
+string userName(uint32_t id){
+#if defined _WIN32
+	return to_string(id);
+#else
+	vector<char> buffer(1024);
+	struct passwd entry;
+	struct passwd* found = nullptr;
+	while (getpwuid_r((uid_t)id, &entry, buffer.data(), buffer.size(), &found) == ERANGE){
+		buffer.resize(buffer.size() * 2);
+	}
+	return found != nullptr ? string(found->pw_name) : to_string(id);
+#endif
+}
+
+/**
+ @param id a group id
+ @return the group's name, or the id if the group is not known, such as on another machine or on Windows
+ */
+string groupName(uint32_t id){
+#if defined _WIN32
+	return to_string(id);
+#else
+	vector<char> buffer(1024);
+	struct group entry;
+	struct group* found = nullptr;
+	while (getgrgid_r((gid_t)id, &entry, buffer.data(), buffer.size(), &found) == ERANGE){
+		buffer.resize(buffer.size() * 2);
+	}
+	return found != nullptr ? string(found->gr_name) : to_string(id);
+#endif
+}
+
+/**
+ Forget every count
+ */
+void ownerHistogram::clear(){
+	users.clear();
+	groups.clear();
+}
+
+/**
+ Add the counts of another histogram to this one
+ @param other the histogram to add
+ */
+void ownerHistogram::merge(const ownerHistogram& other){
+	for (const auto& [user, totals] : other.users){
+		users[user].add(totals);
+	}
+	for (const auto& [group, totals] : other.groups){
+		groups[group].add(totals);
+	}
+}
+
+/**
+ Count every file below a folder from the owners stored in the tree, such as for a folder other than the one that was sized
+ @param tree the tree
+ @param folder the folder to count, sizes are counted by the tree's size mode
+ */
+void ownerHistogram::addTree(const DirectoryTree& tree, nodeIndex folder){
+	vector<nodeIndex> pending{folder};
+	while (pending.size() > 0){
+		const DirectoryData* item = tree.at(pending.back());
+		pending.pop_back();
+		if (item->isSymlink){
+			continue;
+		}
+		for (uint32_t i = 0; i < item->numFolders; i++){
+			pending.push_back(item->firstChild + i);
+		}
+		for (uint32_t i = item->numFolders; i < item->numChildren(); i++){
+			nodeIndex file = item->firstChild + i;
+			add(*tree.ownerAt(file), tree.sizeAt(file));
+		}
+	}
+}
+
+/**
+ @return the totals of every file counted. Each file has one user, so the users' totals add up to it.
+ */
+ownerTotals ownerHistogram::total() const{
+	ownerTotals sum;
+	for (const auto& [user, totals] : users){
+		sum.add(totals);
+	}
+	return sum;
+}
+
+/**
+ @param owners the users or the groups
+ @param count the most owners to return
+ @return the owners with the most bytes, largest first
+ */
+static vector<pair<uint32_t, ownerTotals>> largestOf(const unordered_map<uint32_t, ownerTotals>& owners, size_t count){
+	vector<pair<uint32_t, ownerTotals>> sorted(owners.begin(), owners.end());
+	auto larger = [](const pair<uint32_t, ownerTotals>& a, const pair<uint32_t, ownerTotals>& b){
+		return a.second.bytes != b.second.bytes ? a.second.bytes > b.second.bytes : a.first < b.first;
+	};
+	count = min(count, sorted.size());
+	partial_sort(sorted.begin(), sorted.begin() + count, sorted.end(), larger);
+	sorted.resize(count);
+	return sorted;
+}
+
+/**
+ @param count the most users to return
+ @return the users with the most bytes, largest first
+ */
+vector<pair<uint32_t, ownerTotals>> ownerHistogram::largestUsers(size_t count) const{
+	return largestOf(users, count);
+}
+
+/**
+ @param count the most groups to return
+ @return the groups with the most bytes, largest first
+ */
+vector<pair<uint32_t, ownerTotals>> ownerHistogram::largestGroups(size_t count) const{
+	return largestOf(groups, count);
+}
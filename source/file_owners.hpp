@@ -0,0 +1,63 @@
+//
+//  file_owners.hpp
+//  mac
+//
+//  Copyright © 2020 Ravbug. All rights reserved.
+//
+
+#pragma once
+#include "DirectoryData.hpp"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+std::string userName(uint32_t);
+std::string groupName(uint32_t);
+
+/**
+ Bytes and files owned by one user or group
+ */
+struct ownerTotals{
+	fileSize bytes = 0;
+	uint64_t files = 0;
+
+	void add(const ownerTotals& other){
+		bytes += other.bytes;
+		files += other.files;
+	}
+};
+
+/**
+ Totals of the files of a tree, or part of one, by the user and by the group that own them
+ */
+class ownerHistogram{
+public:
+	std::unordered_map<uint32_t, ownerTotals> users;
+	std::unordered_map<uint32_t, ownerTotals> groups;
+
+	/**
+	 Count a file
+	 @param owner the file's owner
+	 @param size the file's size
+	 */
+	void add(const itemOwner& owner, fileSize size){
+		ownerTotals& user = users[owner.user];
+		user.bytes += size;
+		user.files++;
+		ownerTotals& group = groups[owner.group];
+		group.bytes += size;
+		group.files++;
+	}
+	/**
+	 @return true if no files were counted
+	 */
+	bool empty() const{
+		return users.empty();
+	}
+	void clear();
+	void merge(const ownerHistogram&);
+	void addTree(const DirectoryTree&, nodeIndex);
+	ownerTotals total() const;
+	std::vector<std::pair<uint32_t, ownerTotals>> largestUsers(size_t) const;
+	std::vector<std::pair<uint32_t, ownerTotals>> largestGroups(size_t) const;
+};
@@ -0,0 +1,220 @@
+//
+//  file_types.cpp
+//  mac
+//
+//  Copyright © 2020 Ravbug. All rights reserved.
+//
+
+#include "file_types.hpp"
+#include <algorithm>
+using namespace std;
+
+/**
+ Pack an extension into a key at compile time
+ @param extension a lowercase extension of at most 8 characters, without the dot
+ @return the key
+ */
+static constexpr uint64_t pack(const char* extension){
+	uint64_t key = 0;
+	for (unsigned int i = 0; extension[i] != '\0'; i++){
+		key |= (uint64_t)(unsigned char)extension[i] << (8 * i);
+	}
+	return key;
+}
+
+struct categoryEntry{
+	uint64_t extension;
+	fileCategory category;
+};
+
+//the extensions with a category. Anything else is other.
+static constexpr categoryEntry knownExtensions[] = {
+	{pack("exe"), fileCategory::program}, {pack("dll"), fileCategory::program}, {pack("bat"), fileCategory::program}, {pack("jar"), fileCategory::program},
+	{pack("msi"), fileCategory::program}, {pack("so"), fileCategory::program}, {pack("dylib"), fileCategory::program}, {pack("app"), fileCategory::program},
+	{pack("iso"), fileCategory::diskImage}, {pack("bin"), fileCategory::diskImage}, {pack("img"), fileCategory::diskImage}, {pack("dmg"), fileCategory::diskImage},
+	{pack("vhd"), fileCategory::diskImage}, {pack("vhdx"), fileCategory::diskImage}, {pack("vmdk"), fileCategory::diskImage}, {pack("qcow2"), fileCategory::diskImage},
+	{pack("ai"), fileCategory::image}, {pack("bmp"), fileCategory::image}, {pack("gif"), fileCategory::image}, {pack("ico"), fileCategory::image},
+	{pack("jpeg"), fileCategory::image}, {pack("jpg"), fileCategory::image}, {pack("png"), fileCategory::image}, {pack("psd"), fileCategory::image},
+	{pack("svg"), fileCategory::image}, {pack("tif"), fileCategory::image}, {pack("tiff"), fileCategory::image}, {pack("webp"), fileCategory::image},
+	{pack("heic"), fileCategory::image}, {pack("raw"), fileCategory::image}, {pack("cr2"), fileCategory::image}, {pack("nef"), fileCategory::image},
+	{pack("mp3"), fileCategory::audio}, {pack("aif"), fileCategory::audio}, {pack("aiff"), fileCategory::audio}, {pack("ogg"), fileCategory::audio},
+	{pack("wav"), fileCategory::audio}, {pack("wma"), fileCategory::audio}, {pack("m4a"), fileCategory::audio}, {pack("flac"), fileCategory::audio},
+	{pack("opus"), fileCategory::audio}, {pack("aac"), fileCategory::audio},
+	{pack("mp4"), fileCategory::video}, {pack("avi"), fileCategory::video}, {pack("flv"), fileCategory::video}, {pack("h264"), fileCategory::video},
+	{pack("m4v"), fileCategory::video}, {pack("mkv"), fileCategory::video}, {pack("mov"), fileCategory::video}, {pack("mpg"), fileCategory::video},
+	{pack("mpeg"), fileCategory::video}, {pack("wmv"), fileCategory::video}, {pack("webm"), fileCategory::video}, {pack("ts"), fileCategory::video},
+	{pack("7z"), fileCategory::archive}, {pack("arj"), fileCategory::archive}, {pack("pkg"), fileCategory::archive}, {pack("rar"), fileCategory::archive},
+	{pack("rpm"), fileCategory::archive}, {pack("deb"), fileCategory::archive}, {pack("tar"), fileCategory::archive}, {pack("gz"), fileCategory::archive},
+	{pack("tgz"), fileCategory::archive}, {pack("bz2"), fileCategory::archive}, {pack("xz"), fileCategory::archive}, {pack("zst"), fileCategory::archive},
+	{pack("z"), fileCategory::archive}, {pack("zip"), fileCategory::archive},
+	{pack("doc"), fileCategory::document}, {pack("docx"), fileCategory::document}, {pack("odt"), fileCategory::document}, {pack("pdf"), fileCategory::document},
+	{pack("rtf"), fileCategory::document}, {pack("tex"), fileCategory::document}, {pack("txt"), fileCategory::document}, {pack("md"), fileCategory::document},
+	{pack("xls"), fileCategory::document}, {pack("xlsx"), fileCategory::document}, {pack("ods"), fileCategory::document}, {pack("ppt"), fileCategory::document},
+	{pack("pptx"), fileCategory::document}, {pack("odp"), fileCategory::document}, {pack("epub"), fileCategory::document},
+};
+static constexpr size_t numKnownExtensions = sizeof(knownExtensions) / sizeof(knownExtensions[0]);
+
+/**
+ @param extension a key from classifyName
+ @return the category of files with the extension
+ */
+fileCategory categoryOf(uint64_t extension){
+	//sorted once, for binary search
+	static const array<categoryEntry, numKnownExtensions> table = []{
+		array<categoryEntry, numKnownExtensions> sorted;
+		copy(begin(knownExtensions), end(knownExtensions), sorted.begin());
+		sort(sorted.begin(), sorted.end(), [](const categoryEntry& a, const categoryEntry& b){
+			return a.extension < b.extension;
+		});
+		return sorted;
+	}();
+	if (extension == noExtension){
+		return fileCategory::none;
+	}
+	auto found = lower_bound(table.begin(), table.end(), extension, [](const categoryEntry& entry, uint64_t key){
+		return entry.extension < key;
+	});
+	return found != table.end() && found->extension == extension ? found->category : fileCategory::other;
+}
+
+/**
+ Classify a file by its extension, the characters after the last dot, ignoring case.
+ As with std::filesystem, a name whose only dot is its first character has no extension.
+ Does not allocate or throw, so it can be called for every file while sizing.
+ @param name the file's name, without its folder
+ @return the file's type
+ */
+fileType classifyName(string_view name){
+	size_t dot = name.rfind('.');
+	if (dot == string_view::npos || dot == 0 || dot + 1 == name.size()){
+		return {noExtension, fileCategory::none};
+	}
+	string_view extension = name.substr(dot + 1);
+	if (extension.size() > 8){
+		return {longExtension, fileCategory::other};
+	}
+	uint64_t key = 0;
+	for (size_t i = 0; i < extension.size(); i++){
+		unsigned char c = extension[i];
+		if (c >= 'A' && c <= 'Z'){
+			c += 'a' - 'A';
+		}
+		key |= (uint64_t)c << (8 * i);
+	}
+	return {key, categoryOf(key)};
+}
+
+/**
+ @param extension a key from classifyName
+ @return the extension with its dot, such as .mkv, or a description for the special keys
+ */
+string extensionName(uint64_t extension){
+	if (extension == noExtension){
+		return "(no extension)";
+	}
+	if (extension == longExtension){
+		return "(long extensions)";
+	}
+	string name = ".";
+	for (; extension != 0; extension >>= 8){
+		name += (char)(extension & 0xff);
+	}
+	return name;
+}
+
+/**
+ @param category a category
+ @return the category's name, for display
+ */
+const char* categoryName(fileCategory category){
+	switch (category){
+		case fileCategory::none:
+			return "No extension";
+		case fileCategory::program:
+			return "Programs";
+		case fileCategory::diskImage:
+			return "Disk images";
+		case fileCategory::image:
+			return "Images";
+		case fileCategory::audio:
+			return "Audio";
+		case fileCategory::video:
+			return "Video";
+		case fileCategory::archive:
+			return "Archives";
+		case fileCategory::document:
+			return "Documents";
+		default:
+			return "Other";
+	}
+}
+
+/**
+ Remove every count
+ */
+void typeHistogram::clear(){
+	categories.fill(typeTotals());
+	extensions.clear();
+}
+
+/**
+ Add the counts of another histogram to this one
+ @param other the histogram to add
+ */
+void typeHistogram::merge(const typeHistogram& other){
+	for (size_t i = 0; i < numCategories; i++){
+		categories[i].add(other.categories[i]);
+	}
+	for (const auto& [extension, totals] : other.extensions){
+		extensions[extension].add(totals);
+	}
+}
+
+/**
+ Count every file below a folder, for trees that were not sized with a histogram, such as a scan opened from a file
+ @param tree the tree
+ @param folder the folder to count, sizes are counted by the tree's size mode
+ */
+void typeHistogram::addTree(const DirectoryTree& tree, nodeIndex folder){
+	vector<nodeIndex> pending{folder};
+	while (pending.size() > 0){
+		const DirectoryData* item = tree.at(pending.back());
+		pending.pop_back();
+		if (item->isSymlink){
+			continue;
+		}
+		for (uint32_t i = 0; i < item->numFolders; i++){
+			pending.push_back(item->firstChild + i);
+		}
+		for (uint32_t i = item->numFolders; i < item->numChildren(); i++){
+			nodeIndex file = item->firstChild + i;
+			add(classifyName(tree.nameOf(tree.at(file))), tree.sizeAt(file));
+		}
+	}
+}
+
+/**
+ @return the totals of every file counted
+ */
+typeTotals typeHistogram::total() const{
+	typeTotals sum;
+	for (const typeTotals& category : categories){
+		sum.add(category);
+	}
+	return sum;
+}
+
+/**
+ @param count the most extensions to return
+ @return the extensions with the most bytes, largest first
+ */
+vector<pair<uint64_t, typeTotals>> typeHistogram::largestExtensions(size_t count) const{
+	vector<pair<uint64_t, typeTotals>> sorted(extensions.begin(), extensions.end());
+	auto larger = [](const pair<uint64_t, typeTotals>& a, const pair<uint64_t, typeTotals>& b){
+		return a.second.bytes != b.second.bytes ? a.second.bytes > b.second.bytes : a.first < b.first;
+	};
+	count = min(count, sorted.size());
+	partial_sort(sorted.begin(), sorted.begin() + count, sorted.end(), larger);
+	sorted.resize(count);
+	return sorted;
+}
@@ -0,0 +1,98 @@
+//
+//  file_types.hpp
+//  mac
+//
+//  Copyright © 2020 Ravbug. All rights reserved.
+//
+
+#pragma once
+#include "DirectoryData.hpp"
+#include <array>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ Broad kinds of file, decided by extension
+ */
+enum class fileCategory : uint8_t{
+	//the name has no extension
+	none,
+	program,
+	diskImage,
+	image,
+	audio,
+	video,
+	archive,
+	document,
+	//an extension that is not in any other category
+	other
+};
+static constexpr size_t numCategories = (size_t)fileCategory::other + 1;
+
+/**
+ The type of a file, read from its name
+ */
+struct fileType{
+	//the extension, lowercased and packed one byte per character, see extensionName
+	uint64_t extension;
+	fileCategory category;
+};
+
+//extension key for names without an extension
+static constexpr uint64_t noExtension = 0;
+//extension key for extensions longer than 8 characters, which are not told apart. 0xff never appears in UTF-8.
+static constexpr uint64_t longExtension = ~0ull;
+
+fileCategory categoryOf(uint64_t);
+fileType classifyName(std::string_view);
+std::string extensionName(uint64_t);
+const char* categoryName(fileCategory);
+
+/**
+ Bytes and files of one type
+ */
+struct typeTotals{
+	fileSize bytes = 0;
+	uint64_t files = 0;
+
+	void add(const typeTotals& other){
+		bytes += other.bytes;
+		files += other.files;
+	}
+};
+
+/**
+ Totals of the files of a tree, or part of one, by category and by extension
+ */
+class typeHistogram{
+public:
+	std::array<typeTotals, numCategories> categories;
+	std::unordered_map<uint64_t, typeTotals> extensions;
+
+	/**
+	 Count a file
+	 @param type the file's type
+	 @param size the file's size
+	 */
+	void add(const fileType& type, fileSize size){
+		typeTotals& category = categories[(size_t)type.category];
+		category.bytes += size;
+		category.files++;
+		typeTotals& extension = extensions[type.extension];
+		extension.bytes += size;
+		extension.files++;
+	}
+	/**
+	 @return true if no files were counted
+	 */
+	bool empty() const{
+		return extensions.empty();
+	}
+	void clear();
+	void merge(const typeHistogram&);
+	void addTree(const DirectoryTree&, nodeIndex);
+	typeTotals total() const;
+	std::vector<std::pair<uint64_t, typeTotals>> largestExtensions(size_t) const;
+};
@@ -5,18 +5,735 @@
 //  Copyright © 2019 Ravbug. All rights reserved.
 //
 
-#include "globals.h"
+#include "platform.h"
 #include "folder_sizer.hpp"
 #include <filesystem>
 #include <array>
+#include <algorithm>
+#include <ctime>
+#if defined __linux__
+#include "dir_reader.hpp"
+#include "uring_stat.hpp"
+#include <dirent.h>
+#include <string.h>
+#include <fstream>
+#include <sstream>
+#include <sys/sysmacros.h>
+#endif
 
 using namespace std::filesystem;
 
 
 //constructor and destructor
-folderSizer::folderSizer(wxWindow* Parent)
+/**
+ Create a folder sizer
+ @param threads the number of worker threads to size with. If 0, a single worker is used.
+ */
+folderSizer::folderSizer(unsigned int threads)
 {
-	ParentWindow = Parent;
+	numThreads = max(threads, 1u);
+	for (unsigned int i = 0; i < numThreads; i++){
+		queues.push_back(make_unique<workQueue>());
+	}
 }
 folderSizer::~folderSizer(){}
 
+/**
+ Calculate the size of a folder, including the size of subfolders. Blocks until the whole tree has been sized.
+ @param folderTree the tree containing the folder
+ @param folder the index of the folder to size. It is sized in place, replacing any previous contents.
+ @param logCallback the function to call with error messages. Invoked from the worker threads.
+ @note progress is reset when sizing starts, and can be read from any thread while sizing
+ */
+void folderSizer::Size(DirectoryTree* folderTree, nodeIndex folder, const logCallback& logCallback){
+	tree = folderTree;
+	root = folder;
+	log = &logCallback;
+	//ages are measured from when the whole tree was last sized, so that a folder sized on its own agrees with its neighbors
+	if (root == 0 || tree->agesFrom == 0){
+		tree->agesFrom = time(nullptr);
+		tree->agesMode = tree->mode;
+	}
+	progress.reset();
+	links.clear();
+	readLimits();
+	largest.reset(numThreads, numLargest);
+	workerCounts.clear();
+	workerCounts.resize(numThreads);
+	limiter.setRate(limits.rate.operationsPerSecond);
+
+	outstanding = 1;
+	queued = 1;
+	queues[0]->items.push_back(folder);
+
+	//each worker reads one folder at a time, so fewer workers means fewer reads at once
+	unsigned int numWorkers = limits.rate.concurrentReads > 0 ? min(numThreads, limits.rate.concurrentReads) : numThreads;
+	vector<thread> workers;
+	for (unsigned int i = 0; i < numWorkers; i++){
+		workers.emplace_back(&folderSizer::workerLoop, this, i);
+	}
+	for (thread& worker : workers){
+		worker.join();
+	}
+	largest.merge(*tree);
+	types.clear();
+	owners.clear();
+	for (const workerHistograms& counts : workerCounts){
+		types.merge(counts.types);
+		owners.merge(counts.owners);
+	}
+	workerCounts.clear();
+
+	tree = nullptr;
+	root = noNode;
+	log = nullptr;
+}
+
+/**
+ Size folders until there are none left, stealing from the other workers when this worker runs out
+ @param id the index of this worker's queue
+ */
+void folderSizer::workerLoop(unsigned int id){
+	if (limits.rate.lowPriority){
+		lower_thread_priority();
+	}
+	while(true){
+		nodeIndex folder = next(id);
+		if (folder != noNode){
+			//after a stop, the remaining folders are finished without being read
+			sizeFolder(id, folder, control.checkpoint());
+			continue;
+		}
+		//nothing to take, wait for more work or for the sizing to finish
+		unique_lock<mutex> lock(idleLock);
+		++numIdle;
+		idleCondition.wait(lock, [&]{
+			return queued > 0 || outstanding == 0;
+		});
+		--numIdle;
+		if (outstanding == 0){
+			return;
+		}
+	}
+}
+
+/**
+ Add a folder to a worker's queue
+ @param id the index of the queue to add to
+ @param folder the folder to size
+ */
+void folderSizer::push(unsigned int id, nodeIndex folder){
+	{
+		lock_guard<mutex> lock(queues[id]->lock);
+		queues[id]->items.push_back(folder);
+	}
+	++queued;
+	if (numIdle > 0){
+		wake(false);
+	}
+}
+
+/**
+ Take the next folder to size. Uses the worker's own queue first, and otherwise steals from the others.
+ @param id the index of the worker's queue
+ @return the folder to size, or noNode if all the queues are empty
+ */
+nodeIndex folderSizer::next(unsigned int id){
+	for (unsigned int i = 0; i < numThreads; i++){
+		workQueue& queue = *queues[(id + i) % numThreads];
+		lock_guard<mutex> lock(queue.lock);
+		if (queue.items.size() > 0){
+			nodeIndex folder;
+			//own queue: newest first, for locality. Other queues: oldest first, for large subtrees
+			if (i == 0){
+				folder = queue.items.back();
+				queue.items.pop_back();
+			}
+			else{
+				folder = queue.items.front();
+				queue.items.pop_front();
+			}
+			--queued;
+			return folder;
+		}
+	}
+	return noNode;
+}
+
+/**
+ Wake idle workers
+ @param all true to wake all workers, false to wake one
+ */
+void folderSizer::wake(bool all){
+	//taking the lock ensures a worker cannot miss the notification between testing and waiting
+	{
+		lock_guard<mutex> lock(idleLock);
+	}
+	if (all){
+		idleCondition.notify_all();
+	}
+	else{
+		idleCondition.notify_one();
+	}
+}
+
+/**
+ Read the stamp of a folder
+ @param folderPath the path to the folder
+ @param fd the folder's open file descriptor, or -1 to stat the folder by its path
+ @param stamp populated with the folder's stamp
+ @param allocated set to the bytes the folder's own entries take on disk, read from the same stat
+ @param times set to the folder's own times, read from the same stat
+ @param owner set to the folder's own owner, read from the same stat
+ @param mode set to the folder's own mode, read from the same stat
+ @return true if the stamp was read. Stamps are not available on Windows.
+ */
+static bool readStamp(const string& folderPath, int fd, folderStamp& stamp, fileSize& allocated, itemTimes& times, itemOwner& owner, itemMode& mode){
+#if defined _WIN32
+	return false;
+#else
+	struct stat info;
+	if ((fd >= 0 ? fstat(fd, &info) : stat(folderPath.c_str(), &info)) != 0){
+		return false;
+	}
+#if defined __APPLE__
+	stamp.mtime = (int64_t)info.st_mtimespec.tv_sec * 1000000000 + info.st_mtimespec.tv_nsec;
+	stamp.ctime = (int64_t)info.st_ctimespec.tv_sec * 1000000000 + info.st_ctimespec.tv_nsec;
+#else
+	stamp.mtime = (int64_t)info.st_mtim.tv_sec * 1000000000 + info.st_mtim.tv_nsec;
+	stamp.ctime = (int64_t)info.st_ctim.tv_sec * 1000000000 + info.st_ctim.tv_nsec;
+#endif
+	stamp.inode = info.st_ino;
+	stamp.device = info.st_dev;
+	allocated = allocated_size(info);
+	times = {info.st_mtime, info.st_atime, info.st_ctime};
+	owner = {(uint32_t)info.st_uid, (uint32_t)info.st_gid};
+	mode = {(uint32_t)info.st_mode, (uint32_t)info.st_nlink};
+	return true;
+#endif
+}
+
+#if defined __linux__
+/**
+ An entry of /proc/self/mountinfo
+ */
+struct mountEntry{
+	uint64_t device;
+	string mountPoint;
+	string type;
+};
+
+/**
+ @param field a path from /proc/self/mountinfo, where spaces and other special characters are written as octal escapes
+ @return the path
+ */
+static string unescapeMountPath(const string& field){
+	string result;
+	for (size_t i = 0; i < field.size(); i++){
+		if (field[i] == '\\' && i + 3 < field.size()){
+			result += (char)stoi(field.substr(i + 1, 3), nullptr, 8);
+			i += 3;
+		}
+		else{
+			result += field[i];
+		}
+	}
+	return result;
+}
+
+/**
+ Read the mounts visible to this process
+ @return the mounts, or nothing if /proc is not mounted
+ */
+static vector<mountEntry> readMounts(){
+	vector<mountEntry> mounts;
+	ifstream in("/proc/self/mountinfo");
+	string line;
+	while (getline(in, line)){
+		//id parent major:minor root mount-point options [optional fields...] - type source super-options
+		istringstream fields(line);
+		string id, parent, device, root, mountPoint, options, field;
+		fields >> id >> parent >> device >> root >> mountPoint >> options;
+		while (fields >> field && field != "-");
+		mountEntry entry;
+		unsigned int major, minor;
+		if (!(fields >> entry.type) || sscanf(device.c_str(), "%u:%u", &major, &minor) != 2){
+			continue;
+		}
+		entry.device = makedev(major, minor);
+		entry.mountPoint = unescapeMountPath(mountPoint);
+		mounts.push_back(entry);
+	}
+	return mounts;
+}
+#endif
+
+/**
+ Wait until operations may start, when the rate is limited. Returns early if sizing is stopped.
+ @param operations the number of stats or folder reads about to start
+ */
+void folderSizer::pace(uint64_t operations){
+	if (limiter.limited() && operations > 0){
+		control.waitUntil(limiter.reserve(operations));
+	}
+}
+
+/**
+ Read what the limits need before sizing starts: the device of the tree's root, and the devices
+ and mount points of the file systems not to enter
+ */
+void folderSizer::readLimits(){
+	excludedDevices.clear();
+	mountPoints.clear();
+	folderStamp stamp;
+	fileSize allocated;
+	itemTimes times;
+	itemOwner owner;
+	itemMode mode;
+	rootDevice = limits.oneFileSystem && readStamp(tree->pathOf(tree->root()), -1, stamp, allocated, times, owner, mode) ? stamp.device : 0;
+#if defined __linux__
+	if (!limits.oneFileSystem && limits.excludedTypes.empty()){
+		return;
+	}
+	//mount points are listed resolved, so they are spelled the way the tree spells its paths before they are compared
+	string rootPath = tree->pathOf(tree->root());
+	std::error_code ec;
+	string resolvedRoot = canonical(path(rootPath), ec).string();
+	if (ec){
+		resolvedRoot = rootPath;
+	}
+	for (const mountEntry& mount : readMounts()){
+		if (find(limits.excludedTypes.begin(), limits.excludedTypes.end(), mount.type) != limits.excludedTypes.end()){
+			excludedDevices.insert(mount.device);
+		}
+		string mountPoint = respell_path(mount.mountPoint, resolvedRoot, rootPath);
+		if (limits.oneFileSystem && !mountPoint.empty()){
+			mountPoints.insert(mountPoint);
+		}
+	}
+#endif
+}
+
+/**
+ @param index the folder about to be read
+ @param folderPath the path to the folder
+ @param stamp the folder's stamp
+ @return true if the folder should not be entered
+ @note the folder the sizing started from is always entered, unless limitRoot is set
+ */
+bool folderSizer::outsideLimits(nodeIndex index, const string& folderPath, const folderStamp& stamp) const{
+	if ((index == root && !limitRoot) || !stamp.valid()){
+		return false;
+	}
+	if (excludedDevices.count(stamp.device) > 0){
+		return true;
+	}
+	if (limits.oneFileSystem){
+		//bind mounts can share the root's device, so mount points are checked by path as well
+		return (rootDevice != 0 && stamp.device != rootDevice) || mountPoints.count(folderPath) > 0;
+	}
+	return false;
+}
+
+/**
+ Size the immediate contents of a folder, and queue its subfolders
+ @param id the index of the calling worker
+ @param index the folder to size
+ @param read false to keep the folder's current contents without touching the disk, as when sizing was stopped
+ */
+void folderSizer::sizeFolder(unsigned int id, nodeIndex index, bool read){
+	//each worker reuses its buffers
+	thread_local folderContents contents;
+	contents.clear();
+	
+	DirectoryData* folder = tree->at(index);
+	string folderPath = tree->pathOf(folder);
+	progress.current.store(index, memory_order_release);
+	
+	//subfolders are classified when their parent is enumerated, but the root is not
+	if (index == root && read){
+		std::error_code ec;
+		folder->isSymlink = is_symlink(path(folderPath),ec);
+	}
+	
+	//in an incremental rescan, a folder whose entries have not changed keeps its files and subfolders from the last scan
+	folderStamp stamp;
+	fileSize ownAllocated = 0;
+	itemTimes* times = tree->timesAt(index);
+	int fd = -1;
+	if (read && !folder->isSymlink){
+		pace(1);
+	}
+#if defined __linux__
+	thread_local directoryReader reader;
+	reader.close();
+	bool linuxBackend = backend == scanBackend::getdents || backend == scanBackend::uring;
+	//the Linux backends open the folder anyway, so the stamp is read from the open folder rather than resolving its path twice.
+	//A folder stamped by the last scan is likely unchanged and is stat'ed without opening it, and so is any folder the limits
+	//may leave out, because opening a mount point can mount it.
+	bool openFirst = read && !folder->isSymlink && linuxBackend && !(incremental && tree->stampAt(index)->valid()) && !limits.oneFileSystem && excludedDevices.empty();
+	if (openFirst){
+		reader.open(folderPath);
+		fd = reader.fd();
+	}
+#endif
+	bool stamped = read && !folder->isSymlink && readStamp(folderPath, fd, stamp, ownAllocated, *times, *tree->ownerAt(index), *tree->modeAt(index));
+	//a folder on another file system is listed as empty
+	bool outside = stamped && outsideLimits(index, folderPath, stamp);
+	if (outside){
+		ownAllocated = 0;
+	}
+	folderStamp* previous = tree->stampAt(index);
+	bool unchanged = incremental && stamped && !outside && previous->valid() && *previous == stamp;
+	
+	if (read && !unchanged){
+		//skip symbolic links
+		if (!folder->isSymlink && !outside){
+			//calculate the size of the immediate files in the folder
+			try{
+				switch(backend){
+#if defined __linux__
+					case scanBackend::getdents:
+					case scanBackend::uring:
+						sizeImmediateLinux(folderPath, reader, contents);
+						break;
+#endif
+					default:
+						if (!path_too_long(folderPath)){
+							sizeImmediate(folderPath, contents);
+						}
+						break;
+				}
+			}
+			catch(filesystem_error& e){
+				//notify user
+				Log("Error sizing directory " + folderPath + "\n" + e.what());
+			}
+		}
+		folder->files_size = contents.files_size;
+		tree->setChildren(index, contents.names.data(), contents.folders, contents.files, incremental);
+		*tree->linkedAt(index) = contents.linked_size;
+		*tree->allocatedAt(index) = ownAllocated + contents.allocated_size;
+	}
+	else{
+		//the files were kept, and finishFolder adds the subfolders. A folder that was not read has none, unless it is being rescanned.
+		fileSize linkedFiles = 0;
+		fileSize allocatedFiles = 0;
+		for (uint32_t i = folder->numFolders; i < folder->numChildren(); i++){
+			linkedFiles += *tree->linkedAt(folder->firstChild + i);
+			allocatedFiles += *tree->allocatedAt(folder->firstChild + i);
+		}
+		*tree->linkedAt(index) = linkedFiles;
+		*tree->allocatedAt(index) = ownAllocated + allocatedFiles;
+	}
+	//the files have their final sizes and times, whether they were read or kept. finishFolder adds the subfolders' ages.
+	ageBuckets* ages = tree->agesAt(index);
+	*ages = ageBuckets();
+	workerHistograms& counts = workerCounts[id];
+	for (uint32_t i = folder->numFolders; i < folder->numChildren(); i++){
+		nodeIndex file = folder->firstChild + i;
+		fileSize size = tree->sizeAt(file);
+		if (largest.enabled()){
+			largest.offer(id, false, size, file);
+		}
+		if (countTypes){
+			counts.types.add(classifyName(tree->nameOf(tree->at(file))), size);
+		}
+		if (countOwners){
+			counts.owners.add(*tree->ownerAt(file), size);
+		}
+		ages->bytes[tree->ageBucketAt(file)] += size;
+	}
+	//a folder that was not read gets no stamp, so that a rescan reads it
+	*previous = stamped && !outside ? stamp : folderStamp();
+	progress.bytes.fetch_add(max<fileSize>(folder->files_size - 1, 0), memory_order_relaxed);
+	progress.items.fetch_add(folder->numChildren(), memory_order_relaxed);
+	progress.folders.fetch_add(1, memory_order_relaxed);
+	if (index == root){
+		progress.total = folder->numFolders;
+	}
+
+	//one count for each subfolder, plus one for this folder's own files
+	*tree->pendingAt(index) = folder->numFolders + 1;
+	outstanding += folder->numFolders;
+	for (uint32_t i = 0; i < folder->numFolders; i++){
+		push(id, folder->firstChild + i);
+	}
+	finishFolder(id, index);
+
+	if (--outstanding == 0){
+		wake(true);
+	}
+}
+
+/**
+ Calculate the size of the immediate files in the folder
+ @param folderPath the path to the folder
+ @param contents populated with the folder's contents
+ */
+void folderSizer::sizeImmediate(const string& folderPath, folderContents& contents){
+	pace(1);
+	// iterate through the items in the folder
+	for(auto& p : directory_iterator(folderPath,directory_options::skip_permission_denied)){
+		//is the item a folder? if so, defer sizing it
+		//check if can read the file
+		try {
+			//skipped entries are never stat'ed
+			string filename = p.path().filename().string();
+			if (limits.names.excludes(filename)){
+				continue;
+			}
+			//status, and the stat of a file
+			pace(2);
+			file_status s = status(p.path());
+			if (/*!is_symlink(s) &&*/ can_access(s))
+			{
+				if (is_directory(p)) {
+					contents.folders.push_back({contents.addName(filename.c_str()), 0, p.is_symlink()});
+				}
+				else if (limits.names.includesFile(filename)) {
+					//size the file, add its details to the structure
+					addFile(contents, contents.addName(filename.c_str()), get_stat(p.path().string()));
+				}
+			}
+		}
+		catch (filesystem_error& e) {
+			Log("Error sizing file " + p.path().string() + "\n" + e.what());
+		}
+	}
+}
+
+#if defined __linux__
+/**
+ Calculate the size of the immediate files in the folder using getdents64.
+ The folder is opened once. Subfolders are identified by their entry type without a stat,
+ and every other item is stat'ed once relative to the folder, either directly with fstatat,
+ or as a single batch through io_uring.
+ @param folderPath the path to the folder
+ @param reader the worker's reader, which may already have the folder open, or have failed to open it
+ @param contents populated with the folder's contents
+ */
+void folderSizer::sizeImmediateLinux(const string& folderPath, directoryReader& reader, folderContents& contents){
+	//each worker keeps its own buffers and ring
+	thread_local unique_ptr<statRing> ring;
+	thread_local vector<size_t> offsets;
+	thread_local vector<statRing::request> requests;
+	
+	if (reader.fd() < 0 && reader.error() == 0){
+		pace(1);
+		reader.open(folderPath);
+	}
+	if (reader.fd() < 0){
+		//match directory_options::skip_permission_denied. Names come from the kernel's own listing, so only the whole path can be too long.
+		if (reader.error() == EACCES || reader.error() == ENAMETOOLONG){
+			return;
+		}
+		throw filesystem_error("Cannot open directory", folderPath, error_code(reader.error(), system_category()));
+	}
+	
+	//folders are sized later, no need to stat them here. Collect everything else.
+	offsets.clear();
+	directoryReader::entry item;
+	//entries skipped by name are dropped here, before they are stat'ed
+	bool filtered = !limits.names.empty();
+	while(reader.next(item)){
+		if (filtered && limits.names.excludes(item.name)){
+			continue;
+		}
+		if (item.type == DT_DIR){
+			contents.folders.push_back({contents.addName(item.name), 0, false});
+		}
+		else if (!filtered || item.type != DT_REG || limits.names.includesFile(item.name)){
+			offsets.push_back(contents.addName(item.name));
+		}
+	}
+	if (reader.error() != 0){
+		Log("Error reading directory " + folderPath + "\n" + strerror(reader.error()));
+	}
+	
+	//stat the collected entries
+	pace(offsets.size());
+	requests.resize(offsets.size());
+	for (size_t i = 0; i < offsets.size(); i++){
+		requests[i].name = contents.names.data() + offsets[i];
+	}
+	bool batched = false;
+	if (backend == scanBackend::uring && requests.size() > 0){
+		if (ring == nullptr){
+			ring = make_unique<statRing>();
+		}
+		batched = ring->ok() && ring->statAll(reader.fd(), requests);
+	}
+	if (!batched){
+		for (statRing::request& req : requests){
+			req.error = reader.stat(req.name, req.result) ? 0 : errno;
+		}
+	}
+	
+	for (size_t i = 0; i < requests.size(); i++){
+		const statRing::request& req = requests[i];
+		if (req.error != 0){
+			Log("Error sizing file " + folderPath + "/" + req.name + "\n" + strerror(req.error));
+			continue;
+		}
+		const struct stat& buf = req.result;
+		if (S_ISDIR(buf.st_mode)){
+			contents.folders.push_back({offsets[i], 0, false});
+			continue;
+		}
+		if (S_ISLNK(buf.st_mode)){
+			//links to folders are listed as folders but not followed, links to anything else are sized as files. Following the link is another stat.
+			struct stat target;
+			pace(1);
+			if (reader.stat(req.name, target, true)){
+				if (!can_access(target.st_mode)){
+					continue;
+				}
+				if (S_ISDIR(target.st_mode)){
+					contents.folders.push_back({offsets[i], 0, true});
+					continue;
+				}
+			}
+		}
+		else if (!can_access(buf.st_mode)){
+			continue;
+		}
+		//entries of unknown type are only known to be files once stat'ed
+		if (filtered && !limits.names.includesFile(req.name)){
+			continue;
+		}
+		//size the file, add its details to the structure
+		addFile(contents, offsets[i], buf);
+	}
+	reader.close();
+}
+#endif
+
+/**
+ Add a file to a folder's contents. A file with several hard links is marked as a duplicate
+ if another of its links was already counted while sizing, and takes no space on disk.
+ @param contents the folder's contents
+ @param name the offset of the file's name
+ @param info the result of stat'ing the file
+ */
+void folderSizer::addFile(folderContents& contents, size_t name, const struct stat& info){
+	fileSize size = info.st_size;
+	//Windows reports no inode numbers, so links cannot be told apart
+	bool duplicate = info.st_nlink > 1 && info.st_ino != 0 && !links.insert(info.st_dev, info.st_ino);
+	fileSize allocated = duplicate ? 0 : allocated_size(info);
+	contents.files_size += size;
+	contents.allocated_size += allocated;
+	if (duplicate){
+		contents.linked_size += size;
+	}
+	contents.files.push_back({name, size, false, duplicate, allocated, {info.st_mtime, info.st_atime, info.st_ctime}, {(uint32_t)info.st_uid, (uint32_t)info.st_gid}, {(uint32_t)info.st_mode, (uint32_t)info.st_nlink}});
+}
+
+/**
+ Called when a folder's files, or one of its subfolders, has finished sizing.
+ Once everything in the folder has finished, its totals are calculated and its parent is notified.
+ @param id the index of the calling worker
+ @param index the folder to update
+ */
+void folderSizer::finishFolder(unsigned int id, nodeIndex index){
+	DirectoryData* folder = tree->at(index);
+	if (--*tree->pendingAt(index) > 0){
+		return;
+	}
+
+	//all subfolders are complete, calculate the totals
+	fileSize* linked = tree->linkedAt(index);
+	fileSize* allocated = tree->allocatedAt(index);
+	ageBuckets* ages = tree->agesAt(index);
+	if (folder->isSymlink){
+		folder->size = 1;
+		*linked = 0;
+		*allocated = 0;
+		*ages = ageBuckets();
+	}
+	else{
+		folder->size = folder->files_size;
+	}
+	folder->num_items = folder->numFiles;
+	for (uint32_t i = 0; i < folder->numFolders; i++){
+		DirectoryData* sub = tree->folderOf(folder, i);
+		folder->num_items += sub->num_items + 1;
+		folder->size += sub->size;
+		*linked += *tree->linkedAt(folder->firstChild + i);
+		*allocated += *tree->allocatedAt(folder->firstChild + i);
+		ages->add(*tree->agesAt(folder->firstChild + i));
+	}
+	//check for zero size
+	if (folder->size == 0){
+		folder->size = 1;
+	}
+
+	if (index == root){
+		progress.done.store(true, memory_order_release);
+		return;
+	}
+	if (!folder->isSymlink){
+		largest.offer(id, true, tree->sizeAt(index), index);
+	}
+	if (folder->parent == root){
+		progress.addFinished(index);
+	}
+	finishFolder(id, folder->parent);
+}
+
+/**
+ Clear the counters before sizing
+ */
+void sizeProgress::reset(){
+	lock_guard<mutex> lock(finishedLock);
+	finished.clear();
+	bytes = 0;
+	items = 0;
+	folders = 0;
+	current = noNode;
+	completed = 0;
+	total = 0;
+	done = false;
+}
+
+/**
+ Take a copy of the counters. Safe to call from any thread while sizing.
+ The counters are read individually, so they may be a few folders apart from each other.
+ @return the progress so far
+ */
+progressSnapshot sizeProgress::read() const{
+	progressSnapshot snapshot;
+	snapshot.done = done.load(memory_order_acquire);
+	snapshot.bytes = bytes.load(memory_order_relaxed);
+	snapshot.items = items.load(memory_order_relaxed);
+	snapshot.folders = folders.load(memory_order_relaxed);
+	snapshot.current = current.load(memory_order_acquire);
+	uint32_t numTotal = total.load(memory_order_relaxed);
+	if (snapshot.done){
+		snapshot.fraction = 1;
+	}
+	else if (numTotal > 0){
+		snapshot.fraction = (float)completed.load(memory_order_relaxed) / numTotal;
+	}
+	return snapshot;
+}
+
+/**
+ Record that one of the root's immediate subfolders has finished. Called by the workers.
+ @param folder the subfolder that finished
+ */
+void sizeProgress::addFinished(nodeIndex folder){
+	lock_guard<mutex> lock(finishedLock);
+	finished.push_back(folder);
+	completed.fetch_add(1, memory_order_release);
+}
+
+/**
+ Move the subfolders that finished since the last call into a vector
+ @param out receives the finished subfolders, in the order they finished
+ */
+void sizeProgress::takeFinished(vector<nodeIndex>& out){
+	lock_guard<mutex> lock(finishedLock);
+	out.insert(out.end(), finished.begin(), finished.end());
+	finished.clear();
+}
@@ -10,8 +10,21 @@
 #include <stdio.h>
 #include <functional>
 #include <vector>
-#include <wx/event.h>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+#include <unordered_set>
 #include "DirectoryData.hpp"
+#include "inode_set.hpp"
+#include "name_filter.hpp"
+#include "rate_limiter.hpp"
+#include "largest_items.hpp"
+#include "file_types.hpp"
+#include "file_owners.hpp"
+#include "dir_reader.hpp"
 using namespace std;
 
 #ifdef __APPLE__
@@ -22,17 +35,321 @@ using namespace std;
 #else
 #endif
 
+/**
+ The ways folderSizer can read folders
+ */
+enum class scanBackend{
+	//std::filesystem::directory_iterator, available everywhere
+	standard,
+	//getdents64 + fstatat relative to the folder (Linux only)
+	getdents,
+	//getdents64 + statx batches submitted through io_uring (Linux only), falls back to getdents if unavailable
+	uring
+};
+
+/**
+ Limits on how hard a folderSizer works the disk, so that sizing can run beside other programs
+ */
+struct scanRate{
+	//the most stats and folder reads to start each second across all workers, or 0 for no limit
+	uint32_t operationsPerSecond = 0;
+	//the most folders to read at once, or 0 for one per worker
+	unsigned int concurrentReads = 0;
+	//lower the workers' I/O and CPU priority
+	bool lowPriority = false;
+};
+
+/**
+ Limits on which items a folderSizer reads, and how quickly. A folder on a file system outside the limits is listed, but not read.
+ An entry skipped by name is not listed at all.
+ */
+struct scanLimits{
+	//stay on the file system of the tree's root, and do not enter other mount points, such as bind mounts
+	bool oneFileSystem = false;
+	//types of file system, as named in /proc/self/mountinfo, whose folders are not entered (Linux only)
+	vector<string> excludedTypes;
+	//checked on each entry's name before it is stat'ed
+	nameFilter names;
+	scanRate rate;
+
+	/**
+	 @return the types of the kernel's virtual file systems, such as /proc and /sys, which hold no files worth sizing
+	 */
+	static vector<string> virtualTypes(){
+		return {"proc", "sysfs", "devtmpfs", "devpts", "cgroup", "cgroup2", "securityfs", "debugfs", "tracefs", "pstore", "bpf",
+			"configfs", "fusectl", "mqueue", "hugetlbfs", "binfmt_misc", "efivarfs", "selinuxfs", "autofs", "rpc_pipefs", "nsfs"};
+	}
+};
+
+/**
+ A copy of the sizing progress at one moment, taken with sizeProgress::read
+ */
+struct progressSnapshot{
+	//fraction of the root's immediate subfolders that have finished
+	float fraction = 0;
+	//bytes of files found so far
+	fileSize bytes = 0;
+	//files and folders found so far
+	uint64_t items = 0;
+	//folders read so far
+	uint64_t folders = 0;
+	//the folder most recently started by a worker, or noNode
+	nodeIndex current = noNode;
+	//true once the whole tree has been sized
+	bool done = false;
+};
+
+/**
+ Progress of a folderSizer. Workers update the counters as they go, and the UI reads them
+ whenever it redraws, so the cost to the UI does not depend on the shape of the tree.
+ The counters are lock-free. Only the list of finished subfolders of the root takes a lock,
+ once per subfolder.
+ */
+class sizeProgress{
+public:
+	atomic<fileSize> bytes{0};
+	atomic<uint64_t> items{0};
+	atomic<uint64_t> folders{0};
+	atomic<nodeIndex> current{noNode};
+	atomic<uint32_t> completed{0};
+	atomic<uint32_t> total{0};
+	atomic<bool> done{false};
+
+	void reset();
+	progressSnapshot read() const;
+	void addFinished(nodeIndex);
+	void takeFinished(vector<nodeIndex>&);
+
+private:
+	mutex finishedLock;
+	vector<nodeIndex> finished;
+};
+
+/**
+ Lets another thread stop or pause a sizing. Workers check it before each folder, so a folder that
+ has started is always finished, and the tree stays consistent.
+ */
+class scanControl{
+public:
+	/**
+	 Stop sizing. Folders not yet read are left empty, and parked workers are woken.
+	 */
+	void cancel(){
+		{
+			lock_guard<mutex> guard(lock);
+			stop = true;
+		}
+		resumed.notify_all();
+	}
+	/**
+	 Park the workers before they start their next folder
+	 */
+	void pause(){
+		lock_guard<mutex> guard(lock);
+		hold = true;
+	}
+	/**
+	 Let parked workers continue
+	 */
+	void resume(){
+		{
+			lock_guard<mutex> guard(lock);
+			hold = false;
+		}
+		resumed.notify_all();
+	}
+	/**
+	 Clear a previous stop or pause, before sizing again
+	 */
+	void reset(){
+		lock_guard<mutex> guard(lock);
+		stop = false;
+		hold = false;
+	}
+	/**
+	 @return true if sizing was stopped
+	 */
+	bool cancelled() const{
+		return stop.load(memory_order_relaxed);
+	}
+	/**
+	 @return true if sizing is paused
+	 */
+	bool paused() const{
+		return hold.load(memory_order_relaxed);
+	}
+	/**
+	 Called by a worker before it starts a folder. Waits while sizing is paused.
+	 @return false if sizing was stopped
+	 */
+	bool checkpoint(){
+		if (hold.load(memory_order_relaxed)){
+			unique_lock<mutex> guard(lock);
+			resumed.wait(guard, [&]{
+				return !hold || stop;
+			});
+		}
+		return !stop.load(memory_order_relaxed);
+	}
+	/**
+	 Wait until a time, or until sizing is stopped
+	 @param when the time to wait for
+	 @return false if sizing was stopped
+	 */
+	bool waitUntil(chrono::steady_clock::time_point when){
+		unique_lock<mutex> guard(lock);
+		resumed.wait_until(guard, when, [&]{
+			return stop.load();
+		});
+		return !stop;
+	}
+
+private:
+	atomic<bool> stop{false};
+	atomic<bool> hold{false};
+	mutex lock;
+	condition_variable resumed;
+};
+
+//callback definitions
+typedef function<void(const progressSnapshot& progress, DirectoryData* data)> progCallback;
+typedef function<void(const string& msg)> logCallback;
 
 /**
  Class that calculates the sizes of folders.
+ Folders are sized by a pool of worker threads. Each worker owns a queue of folders waiting
+ to be sized, and idle workers steal from the other workers' queues. A folder's totals are
+ calculated once all of its subfolders have finished, so sizes propagate bottom-up.
  */
 class folderSizer{
 public:
-	bool abort = true;
-	wxWindow* ParentWindow;
+	scanControl control;
+	sizeProgress progress;
+#if defined __linux__
+	scanBackend backend = scanBackend::getdents;
+#else
+	scanBackend backend = scanBackend::standard;
+#endif
+	//reuse the contents of folders whose stamps have not changed since they were last sized
+	bool incremental = false;
+	scanLimits limits;
+	//apply the limits to the folder sizing starts from as well, as when it appeared inside a tree sized earlier. Never set when sizing the tree's root.
+	bool limitRoot = false;
+	//how many of the largest files, and of the largest folders, to find while sizing, or 0 for none
+	size_t numLargest = 100;
+	//the largest items found by the last sizing, ranked by the tree's size mode at the time
+	largestItems largest;
+	//count the bytes and files of each extension and category while sizing
+	bool countTypes = true;
+	//the types of the files found by the last sizing, counted by the tree's size mode at the time
+	typeHistogram types;
+	//count the bytes and files of each user and group while sizing
+	bool countOwners = true;
+	//the owners of the files found by the last sizing, counted by the tree's size mode at the time
+	ownerHistogram owners;
 
-	folderSizer(wxWindow*);
+	folderSizer(unsigned int threads = thread::hardware_concurrency());
 	~folderSizer();
 
+	void Size(DirectoryTree*, nodeIndex, const logCallback&);
+
+private:
+	/**
+	 The folders waiting to be sized by one worker. The owner pushes and pops at the back,
+	 while thieves take from the front so that they receive the largest remaining subtrees.
+	 */
+	struct workQueue{
+		mutex lock;
+		deque<nodeIndex> items;
+	};
+
+	/**
+	 The immediate contents of a folder, collected before they are added to the tree
+	 */
+	struct folderContents{
+		//null-terminated names of the items
+		string names;
+		vector<DirectoryTree::childItem> folders;
+		vector<DirectoryTree::childItem> files;
+		fileSize files_size;
+		//the part of files_size that belongs to hard links counted elsewhere
+		fileSize linked_size;
+		//the bytes the files take on disk, not counting hard links counted elsewhere
+		fileSize allocated_size;
+
+		void clear(){
+			names.clear();
+			folders.clear();
+			files.clear();
+			files_size = 1;
+			linked_size = 0;
+			allocated_size = 0;
+		}
+		/**
+		 Copy a name into the names buffer
+		 @param name the name to add
+		 @return the offset of the name
+		 */
+		size_t addName(const char* name){
+			size_t offset = names.size();
+			names.append(name);
+			names.push_back('\0');
+			return offset;
+		}
+	};
+
+	unsigned int numThreads;
+	vector<unique_ptr<workQueue>> queues;
+
+	//folders that are queued or being sized
+	atomic<size_t> outstanding{0};
+	//folders that are queued, but not yet taken by a worker
+	atomic<size_t> queued{0};
+	atomic<unsigned int> numIdle{0};
+	mutex idleLock;
+	condition_variable idleCondition;
+
+	DirectoryTree* tree = nullptr;
+	nodeIndex root = noNode;
+	//files with more than one link that have been counted in this sizing
+	inodeSet links;
+	//each worker counts types and owners in its own histograms, on its own cache lines, and they are merged when sizing finishes
+	struct alignas(64) workerHistograms{
+		typeHistogram types;
+		ownerHistogram owners;
+	};
+	vector<workerHistograms> workerCounts;
+	//spaces out the operations when the rate is limited
+	rateLimiter limiter;
+	//read from the limits when sizing starts
+	uint64_t rootDevice = 0;
+	unordered_set<uint64_t> excludedDevices;
+	unordered_set<string> mountPoints;
+	const logCallback* log = nullptr;
+
+	void workerLoop(unsigned int);
+	void push(unsigned int, nodeIndex);
+	nodeIndex next(unsigned int);
+	void wake(bool all);
+
+	void sizeFolder(unsigned int, nodeIndex, bool);
+	void readLimits();
+	void pace(uint64_t);
+	bool outsideLimits(nodeIndex, const string&, const folderStamp&) const;
+	void sizeImmediate(const string&, folderContents&);
+#if defined __linux__
+	void sizeImmediateLinux(const string&, directoryReader&, folderContents&);
+#endif
+	void addFile(folderContents&, size_t, const struct stat&);
+	void finishFolder(unsigned int, nodeIndex);
 
+	/**
+	 Send a message to the log callback, if one was provided
+	 @param msg the string to log
+	 */
+	void Log(const string& msg){
+		if (log != nullptr && *log != nullptr){
+			(*log)(msg);
+		}
+	}
 };
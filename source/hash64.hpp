@@ -0,0 +1,134 @@
+//
+//  hash64.hpp
+//  mac
+//
+//  Copyright © 2020 Ravbug. All rights reserved.
+//
+
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ A fast non-cryptographic 64-bit hash, computed incrementally. This is XXH64: the input is consumed
+ in 32 byte stripes by four independent lanes, which keeps several multiplies in flight at once,
+ so hashing runs at memory speed rather than being limited by one long chain of multiplies.
+ Not suitable where an attacker chooses the input.
+ */
+class hash64{
+public:
+	/**
+	 @param seed the starting value, so that unrelated uses of the hash give unrelated values
+	 */
+	hash64(uint64_t seed = 0){
+		lanes[0] = seed + prime1 + prime2;
+		lanes[1] = seed + prime2;
+		lanes[2] = seed;
+		lanes[3] = seed - prime1;
+		this->seed = seed;
+	}
+
+	/**
+	 Add bytes to the hash
+	 @param data the bytes
+	 @param length the number of bytes
+	 */
+	void update(const void* data, size_t length){
+		const unsigned char* p = (const unsigned char*)data;
+		const unsigned char* end = p + length;
+		total += length;
+		//finish a stripe started by a previous call
+		if (buffered > 0){
+			size_t take = length < stripe - buffered ? length : stripe - buffered;
+			memcpy(buffer + buffered, p, take);
+			buffered += take;
+			p += take;
+			if (buffered < stripe){
+				return;
+			}
+			consume(buffer);
+			buffered = 0;
+		}
+		for (; (size_t)(end - p) >= stripe; p += stripe){
+			consume(p);
+		}
+		memcpy(buffer, p, end - p);
+		buffered = end - p;
+	}
+
+	/**
+	 @return the hash of every byte added so far. More bytes can still be added afterwards.
+	 */
+	uint64_t digest() const{
+		uint64_t h;
+		if (total >= stripe){
+			h = rotl(lanes[0], 1) + rotl(lanes[1], 7) + rotl(lanes[2], 12) + rotl(lanes[3], 18);
+			for (uint64_t lane : lanes){
+				h ^= round(0, lane);
+				h = h * prime1 + prime4;
+			}
+		}
+		else{
+			h = seed + prime5;
+		}
+		h += total;
+		const unsigned char* p = buffer;
+		const unsigned char* end = buffer + buffered;
+		for (; end - p >= 8; p += 8){
+			h ^= round(0, read64(p));
+			h = rotl(h, 27) * prime1 + prime4;
+		}
+		if (end - p >= 4){
+			uint32_t word;
+			memcpy(&word, p, 4);
+			h ^= word * prime1;
+			h = rotl(h, 23) * prime2 + prime3;
+			p += 4;
+		}
+		for (; p < end; p++){
+			h ^= *p * prime5;
+			h = rotl(h, 11) * prime1;
+		}
+		h ^= h >> 33;
+		h *= prime2;
+		h ^= h >> 29;
+		h *= prime3;
+		h ^= h >> 32;
+		return h;
+	}
+
+private:
+	static constexpr uint64_t prime1 = 11400714785074694791ull;
+	static constexpr uint64_t prime2 = 14029467366897019727ull;
+	static constexpr uint64_t prime3 = 1609587929392839161ull;
+	static constexpr uint64_t prime4 = 9650029242287828579ull;
+	static constexpr uint64_t prime5 = 2870177450012600261ull;
+	static constexpr size_t stripe = 32;
+
+	uint64_t lanes[4];
+	uint64_t seed;
+	uint64_t total = 0;
+	unsigned char buffer[stripe];
+	size_t buffered = 0;
+
+	static uint64_t rotl(uint64_t x, int bits){
+		return (x << bits) | (x >> (64 - bits));
+	}
+	static uint64_t round(uint64_t lane, uint64_t input){
+		lane += input * prime2;
+		return rotl(lane, 31) * prime1;
+	}
+	//the hash is defined on little-endian words, which every supported platform uses
+	static uint64_t read64(const unsigned char* p){
+		uint64_t word;
+		memcpy(&word, p, 8);
+		return word;
+	}
+	void consume(const unsigned char* p){
+		lanes[0] = round(lanes[0], read64(p));
+		lanes[1] = round(lanes[1], read64(p + 8));
+		lanes[2] = round(lanes[2], read64(p + 16));
+		lanes[3] = round(lanes[3], read64(p + 24));
+	}
+};
@@ -0,0 +1,74 @@
+//
+//  inode_set.hpp
+//  mac
+//
+//  Copyright © 2020 Ravbug. All rights reserved.
+//
+
+#pragma once
+#include <array>
+#include <mutex>
+#include <unordered_set>
+#include <stdint.h>
+
+/**
+ A set of (device, inode) pairs that many threads can add to at once. The set is split into shards,
+ each with its own lock, chosen by the hash of the pair, so threads adding different files rarely wait for each other.
+ Used to count each hard-linked file once.
+ */
+class inodeSet{
+public:
+	/**
+	 Add a file to the set
+	 @param device the file's st_dev
+	 @param inode the file's st_ino
+	 @return true if the file was added, false if it was already in the set
+	 */
+	bool insert(uint64_t device, uint64_t inode){
+		key k{device, inode};
+		//the low bits pick the bucket within a shard, so the high bits pick the shard
+		shard& s = shards[mix(k) >> (64 - shardBits)];
+		std::lock_guard<std::mutex> guard(s.lock);
+		return s.keys.insert(k).second;
+	}
+
+	/**
+	 Remove every file from the set
+	 */
+	void clear(){
+		for (shard& s : shards){
+			std::lock_guard<std::mutex> guard(s.lock);
+			s.keys.clear();
+		}
+	}
+
+private:
+	struct key{
+		uint64_t device;
+		uint64_t inode;
+		bool operator==(const key& other) const{
+			return device == other.device && inode == other.inode;
+		}
+	};
+	/**
+	 Inode numbers are often sequential, so their bits are mixed to spread them over the shards and buckets
+	 @param k the pair to hash
+	 @return the hash
+	 */
+	static uint64_t mix(const key& k){
+		uint64_t h = (k.inode ^ (k.device * 0x9e3779b97f4a7c15ull)) * 0xbf58476d1ce4e5b9ull;
+		return h ^ (h >> 31);
+	}
+	struct keyHash{
+		size_t operator()(const key& k) const{
+			return (size_t)mix(k);
+		}
+	};
+	//padded to a cache line so that the locks of neighbouring shards do not contend
+	struct alignas(64) shard{
+		std::mutex lock;
+		std::unordered_set<key, keyHash> keys;
+	};
+	static constexpr unsigned int shardBits = 6;
+	std::array<shard, 1 << shardBits> shards;
+};
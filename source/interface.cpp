@@ -26,12 +26,91 @@ MainFrameBase::MainFrameBase( wxWindow* parent, wxWindowID id, const wxString& t
 	reloadFolderMenu = new wxMenuItem( menuFile, wxID_REFRESH, wxString( wxT("Reload Folder") ) + wxT('\t') + wxT("Ctrl-R"), wxT("Recalculate the selected folder's size"), wxITEM_NORMAL );
 	menuFile->Append( reloadFolderMenu );
 
+	wxMenuItem* rescanMenu;
+	rescanMenu = new wxMenuItem( menuFile, RESCAN, wxString( wxT("Rescan Changed Folders") ) + wxT('\t') + wxT("Ctrl-Shift-R"), wxT("Size again only the folders that changed since the last scan"), wxITEM_NORMAL );
+	menuFile->Append( rescanMenu );
+
+	watchMenu = new wxMenuItem( menuFile, WATCH, wxString( wxT("Watch for Changes") ) , wxT("Keep the sizes up to date as files change, without sizing again"), wxITEM_CHECK );
+	menuFile->Append( watchMenu );
+
+	wxMenuItem* oneFileSystemMenu;
+	oneFileSystemMenu = new wxMenuItem( menuFile, ONEFILESYSTEM, wxString( wxT("Stay on One File System") ) , wxT("When sizing, do not enter other file systems or mount points"), wxITEM_CHECK );
+	menuFile->Append( oneFileSystemMenu );
+
+	wxMenuItem* skipVirtualMenu;
+	skipVirtualMenu = new wxMenuItem( menuFile, SKIPVIRTUAL, wxString( wxT("Skip Virtual File Systems") ) , wxT("When sizing, do not enter virtual file systems such as /proc and /sys"), wxITEM_CHECK );
+	menuFile->Append( skipVirtualMenu );
+
+	wxMenuItem* skipNamesMenu;
+	skipNamesMenu = new wxMenuItem( menuFile, SKIPNAMES, wxString( wxT("Skip Items by Name...") ) , wxT("Choose names of files and folders to skip when sizing, such as node_modules or *.o"), wxITEM_NORMAL );
+	menuFile->Append( skipNamesMenu );
+
+	wxMenuItem* lowPriorityMenu;
+	lowPriorityMenu = new wxMenuItem( menuFile, LOWPRIORITY, wxString( wxT("Size at Low Priority") ) , wxT("When sizing, let other programs use the disk and processor first"), wxITEM_CHECK );
+	menuFile->Append( lowPriorityMenu );
+
+	wxMenuItem* rateLimitMenu;
+	rateLimitMenu = new wxMenuItem( menuFile, RATELIMIT, wxString( wxT("Limit Sizing Rate...") ) , wxT("Choose the most files and folders to read each second when sizing"), wxITEM_NORMAL );
+	menuFile->Append( rateLimitMenu );
+
 	wxMenuItem* stopSizingMenu;
 	stopSizingMenu = new wxMenuItem( menuFile, wxID_STOP, wxString( wxT("Stop Sizing Folder") ) , wxT("Stop the current size calculation"), wxITEM_NORMAL );
 	menuFile->Append( stopSizingMenu );
 
+	pauseMenu = new wxMenuItem( menuFile, PAUSESIZING, wxString( wxT("Pause Sizing") ) + wxT('\t') + wxT("Ctrl-P"), wxT("Pause the current size calculation, keeping what was sized so far"), wxITEM_CHECK );
+	menuFile->Append( pauseMenu );
+
+	menuFile->AppendSeparator();
+
+	wxMenuItem* openScanMenu;
+	openScanMenu = new wxMenuItem( menuFile, OPENSCAN, wxString( wxT("Open Scan...") ) + wxT('\t') + wxT("Ctrl-Shift-O"), wxT("Open a scan saved earlier, without sizing again"), wxITEM_NORMAL );
+	menuFile->Append( openScanMenu );
+
+	wxMenuItem* saveScanMenu;
+	saveScanMenu = new wxMenuItem( menuFile, SAVESCAN, wxString( wxT("Save Scan...") ) + wxT('\t') + wxT("Ctrl-S"), wxT("Save the current scan to a file"), wxITEM_NORMAL );
+	menuFile->Append( saveScanMenu );
+
 	menuBar->Append( menuFile, wxT("File") );
 
+	wxMenu* menuView;
+	menuView = new wxMenu();
+	wxMenuItem* sizeApparentMenu;
+	sizeApparentMenu = new wxMenuItem( menuView, SIZEAPPARENT, wxString( wxT("Show Apparent Sizes") ) , wxT("Show the sum of every file's size, counting a hard-linked file once for each link"), wxITEM_RADIO );
+	menuView->Append( sizeApparentMenu );
+	sizeApparentMenu->Check( true );
+
+	wxMenuItem* sizeLinksOnceMenu;
+	sizeLinksOnceMenu = new wxMenuItem( menuView, SIZELINKSONCE, wxString( wxT("Count Hard Links Once") ) , wxT("Count a file with several hard links once, where the first link was found"), wxITEM_RADIO );
+	menuView->Append( sizeLinksOnceMenu );
+
+	wxMenuItem* sizeAllocatedMenu;
+	sizeAllocatedMenu = new wxMenuItem( menuView, SIZEALLOCATED, wxString( wxT("Show Allocated Sizes") ) , wxT("Show the space items take on disk, which is less than their size for sparse and compressed files"), wxITEM_RADIO );
+	menuView->Append( sizeAllocatedMenu );
+
+	menuView->AppendSeparator();
+
+	wxMenuItem* largestItemsMenu;
+	largestItemsMenu = new wxMenuItem( menuView, LARGESTITEMS, wxString( wxT("Largest Items...") ) + wxT('\t') + wxT("Ctrl-G"), wxT("List the largest files and folders found by the last sizing"), wxITEM_NORMAL );
+	menuView->Append( largestItemsMenu );
+
+	wxMenuItem* fileTypesMenu;
+	fileTypesMenu = new wxMenuItem( menuView, FILETYPES, wxString( wxT("File Types...") ) + wxT('\t') + wxT("Ctrl-T"), wxT("Show how much of the selected folder, or the whole scan, each type of file takes"), wxITEM_NORMAL );
+	menuView->Append( fileTypesMenu );
+
+	wxMenuItem* findDuplicatesMenu;
+	findDuplicatesMenu = new wxMenuItem( menuView, FINDDUPLICATES, wxString( wxT("Find Duplicates...") ) + wxT('\t') + wxT("Ctrl-D"), wxT("Find files with the same contents in the selected folder, or the whole scan"), wxITEM_NORMAL );
+	menuView->Append( findDuplicatesMenu );
+
+	wxMenuItem* agesMenu;
+	agesMenu = new wxMenuItem( menuView, AGES, wxString( wxT("Ages...") ) + wxT('\t') + wxT("Ctrl-E"), wxT("Show how long ago the files in the selected folder, or the whole scan, were last used"), wxITEM_NORMAL );
+	menuView->Append( agesMenu );
+
+	wxMenuItem* ownersMenu;
+	ownersMenu = new wxMenuItem( menuView, OWNERS, wxString( wxT("Owners...") ) + wxT('\t') + wxT("Ctrl-U"), wxT("Show how much of the selected folder, or the whole scan, each user and group owns"), wxITEM_NORMAL );
+	menuView->Append( ownersMenu );
+
+	menuBar->Append( menuView, wxT("View") );
+
 	wxMenu* menuWindow;
 	menuWindow = new wxMenu();
 	wxMenuItem* menuAbout;
@@ -60,6 +139,9 @@ MainFrameBase::MainFrameBase( wxWindow* parent, wxWindowID id, const wxString& t
 	menuToggleLog = new wxMenuItem( menuHelp, wxID_JUSTIFY_FILL, wxString( wxT("Show Log") ) + wxT('\t') + wxT("Ctrl-L"), wxEmptyString, wxITEM_NORMAL );
 	menuHelp->Append( menuToggleLog );
 
+	menuToggleTreemap = new wxMenuItem( menuHelp, TREEMAP, wxString( wxT("Show Treemap") ) + wxT('\t') + wxT("Ctrl-M"), wxEmptyString, wxITEM_NORMAL );
+	menuHelp->Append( menuToggleTreemap );
+
 	menuBar->Append( menuHelp, wxT("Help") );
 
 	this->SetMenuBar( menuBar );
@@ -225,10 +307,10 @@ FolderDisplayBase::FolderDisplayBase( wxWindow* parent, wxWindowID id, const wxP
 	ItemName->Wrap( -1 );
 	mainSizer->Add( ItemName, 0, wxALL, 5 );
 
-	ListCtrl = new wxDataViewListCtrl( this, FDISP, wxDefaultPosition, wxDefaultSize, 0 );
-	nameCol = ListCtrl->AppendTextColumn( wxT("File Name"), wxDATAVIEW_CELL_INERT, -1, static_cast<wxAlignment>(wxALIGN_LEFT), wxDATAVIEW_COL_RESIZABLE );
-	percentCol = ListCtrl->AppendProgressColumn( wxT("Percent"), wxDATAVIEW_CELL_INERT, -1, static_cast<wxAlignment>(wxALIGN_CENTER), wxDATAVIEW_COL_SORTABLE );
-	sizeCol = ListCtrl->AppendTextColumn( wxT("Size"), wxDATAVIEW_CELL_INERT, 100, static_cast<wxAlignment>(wxALIGN_RIGHT), 0 );
+	ListCtrl = new wxDataViewCtrl( this, FDISP, wxDefaultPosition, wxDefaultSize, 0 );
+	nameCol = ListCtrl->AppendTextColumn( wxT("File Name"), 0, wxDATAVIEW_CELL_INERT, -1, static_cast<wxAlignment>(wxALIGN_LEFT), wxDATAVIEW_COL_RESIZABLE );
+	percentCol = ListCtrl->AppendProgressColumn( wxT("Percent"), 1, wxDATAVIEW_CELL_INERT, -1, static_cast<wxAlignment>(wxALIGN_CENTER), wxDATAVIEW_COL_SORTABLE );
+	sizeCol = ListCtrl->AppendTextColumn( wxT("Size"), 2, wxDATAVIEW_CELL_INERT, 100, static_cast<wxAlignment>(wxALIGN_RIGHT), 0 );
 	mainSizer->Add( ListCtrl, 0, wxALL|wxEXPAND, 5 );
 
 
@@ -240,3 +322,186 @@ FolderDisplayBase::FolderDisplayBase( wxWindow* parent, wxWindowID id, const wxP
 FolderDisplayBase::~FolderDisplayBase()
 {
 }
+
+LargestItemsBase::LargestItemsBase( wxWindow* parent, wxWindowID id, const wxString& title, const wxPoint& pos, const wxSize& size, long style ) : wxDialog( parent, id, title, pos, size, style )
+{
+	this->SetSizeHints( wxDefaultSize, wxDefaultSize );
+
+	wxBoxSizer* largestSizer;
+	largestSizer = new wxBoxSizer( wxVERTICAL );
+
+	largestSummary = new wxStaticText( this, wxID_ANY, wxT("The largest files and folders found by the last sizing"), wxDefaultPosition, wxDefaultSize, 0 );
+	largestSummary->Wrap( -1 );
+	largestSizer->Add( largestSummary, 0, wxALL|wxEXPAND, 5 );
+
+	largestList = new wxDataViewListCtrl( this, wxID_ANY, wxDefaultPosition, wxDefaultSize, 0 );
+	largestSizeCol = largestList->AppendTextColumn( wxT("Size"), wxDATAVIEW_CELL_INERT, 100, static_cast<wxAlignment>(wxALIGN_RIGHT), 0 );
+	largestTypeCol = largestList->AppendTextColumn( wxT("Type"), wxDATAVIEW_CELL_INERT, 80, static_cast<wxAlignment>(wxALIGN_LEFT), wxDATAVIEW_COL_RESIZABLE );
+	largestPathCol = largestList->AppendTextColumn( wxT("Path"), wxDATAVIEW_CELL_INERT, -1, static_cast<wxAlignment>(wxALIGN_LEFT), wxDATAVIEW_COL_RESIZABLE );
+	largestSizer->Add( largestList, 1, wxALL|wxEXPAND, 5 );
+
+
+	this->SetSizer( largestSizer );
+	this->Layout();
+
+	this->Centre( wxBOTH );
+}
+
+LargestItemsBase::~LargestItemsBase()
+{
+}
+
+FileTypesBase::FileTypesBase( wxWindow* parent, wxWindowID id, const wxString& title, const wxPoint& pos, const wxSize& size, long style ) : wxDialog( parent, id, title, pos, size, style )
+{
+	this->SetSizeHints( wxDefaultSize, wxDefaultSize );
+
+	wxBoxSizer* typesSizer;
+	typesSizer = new wxBoxSizer( wxVERTICAL );
+
+	typesSummary = new wxStaticText( this, wxID_ANY, wxT("The space each type of file takes"), wxDefaultPosition, wxDefaultSize, 0 );
+	typesSummary->Wrap( -1 );
+	typesSizer->Add( typesSummary, 0, wxALL|wxEXPAND, 5 );
+
+	categoryList = new wxDataViewListCtrl( this, wxID_ANY, wxDefaultPosition, wxDefaultSize, 0 );
+	categoryNameCol = categoryList->AppendTextColumn( wxT("Category"), wxDATAVIEW_CELL_INERT, 150, static_cast<wxAlignment>(wxALIGN_LEFT), wxDATAVIEW_COL_RESIZABLE );
+	categoryPercentCol = categoryList->AppendProgressColumn( wxT("Percent"), wxDATAVIEW_CELL_INERT, -1, static_cast<wxAlignment>(wxALIGN_CENTER), 0 );
+	categorySizeCol = categoryList->AppendTextColumn( wxT("Size"), wxDATAVIEW_CELL_INERT, 100, static_cast<wxAlignment>(wxALIGN_RIGHT), 0 );
+	categoryFilesCol = categoryList->AppendTextColumn( wxT("Files"), wxDATAVIEW_CELL_INERT, 80, static_cast<wxAlignment>(wxALIGN_RIGHT), 0 );
+	typesSizer->Add( categoryList, 1, wxALL|wxEXPAND, 5 );
+
+	extensionList = new wxDataViewListCtrl( this, wxID_ANY, wxDefaultPosition, wxDefaultSize, 0 );
+	extensionNameCol = extensionList->AppendTextColumn( wxT("Extension"), wxDATAVIEW_CELL_INERT, 150, static_cast<wxAlignment>(wxALIGN_LEFT), wxDATAVIEW_COL_RESIZABLE );
+	extensionPercentCol = extensionList->AppendProgressColumn( wxT("Percent"), wxDATAVIEW_CELL_INERT, -1, static_cast<wxAlignment>(wxALIGN_CENTER), 0 );
+	extensionSizeCol = extensionList->AppendTextColumn( wxT("Size"), wxDATAVIEW_CELL_INERT, 100, static_cast<wxAlignment>(wxALIGN_RIGHT), 0 );
+	extensionFilesCol = extensionList->AppendTextColumn( wxT("Files"), wxDATAVIEW_CELL_INERT, 80, static_cast<wxAlignment>(wxALIGN_RIGHT), 0 );
+	typesSizer->Add( extensionList, 1, wxALL|wxEXPAND, 5 );
+
+
+	this->SetSizer( typesSizer );
+	this->Layout();
+
+	this->Centre( wxBOTH );
+}
+
+FileTypesBase::~FileTypesBase()
+{
+}
+
+DuplicatesBase::DuplicatesBase( wxWindow* parent, wxWindowID id, const wxString& title, const wxPoint& pos, const wxSize& size, long style ) : wxDialog( parent, id, title, pos, size, style )
+{
+	this->SetSizeHints( wxDefaultSize, wxDefaultSize );
+
+	wxBoxSizer* duplicatesSizer;
+	duplicatesSizer = new wxBoxSizer( wxVERTICAL );
+
+	duplicatesSummary = new wxStaticText( this, wxID_ANY, wxT("Files with the same contents"), wxDefaultPosition, wxDefaultSize, 0 );
+	duplicatesSummary->Wrap( -1 );
+	duplicatesSizer->Add( duplicatesSummary, 0, wxALL|wxEXPAND, 5 );
+
+	duplicatesList = new wxDataViewListCtrl( this, wxID_ANY, wxDefaultPosition, wxDefaultSize, 0 );
+	duplicatesReclaimCol = duplicatesList->AppendTextColumn( wxT("Reclaimable"), wxDATAVIEW_CELL_INERT, 100, static_cast<wxAlignment>(wxALIGN_RIGHT), 0 );
+	duplicatesSizeCol = duplicatesList->AppendTextColumn( wxT("Size"), wxDATAVIEW_CELL_INERT, 100, static_cast<wxAlignment>(wxALIGN_RIGHT), 0 );
+	duplicatesPathCol = duplicatesList->AppendTextColumn( wxT("Path"), wxDATAVIEW_CELL_INERT, -1, static_cast<wxAlignment>(wxALIGN_LEFT), wxDATAVIEW_COL_RESIZABLE );
+	duplicatesSizer->Add( duplicatesList, 1, wxALL|wxEXPAND, 5 );
+
+
+	this->SetSizer( duplicatesSizer );
+	this->Layout();
+
+	this->Centre( wxBOTH );
+}
+
+DuplicatesBase::~DuplicatesBase()
+{
+}
+
+AgesBase::AgesBase( wxWindow* parent, wxWindowID id, const wxString& title, const wxPoint& pos, const wxSize& size, long style ) : wxDialog( parent, id, title, pos, size, style )
+{
+	this->SetSizeHints( wxDefaultSize, wxDefaultSize );
+
+	wxBoxSizer* agesSizer;
+	agesSizer = new wxBoxSizer( wxVERTICAL );
+
+	wxBoxSizer* agesHeaderSizer;
+	agesHeaderSizer = new wxBoxSizer( wxHORIZONTAL );
+
+	agesSummary = new wxStaticText( this, wxID_ANY, wxT("The bytes by how long ago files were last used"), wxDefaultPosition, wxDefaultSize, 0 );
+	agesSummary->Wrap( -1 );
+	agesHeaderSizer->Add( agesSummary, 1, wxALL|wxEXPAND, 5 );
+
+	wxString agesBasisChoiceChoices[] = { wxT("Modified"), wxT("Accessed"), wxT("Modified or accessed") };
+	int agesBasisChoiceNChoices = sizeof( agesBasisChoiceChoices ) / sizeof( wxString );
+	agesBasisChoice = new wxChoice( this, AGEBASIS, wxDefaultPosition, wxDefaultSize, agesBasisChoiceNChoices, agesBasisChoiceChoices, 0 );
+	agesBasisChoice->SetSelection( 2 );
+	agesBasisChoice->SetToolTip( wxT("Which of a file's times decides how long ago it was last used") );
+
+	agesHeaderSizer->Add( agesBasisChoice, 0, wxALL|wxALIGN_CENTER_VERTICAL, 5 );
+
+
+	agesSizer->Add( agesHeaderSizer, 0, wxEXPAND, 0 );
+
+	agesList = new wxDataViewListCtrl( this, wxID_ANY, wxDefaultPosition, wxDefaultSize, 0 );
+	agesList->SetMinSize( wxSize( -1,150 ) );
+
+	agesNameCol = agesList->AppendTextColumn( wxT("Last used"), wxDATAVIEW_CELL_INERT, 150, static_cast<wxAlignment>(wxALIGN_LEFT), wxDATAVIEW_COL_RESIZABLE );
+	agesPercentCol = agesList->AppendProgressColumn( wxT("Percent"), wxDATAVIEW_CELL_INERT, -1, static_cast<wxAlignment>(wxALIGN_CENTER), 0 );
+	agesSizeCol = agesList->AppendTextColumn( wxT("Size"), wxDATAVIEW_CELL_INERT, 100, static_cast<wxAlignment>(wxALIGN_RIGHT), 0 );
+	agesSizer->Add( agesList, 0, wxALL|wxEXPAND, 5 );
+
+	wxStaticText* staleLabel;
+	staleLabel = new wxStaticText( this, wxID_ANY, wxT("Folders with the most bytes not used in over a year"), wxDefaultPosition, wxDefaultSize, 0 );
+	staleLabel->Wrap( -1 );
+	agesSizer->Add( staleLabel, 0, wxALL|wxEXPAND, 5 );
+
+	staleList = new wxDataViewListCtrl( this, wxID_ANY, wxDefaultPosition, wxDefaultSize, 0 );
+	staleSizeCol = staleList->AppendTextColumn( wxT("Over a year"), wxDATAVIEW_CELL_INERT, 100, static_cast<wxAlignment>(wxALIGN_RIGHT), 0 );
+	stalePercentCol = staleList->AppendProgressColumn( wxT("Percent"), wxDATAVIEW_CELL_INERT, 80, static_cast<wxAlignment>(wxALIGN_CENTER), 0 );
+	stalePathCol = staleList->AppendTextColumn( wxT("Folder"), wxDATAVIEW_CELL_INERT, -1, static_cast<wxAlignment>(wxALIGN_LEFT), wxDATAVIEW_COL_RESIZABLE );
+	agesSizer->Add( staleList, 1, wxALL|wxEXPAND, 5 );
+
+
+	this->SetSizer( agesSizer );
+	this->Layout();
+
+	this->Centre( wxBOTH );
+}
+
+AgesBase::~AgesBase()
+{
+}
+
+OwnersBase::OwnersBase( wxWindow* parent, wxWindowID id, const wxString& title, const wxPoint& pos, const wxSize& size, long style ) : wxDialog( parent, id, title, pos, size, style )
+{
+	this->SetSizeHints( wxDefaultSize, wxDefaultSize );
+
+	wxBoxSizer* ownersSizer;
+	ownersSizer = new wxBoxSizer( wxVERTICAL );
+
+	ownersSummary = new wxStaticText( this, wxID_ANY, wxT("The space each user and group owns"), wxDefaultPosition, wxDefaultSize, 0 );
+	ownersSummary->Wrap( -1 );
+	ownersSizer->Add( ownersSummary, 0, wxALL|wxEXPAND, 5 );
+
+	userList = new wxDataViewListCtrl( this, wxID_ANY, wxDefaultPosition, wxDefaultSize, 0 );
+	userNameCol = userList->AppendTextColumn( wxT("User"), wxDATAVIEW_CELL_INERT, 150, static_cast<wxAlignment>(wxALIGN_LEFT), wxDATAVIEW_COL_RESIZABLE );
+	userPercentCol = userList->AppendProgressColumn( wxT("Percent"), wxDATAVIEW_CELL_INERT, -1, static_cast<wxAlignment>(wxALIGN_CENTER), 0 );
+	userSizeCol = userList->AppendTextColumn( wxT("Size"), wxDATAVIEW_CELL_INERT, 100, static_cast<wxAlignment>(wxALIGN_RIGHT), 0 );
+	userFilesCol = userList->AppendTextColumn( wxT("Files"), wxDATAVIEW_CELL_INERT, 80, static_cast<wxAlignment>(wxALIGN_RIGHT), 0 );
+	ownersSizer->Add( userList, 1, wxALL|wxEXPAND, 5 );
+
+	groupList = new wxDataViewListCtrl( this, wxID_ANY, wxDefaultPosition, wxDefaultSize, 0 );
+	groupNameCol = groupList->AppendTextColumn( wxT("Group"), wxDATAVIEW_CELL_INERT, 150, static_cast<wxAlignment>(wxALIGN_LEFT), wxDATAVIEW_COL_RESIZABLE );
+	groupPercentCol = groupList->AppendProgressColumn( wxT("Percent"), wxDATAVIEW_CELL_INERT, -1, static_cast<wxAlignment>(wxALIGN_CENTER), 0 );
+	groupSizeCol = groupList->AppendTextColumn( wxT("Size"), wxDATAVIEW_CELL_INERT, 100, static_cast<wxAlignment>(wxALIGN_RIGHT), 0 );
+	groupFilesCol = groupList->AppendTextColumn( wxT("Files"), wxDATAVIEW_CELL_INERT, 80, static_cast<wxAlignment>(wxALIGN_RIGHT), 0 );
+	ownersSizer->Add( groupList, 1, wxALL|wxEXPAND, 5 );
+
+
+	this->SetSizer( ownersSizer );
+	this->Layout();
+
+	this->Centre( wxBOTH );
+}
+
+OwnersBase::~OwnersBase()
+{
+}
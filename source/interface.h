@@ -29,12 +29,34 @@
 #include <wx/stattext.h>
 #include <wx/splitter.h>
 #include <wx/dataview.h>
+#include <wx/choice.h>
 #include <wx/frame.h>
+#include <wx/dialog.h>
 
 ///////////////////////////////////////////////////////////////////////////
 
 #define COPYPATH 1000
 #define FDISP 1001
+#define OPENSCAN 1002
+#define SAVESCAN 1003
+#define RESCAN 1004
+#define WATCH 1005
+#define SIZEAPPARENT 1006
+#define SIZELINKSONCE 1007
+#define SIZEALLOCATED 1008
+#define ONEFILESYSTEM 1009
+#define SKIPVIRTUAL 1010
+#define SKIPNAMES 1011
+#define PAUSESIZING 1012
+#define LOWPRIORITY 1013
+#define RATELIMIT 1014
+#define LARGESTITEMS 1015
+#define FILETYPES 1016
+#define FINDDUPLICATES 1017
+#define TREEMAP 1018
+#define AGES 1019
+#define AGEBASIS 1020
+#define OWNERS 1021
 
 ///////////////////////////////////////////////////////////////////////////////
 /// Class MainFrameBase
@@ -45,8 +67,11 @@ class MainFrameBase : public wxFrame
 
 	protected:
 		wxStatusBar* statusBar;
+		wxMenuItem* watchMenu;
+		wxMenuItem* pauseMenu;
 		wxMenuItem* menuToggleSidebar;
 		wxMenuItem* menuToggleLog;
+		wxMenuItem* menuToggleTreemap;
 		wxButton* openFolderBtn;
 		wxButton* reloadFolderBtn;
 		wxButton* stopSizeBtn;
@@ -93,7 +118,7 @@ class FolderDisplayBase : public wxPanel
 
 	protected:
 		wxStaticText* ItemName;
-		wxDataViewListCtrl* ListCtrl;
+		wxDataViewCtrl* ListCtrl;
 		wxDataViewColumn* nameCol;
 		wxDataViewColumn* percentCol;
 		wxDataViewColumn* sizeCol;
@@ -105,3 +130,125 @@ class FolderDisplayBase : public wxPanel
 
 };
 
+///////////////////////////////////////////////////////////////////////////////
+/// Class LargestItemsBase
+///////////////////////////////////////////////////////////////////////////////
+class LargestItemsBase : public wxDialog
+{
+	private:
+
+	protected:
+		wxStaticText* largestSummary;
+		wxDataViewListCtrl* largestList;
+		wxDataViewColumn* largestSizeCol;
+		wxDataViewColumn* largestTypeCol;
+		wxDataViewColumn* largestPathCol;
+
+	public:
+
+		LargestItemsBase( wxWindow* parent, wxWindowID id = wxID_ANY, const wxString& title = wxT("Largest Items"), const wxPoint& pos = wxDefaultPosition, const wxSize& size = wxSize( 640,420 ), long style = wxDEFAULT_DIALOG_STYLE|wxRESIZE_BORDER );
+		~LargestItemsBase();
+
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/// Class FileTypesBase
+///////////////////////////////////////////////////////////////////////////////
+class FileTypesBase : public wxDialog
+{
+	private:
+
+	protected:
+		wxStaticText* typesSummary;
+		wxDataViewListCtrl* categoryList;
+		wxDataViewColumn* categoryNameCol;
+		wxDataViewColumn* categoryPercentCol;
+		wxDataViewColumn* categorySizeCol;
+		wxDataViewColumn* categoryFilesCol;
+		wxDataViewListCtrl* extensionList;
+		wxDataViewColumn* extensionNameCol;
+		wxDataViewColumn* extensionPercentCol;
+		wxDataViewColumn* extensionSizeCol;
+		wxDataViewColumn* extensionFilesCol;
+
+	public:
+
+		FileTypesBase( wxWindow* parent, wxWindowID id = wxID_ANY, const wxString& title = wxT("File Types"), const wxPoint& pos = wxDefaultPosition, const wxSize& size = wxSize( 520,560 ), long style = wxDEFAULT_DIALOG_STYLE|wxRESIZE_BORDER );
+		~FileTypesBase();
+
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/// Class DuplicatesBase
+///////////////////////////////////////////////////////////////////////////////
+class DuplicatesBase : public wxDialog
+{
+	private:
+
+	protected:
+		wxStaticText* duplicatesSummary;
+		wxDataViewListCtrl* duplicatesList;
+		wxDataViewColumn* duplicatesReclaimCol;
+		wxDataViewColumn* duplicatesSizeCol;
+		wxDataViewColumn* duplicatesPathCol;
+
+	public:
+
+		DuplicatesBase( wxWindow* parent, wxWindowID id = wxID_ANY, const wxString& title = wxT("Duplicates"), const wxPoint& pos = wxDefaultPosition, const wxSize& size = wxSize( 720,480 ), long style = wxDEFAULT_DIALOG_STYLE|wxRESIZE_BORDER );
+		~DuplicatesBase();
+
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/// Class AgesBase
+///////////////////////////////////////////////////////////////////////////////
+class AgesBase : public wxDialog
+{
+	private:
+
+	protected:
+		wxStaticText* agesSummary;
+		wxChoice* agesBasisChoice;
+		wxDataViewListCtrl* agesList;
+		wxDataViewColumn* agesNameCol;
+		wxDataViewColumn* agesPercentCol;
+		wxDataViewColumn* agesSizeCol;
+		wxDataViewListCtrl* staleList;
+		wxDataViewColumn* staleSizeCol;
+		wxDataViewColumn* stalePercentCol;
+		wxDataViewColumn* stalePathCol;
+
+	public:
+
+		AgesBase( wxWindow* parent, wxWindowID id = wxID_ANY, const wxString& title = wxT("Ages"), const wxPoint& pos = wxDefaultPosition, const wxSize& size = wxSize( 620,560 ), long style = wxDEFAULT_DIALOG_STYLE|wxRESIZE_BORDER );
+		~AgesBase();
+
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/// Class OwnersBase
+///////////////////////////////////////////////////////////////////////////////
+class OwnersBase : public wxDialog
+{
+	private:
+
+	protected:
+		wxStaticText* ownersSummary;
+		wxDataViewListCtrl* userList;
+		wxDataViewColumn* userNameCol;
+		wxDataViewColumn* userPercentCol;
+		wxDataViewColumn* userSizeCol;
+		wxDataViewColumn* userFilesCol;
+		wxDataViewListCtrl* groupList;
+		wxDataViewColumn* groupNameCol;
+		wxDataViewColumn* groupPercentCol;
+		wxDataViewColumn* groupSizeCol;
+		wxDataViewColumn* groupFilesCol;
+
+	public:
+
+		OwnersBase( wxWindow* parent, wxWindowID id = wxID_ANY, const wxString& title = wxT("Owners"), const wxPoint& pos = wxDefaultPosition, const wxSize& size = wxSize( 520,560 ), long style = wxDEFAULT_DIALOG_STYLE|wxRESIZE_BORDER );
+		~OwnersBase();
+
+};
+
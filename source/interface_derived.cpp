@@ -10,6 +10,10 @@
 #include <wx/generic/aboutdlgg.h>
 #include <wx/aboutdlg.h>
 #include <wx/gdicmn.h>
+#include <wx/textdlg.h>
+#include <wx/numdlg.h>
+#include <wx/progdlg.h>
+#include <sstream>
 using namespace std::filesystem;
 
 //include the icon file on linux
@@ -23,24 +27,49 @@ wxBEGIN_EVENT_TABLE(MainFrame, wxFrame)
 EVT_MENU(wxID_EXIT, MainFrame::OnExit)
 EVT_MENU(wxID_ABOUT, MainFrame::OnAbout)
 EVT_MENU(wxID_OPEN, MainFrame::OnOpenFolder)
+EVT_MENU(OPENSCAN, MainFrame::OnOpenScan)
+EVT_MENU(SAVESCAN, MainFrame::OnSaveScan)
+EVT_MENU(RESCAN, MainFrame::OnRescan)
+EVT_MENU(WATCH, MainFrame::OnWatch)
+EVT_TIMER(WATCH, MainFrame::OnWatchTimer)
+EVT_MENU(SIZEAPPARENT, MainFrame::OnSizeMode)
+EVT_MENU(SIZELINKSONCE, MainFrame::OnSizeMode)
+EVT_MENU(SIZEALLOCATED, MainFrame::OnSizeMode)
+EVT_MENU(LARGESTITEMS, MainFrame::OnLargestItems)
+EVT_MENU(FILETYPES, MainFrame::OnFileTypes)
+EVT_MENU(FINDDUPLICATES, MainFrame::OnFindDuplicates)
+EVT_MENU(AGES, MainFrame::OnAges)
+EVT_MENU(OWNERS, MainFrame::OnOwners)
+EVT_MENU(ONEFILESYSTEM, MainFrame::OnLimits)
+EVT_MENU(SKIPVIRTUAL, MainFrame::OnLimits)
+EVT_MENU(SKIPNAMES, MainFrame::OnSkipNames)
+EVT_MENU(LOWPRIORITY, MainFrame::OnLimits)
+EVT_MENU(RATELIMIT, MainFrame::OnRateLimit)
 EVT_MENU(wxID_INDENT, MainFrame::OnSourceCode)
 EVT_MENU(wxID_UP, MainFrame::OnUpdates)
 EVT_MENU(wxID_PROPERTIES, MainFrame::OnToggleSidebar)
 EVT_MENU(wxID_JUSTIFY_FILL, MainFrame::OnToggleLog)
-EVT_COMMAND(PROGEVT, progEvt, MainFrame::OnUpdateUI)
+EVT_MENU(TREEMAP, MainFrame::OnToggleTreemap)
 EVT_COMMAND(RELOADEVT, progEvt, MainFrame::OnUpdateReload)
 EVT_COMMAND(LOGEVT, progEvt, MainFrame::OnLog)
+EVT_COMMAND(SIDEBAREVT, progEvt, MainFrame::OnSidebarRefresh)
 EVT_BUTTON(wxID_OPEN, MainFrame::OnOpenFolder)
 EVT_BUTTON(COPYPATH, MainFrame::OnCopy)
 EVT_BUTTON(wxID_FIND, MainFrame::OnReveal)
 EVT_BUTTON(wxID_STOP, MainFrame::OnAbort)
+EVT_MENU(wxID_STOP, MainFrame::OnAbort)
+EVT_MENU(PAUSESIZING, MainFrame::OnPause)
 EVT_BUTTON(wxID_CLEAR, MainFrame::OnClearLog)
 EVT_BUTTON(wxID_COPY, MainFrame::OnCopyLog)
 EVT_MENU(wxID_REFRESH,MainFrame::OnReloadFolder)
 EVT_BUTTON(wxID_REFRESH,MainFrame::OnReloadFolder)
 wxEND_EVENT_TABLE()
 
-MainFrame::MainFrame(wxWindow* parent) : MainFrameBase( parent )
+wxBEGIN_EVENT_TABLE(Ages, wxDialog)
+EVT_CHOICE(AGEBASIS, Ages::OnBasis)
+wxEND_EVENT_TABLE()
+
+MainFrame::MainFrame(wxWindow* parent) : MainFrameBase( parent ), watchTimer(this, WATCH)
 {
 	//perform any additional setup here
 	SetLabel(AppName + " v" + AppVersion);
@@ -92,6 +121,18 @@ MainFrame::MainFrame(wxWindow* parent) : MainFrameBase( parent )
 	// default unsplit
 	browserSplitter->Unsplit();
 	AddDisplay(folderData);
+	
+	//the treemap shares the browser with the displays
+	treemap = new TreemapPanel(scrollView->GetParent(), this);
+	scrollView->GetContainingSizer()->Add(treemap, 1, wxALL|wxEXPAND, 5);
+	treemap->Hide();
+	
+	sidebarRefresher = make_unique<statRefresher>([this](uint64_t request, const itemDetails& details){
+		//called from the refresher's thread
+		wxCommandEvent* evt = new wxCommandEvent(progEvt, SIDEBAREVT);
+		evt->SetClientData(new pair<uint64_t, itemDetails>(request, details));
+		GetEventHandler()->QueueEvent(evt);
+	});
 }
 
 /**
@@ -99,8 +140,13 @@ MainFrame::MainFrame(wxWindow* parent) : MainFrameBase( parent )
  @param folder the path to the folder to size
  */
 void MainFrame::SizeRootFolder(const string& folder){
-	//deallocate existing data
-	delete folderData;
+	//deallocate existing data, once nothing is sizing it
+	StopSizing();
+	StopWatching();
+	//the subfolder displays and the selection point into the old tree
+	CloseSubDisplays();
+	delete tree;
+	folderData = nullptr;
 	//clear the log
 	logCtrl->SetValue("");
 	//hide the log
@@ -113,28 +159,733 @@ void MainFrame::SizeRootFolder(const string& folder){
 
 	userClosedLog = false;
 	
-	progCallback callback = [&](float progress, DirectoryData* data){
-		wxCommandEvent event(progEvt);
-		event.SetId(PROGEVT);
-		event.SetInt(progress * 100);
-		event.SetClientData(data);
-		
-		//invoke event to notify needs to update UI
-		wxPostEvent(this, event);
+	progCallback callback = [this](const progressSnapshot& progress, DirectoryData* data){
+		UpdateProgress(progress, data);
 	};
-	currentDisplay[0]->data = new DirectoryData(folder, true);
-	currentDisplay[0]->Size(callback);
+	treemap->SetTree(nullptr);
+	tree = new DirectoryTree(folder);
+	tree->mode = sizeMode;
+	currentDisplay[0]->tree = tree;
+	currentDisplay[0]->data = tree->root();
+	currentDisplay[0]->Size(callback, limits);
+}
+
+/**
+ @return true if any display is sizing a folder
+ */
+bool MainFrame::IsSizing(){
+	for (FolderDisplay* disp : currentDisplay){
+		if (disp->IsSizing()){
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ Stop every display that is sizing, and wait for their workers to finish
+ */
+void MainFrame::StopSizing(){
+	for (FolderDisplay* disp : currentDisplay){
+		disp->Stop();
+	}
+	pauseMenu->Check(false);
+}
+
+/**
+ Called when the stop button or menu is selected. Stops sizing, keeping the sizes found so far.
+ @param event (unused) event from sender
+ */
+void MainFrame::OnAbort(wxCommandEvent& event){
+	if (!IsSizing()){
+		return;
+	}
+	StopSizing();
+	statusBar->SetStatusText("Stopped sizing. Folders that were not read are shown empty, use Rescan Changed Folders to finish sizing them.");
 }
 
 /**
- Populate the sidebar with info about a particular item in the tree
- @param ptr the DirectoryData object stored to load properties for
+ Called when the pause menu is toggled. Pauses or resumes every display that is sizing.
+ @param event the event from the menu item
+ */
+void MainFrame::OnPause(wxCommandEvent& event){
+	if (!IsSizing()){
+		pauseMenu->Check(false);
+		return;
+	}
+	for (FolderDisplay* disp : currentDisplay){
+		disp->SetPaused(event.IsChecked());
+	}
+	statusBar->SetStatusText(event.IsChecked() ? "Paused" : "");
+}
+
+/**
+ Called when the open scan menu is selected. Replaces the current tree with one loaded from a snapshot file.
+ @param event (unused) event from sender
+ */
+void MainFrame::OnOpenScan(wxCommandEvent& event){
+	if (IsSizing()){
+		wxMessageBox("Wait for sizing to finish before opening a scan.", "Sizing in progress");
+		return;
+	}
+	wxFileDialog dlg(this, "Open a saved scan", "", "", "FatFileFinder scans (*.fffscan)|*.fffscan|All files|*", wxFD_OPEN | wxFD_FILE_MUST_EXIST);
+	if (dlg.ShowModal() == wxID_CANCEL){
+		return;
+	}
+	DirectoryTree* loadedTree;
+	try{
+		loadedTree = DirectoryTree::load(dlg.GetPath().ToStdString());
+	}
+	catch(exception& e){
+		wxMessageBox(e.what(), "Cannot open scan");
+		return;
+	}
+	
+	//the first display shows the loaded root
+	CloseSubDisplays();
+	
+	StopWatching();
+	delete tree;
+	tree = loadedTree;
+	tree->mode = sizeMode;
+	folderData = tree->root();
+	currentDisplay[0]->tree = tree;
+	currentDisplay[0]->data = folderData;
+	currentDisplay[0]->ClearResults();
+	currentDisplay[0]->display();
+	treemap->SetTree(tree);
+	progressBar->SetValue(100);
+	UpdateTitlebar(100, sizeToString(tree->sizeOf(folderData)));
+}
+
+/**
+ Called when the rescan menu is selected. Sizes the root folder again, reading only the folders that changed.
+ @param event (unused) event from sender
+ */
+void MainFrame::OnRescan(wxCommandEvent& event){
+	if (tree == nullptr || IsSizing()){
+		return;
+	}
+	//folders that changed get new items, so the displays of subfolders may be out of date
+	CloseSubDisplays();
+	treemap->SetTree(nullptr);
+	progCallback callback = [this](const progressSnapshot& progress, DirectoryData* data){
+		UpdateProgress(progress, data);
+	};
+	currentDisplay[0]->Size(callback, limits, true);
+}
+
+/**
+ Called when the watch for changes menu is toggled. Starts or stops keeping the tree up to date as files change.
+ @param event the event from the menu item
+ */
+void MainFrame::OnWatch(wxCommandEvent& event){
+	if (!event.IsChecked()){
+		StopWatching();
+		return;
+	}
+#if defined __linux__
+	if (tree == nullptr || IsSizing()){
+		watchMenu->Check(false);
+		wxMessageBox("Size a folder, and wait for sizing to finish, before watching it for changes.", "Nothing to watch");
+		return;
+	}
+	watcher = make_unique<treeWatcher>(*tree, [this](const string& msg){
+		//called from the watcher's thread
+		wxCommandEvent* evt = new wxCommandEvent(progEvt, LOGEVT);
+		evt->SetString(msg);
+		GetEventHandler()->QueueEvent(evt);
+	});
+	watchTimer.Start(watchInterval);
+#else
+	watchMenu->Check(false);
+	wxMessageBox("Watching for changes is not supported on this platform. Use Rescan Changed Folders instead.", "Not supported");
+#endif
+}
+
+/**
+ Called at a fixed rate while watching. Applies the changes found since the last call to the tree, then refreshes the displays.
+ @param event (unused) event from the timer
+ */
+void MainFrame::OnWatchTimer(wxTimerEvent& event){
+#if defined __linux__
+	//changes stay queued until sizing finishes
+	if (watcher == nullptr || IsSizing()){
+		return;
+	}
+	vector<treeWatcher::change> changes;
+	watcher->takeChanges(changes);
+	DirectoryTree::movedList moved;
+	bool changed = false;
+	//folders that appear are sized now, so they follow the current limits like any other sizing
+	for (const treeWatcher::change& item : changes){
+		changed |= treeWatcher::apply(*tree, item, limits, moved, [this](const string& msg){
+			Log(msg);
+		});
+	}
+	if (!changed){
+		return;
+	}
+	
+	//items that moved are shown from their new index. Their old indices may already hold other items, so the moves are followed in order.
+	for (const auto& move : moved){
+		DirectoryData* from = tree->at(move.first);
+		DirectoryData* to = move.second == noNode ? nullptr : tree->at(move.second);
+		for (int i = 1; i < currentDisplay.size(); i++){
+			if (currentDisplay[i]->data != from){
+				continue;
+			}
+			if (to != nullptr){
+				currentDisplay[i]->data = to;
+				continue;
+			}
+			//a removed folder's display and those of its subfolders are closed
+			for (int j = i; j < currentDisplay.size(); j++){
+				currentDisplay[j]->Stop();
+				currentDisplay[j]->Destroy();
+			}
+			currentDisplay.erase(currentDisplay.begin() + i, currentDisplay.end());
+			scrollSizer->SetCols(i);
+			selected = nullptr;
+			break;
+		}
+		if (selected == from){
+			selected = to;
+		}
+		if (sidebarItem == from){
+			sidebarItem = to;
+		}
+	}
+	for (FolderDisplay* disp : currentDisplay){
+		disp->display();
+	}
+	treemap->Moved(moved);
+	treemap->Changed();
+	folderData = tree->root();
+	UpdateTitlebar(100, sizeToString(tree->sizeOf(folderData)) + ", " + to_string(folderData->num_items) + " items");
+#endif
+}
+
+/**
+ Called when a size mode is chosen in the view menu. Shows every size again in the new mode.
+ @param event the event from the menu item
+ */
+void MainFrame::OnSizeMode(wxCommandEvent& event){
+	switch (event.GetId()){
+		case SIZELINKSONCE:
+			sizeMode = DirectoryTree::sizeMode::linksOnce;
+			break;
+		case SIZEALLOCATED:
+			sizeMode = DirectoryTree::sizeMode::allocated;
+			break;
+		default:
+			sizeMode = DirectoryTree::sizeMode::apparent;
+			break;
+	}
+	if (tree == nullptr){
+		return;
+	}
+	tree->mode = sizeMode;
+	//while sizing, the displays pick up the mode when sizing finishes
+	if (IsSizing()){
+		return;
+	}
+	for (FolderDisplay* disp : currentDisplay){
+		disp->display();
+	}
+	treemap->Changed();
+	folderData = tree->root();
+	UpdateTitlebar(100, sizeToString(tree->sizeOf(folderData)) + ", " + to_string(folderData->num_items) + " items");
+	if (selected != nullptr){
+		PopulateSidebar(selected);
+	}
+}
+
+/**
+ Called when the largest items menu is selected. Lists the largest files and folders the root folder's sizing found,
+ without walking the tree.
+ @param event (unused) event from sender
+ */
+void MainFrame::OnLargestItems(wxCommandEvent& event){
+	if (tree == nullptr || IsSizing()){
+		wxMessageBox("Size a folder, and wait for sizing to finish, to see its largest items.", "Nothing to show");
+		return;
+	}
+	const largestItems& largest = currentDisplay[0]->Largest();
+	//a scan opened from a file was not sized, so nothing was ranked
+	if (largest.files().empty() && largest.folders().empty()){
+		wxMessageBox("The largest items are found while sizing. Use Rescan Changed Folders to find them for this scan.", "Nothing to show");
+		return;
+	}
+	LargestItems dlg(this, largest);
+	dlg.ShowModal();
+}
+
+/**
+ Fill the list with the largest files and folders, largest first
+ @param parent the window to show the dialog over
+ @param largest the items found while sizing
+ */
+LargestItems::LargestItems(wxWindow* parent, const largestItems& largest) : LargestItemsBase(parent){
+	//the largest files and the largest folders are kept separately, so they are merged here
+	vector<pair<const largestItems::ranked*, bool>> items;
+	for (const largestItems::ranked& item : largest.files()){
+		items.push_back({&item, false});
+	}
+	for (const largestItems::ranked& item : largest.folders()){
+		items.push_back({&item, true});
+	}
+	stable_sort(items.begin(), items.end(), [](const pair<const largestItems::ranked*, bool>& a, const pair<const largestItems::ranked*, bool>& b){
+		return a.first->size > b.first->size;
+	});
+	for (const auto& [item, isFolder] : items){
+		wxVector<wxVariant> row;
+		row.push_back(wxString(sizeToString(item->size)));
+		row.push_back(FolderDisplay::iconForExtension(path(item->path).filename().string(), isFolder) + (isFolder ? " Folder" : " File"));
+		row.push_back(wxString::FromUTF8(item->path.c_str()));
+		largestList->AppendItem(row);
+	}
+	largestSummary->SetLabel("The " + to_string(largest.files().size()) + " largest files and " + to_string(largest.folders().size()) + " largest folders found by the last sizing");
+}
+
+/**
+ Gets the folder the summary dialogs describe
+ @return the selected folder, or the root if nothing or a file is selected
+ @note selected is cleared by CloseSubDisplays whenever the tree is replaced or rebuilt, so it never outlives the tree
+ */
+DirectoryData* MainFrame::SelectedFolder() const{
+	if (tree == nullptr){
+		return nullptr;
+	}
+	return selected != nullptr && selected->isFolder ? selected : tree->root();
+}
+
+/**
+ Called when the file types menu is selected. Shows the types of the files in the selected folder, or in the whole scan if no folder is selected.
+ @param event (unused) event from sender
+ */
+void MainFrame::OnFileTypes(wxCommandEvent& event){
+	if (tree == nullptr || IsSizing()){
+		wxMessageBox("Size a folder, and wait for sizing to finish, to see the types of its files.", "Nothing to show");
+		return;
+	}
+	DirectoryData* folder = SelectedFolder();
+	//the whole scan was counted while sizing. A subfolder, or a scan opened from a file, is counted now.
+	const typeHistogram* types = &currentDisplay[0]->Types();
+	typeHistogram counted;
+	if (folder != tree->root() || types->empty()){
+		counted.addTree(*tree, tree->indexOf(folder));
+		types = &counted;
+	}
+	FileTypes dlg(this, *types, tree->pathOf(folder));
+	dlg.ShowModal();
+}
+
+/**
+ Fill the lists with the space each category and extension takes, largest first
+ @param parent the window to show the dialog over
+ @param types the counts to show
+ @param folder the path of the folder the counts are for
+ */
+FileTypes::FileTypes(wxWindow* parent, const typeHistogram& types, const string& folder) : FileTypesBase(parent){
+	//the number of extensions to list, the rest are only counted in their category
+	constexpr size_t numExtensions = 200;
+	typeTotals total = types.total();
+	auto addRow = [&](wxDataViewListCtrl* list, const wxString& name, const typeTotals& totals){
+		wxVector<wxVariant> row;
+		row.push_back(name);
+		row.push_back((long)(total.bytes > 0 ? (long double)totals.bytes / total.bytes * 100 : 0));
+		row.push_back(wxString(sizeToString(totals.bytes)));
+		row.push_back(wxString(to_string(totals.files)));
+		list->AppendItem(row);
+	};
+	
+	array<size_t, numCategories> order;
+	for (size_t i = 0; i < numCategories; i++){
+		order[i] = i;
+	}
+	stable_sort(order.begin(), order.end(), [&](size_t a, size_t b){
+		return types.categories[a].bytes > types.categories[b].bytes;
+	});
+	for (size_t i : order){
+		const typeTotals& totals = types.categories[i];
+		if (totals.files > 0){
+			fileCategory category = (fileCategory)i;
+			addRow(categoryList, FolderDisplay::iconForCategory(category) + " " + categoryName(category), totals);
+		}
+	}
+	for (const auto& [extension, totals] : types.largestExtensions(numExtensions)){
+		addRow(extensionList, FolderDisplay::iconForCategory(categoryOf(extension)) + " " + wxString::FromUTF8(extensionName(extension).c_str()), totals);
+	}
+	typesSummary->SetLabel(sizeToString(total.bytes) + " in " + to_string(total.files) + " files in " + folder);
+}
+
+/**
+ Called when the owners menu is selected. Shows the owners of the files in the selected folder, or in the whole scan if no folder is selected.
+ @param event (unused) event from sender
+ */
+void MainFrame::OnOwners(wxCommandEvent& event){
+	if (tree == nullptr || IsSizing()){
+		wxMessageBox("Size a folder, and wait for sizing to finish, to see who owns its files.", "Nothing to show");
+		return;
+	}
+	DirectoryData* folder = SelectedFolder();
+	//the whole scan was counted while sizing. A subfolder, or a scan opened from a file, is counted now from the stored owners.
+	const ownerHistogram* owners = &currentDisplay[0]->Owners();
+	ownerHistogram counted;
+	if (folder != tree->root() || owners->empty()){
+		counted.addTree(*tree, tree->indexOf(folder));
+		owners = &counted;
+	}
+	Owners dlg(this, *owners, tree->pathOf(folder));
+	dlg.ShowModal();
+}
+
+/**
+ Fill the lists with the space each user and group owns, largest first
+ @param parent the window to show the dialog over
+ @param owners the counts to show
+ @param folder the path of the folder the counts are for
+ */
+Owners::Owners(wxWindow* parent, const ownerHistogram& owners, const string& folder) : OwnersBase(parent){
+	//the number of users, and of groups, to list
+	constexpr size_t numOwners = 200;
+	ownerTotals total = owners.total();
+	auto addRow = [&](wxDataViewListCtrl* list, const string& name, const ownerTotals& totals){
+		wxVector<wxVariant> row;
+		row.push_back(wxString::FromUTF8(name.c_str()));
+		row.push_back((long)(total.bytes > 0 ? (long double)totals.bytes / total.bytes * 100 : 0));
+		row.push_back(wxString(sizeToString(totals.bytes)));
+		row.push_back(wxString(to_string(totals.files)));
+		list->AppendItem(row);
+	};
+	for (const auto& [user, totals] : owners.largestUsers(numOwners)){
+		addRow(userList, userName(user), totals);
+	}
+	for (const auto& [group, totals] : owners.largestGroups(numOwners)){
+		addRow(groupList, groupName(group), totals);
+	}
+	ownersSummary->SetLabel(sizeToString(total.bytes) + " in " + to_string(total.files) + " files in " + folder + ", owned by " + to_string(owners.users.size()) + " users and " + to_string(owners.groups.size()) + " groups");
+}
+
+/**
+ Called when the find duplicates menu is selected. Compares the files in the selected folder, or in the whole scan if no folder is selected,
+ on background threads while a progress dialog is shown.
+ @param event (unused) event from sender
+ */
+void MainFrame::OnFindDuplicates(wxCommandEvent& event){
+	if (tree == nullptr || IsSizing()){
+		wxMessageBox("Size a folder, and wait for sizing to finish, to find its duplicates.", "Nothing to search");
+		return;
+	}
+	DirectoryData* folder = SelectedFolder();
+	//the tree must not change while it is searched, so changes found by the watcher wait until the search finishes
+	bool watching = watchTimer.IsRunning();
+	watchTimer.Stop();
+	
+	duplicateFinder finder;
+	vector<duplicateGroup> groups;
+	atomic<bool> finished{false};
+	thread search([&]{
+		groups = finder.find(*tree, tree->indexOf(folder), [this](const string& msg){
+			//called from the finder's threads
+			wxCommandEvent* evt = new wxCommandEvent(progEvt, LOGEVT);
+			evt->SetString(msg);
+			GetEventHandler()->QueueEvent(evt);
+		});
+		finished = true;
+	});
+	{
+		wxProgressDialog progress("Find Duplicates", "Comparing files of the same size...", 100, this, wxPD_APP_MODAL | wxPD_CAN_ABORT | wxPD_ELAPSED_TIME);
+		while (!finished){
+			string status = "Read " + to_string(finder.filesRead.load()) + " files, " + sizeToString(finder.bytesRead.load()) + ", " + to_string(finder.pending.load()) + " to go";
+			if (!progress.Pulse(status)){
+				finder.control.cancel();
+			}
+			wxMilliSleep(100);
+		}
+	}
+	search.join();
+	if (watching){
+		watchTimer.Start(watchInterval);
+	}
+	
+	Duplicates dlg(this, groups, tree->pathOf(folder), finder.control.cancelled());
+	dlg.ShowModal();
+}
+
+/**
+ Fill the list with each group of duplicates, the group that frees the most first. A group's first row shows its totals.
+ @param parent the window to show the dialog over
+ @param groups the groups found
+ @param folder the path of the folder that was searched
+ @param stopped true if the search was stopped before it finished
+ */
+Duplicates::Duplicates(wxWindow* parent, const vector<duplicateGroup>& groups, const string& folder, bool stopped) : DuplicatesBase(parent){
+	fileSize reclaimable = 0;
+	for (const duplicateGroup& group : groups){
+		reclaimable += group.reclaimable();
+		for (size_t i = 0; i < group.paths.size(); i++){
+			wxVector<wxVariant> row;
+			row.push_back(i == 0 ? wxString(sizeToString(group.reclaimable())) : wxString());
+			row.push_back(i == 0 ? wxString(sizeToString(group.size)) : wxString());
+			row.push_back(wxString::FromUTF8(group.paths[i].c_str()));
+			duplicatesList->AppendItem(row);
+		}
+	}
+	duplicatesSummary->SetLabel(to_string(groups.size()) + " groups of duplicates in " + folder + ", " + sizeToString(reclaimable) + " reclaimable" + (stopped ? " (stopped before every file was compared)" : ""));
+}
+
+/**
+ Called when the ages menu is selected. Shows the ages of the files in the selected folder, or in the whole scan if no folder is selected.
+ @param event (unused) event from sender
+ */
+void MainFrame::OnAges(wxCommandEvent& event){
+	if (tree == nullptr || IsSizing()){
+		wxMessageBox("Size a folder, and wait for sizing to finish, to see how long ago its files were used.", "Nothing to show");
+		return;
+	}
+	DirectoryData* folder = SelectedFolder();
+	//the buckets are counted in one size mode, so they are counted again after the mode changes
+	if (tree->agesMode != tree->mode){
+		tree->recountAges();
+	}
+	//changes found by the watcher can move the folder to a new index, so they wait until the dialog is closed
+	bool watching = watchTimer.IsRunning();
+	watchTimer.Stop();
+	{
+		Ages dlg(this, tree, tree->indexOf(folder));
+		dlg.ShowModal();
+	}
+	if (watching){
+		watchTimer.Start(watchInterval);
+	}
+}
+
+/**
+ Show the ages of the files below a folder
+ @param parent the window to show the dialog over
+ @param contentsTree the sized tree, which is counted again if another basis is chosen
+ @param index the index of the folder
+ */
+Ages::Ages(wxWindow* parent, DirectoryTree* contentsTree, nodeIndex index) : AgesBase(parent){
+	tree = contentsTree;
+	folder = index;
+	agesBasisChoice->SetSelection((int)tree->agesBy);
+	Fill();
+}
+
+/**
+ Fill the lists with the bytes in each age, and the folders with the most bytes not used in over a year
+ */
+void Ages::Fill(){
+	//the number of folders to list
+	constexpr size_t numFolders = 100;
+	//the first bucket of files not used in over a year
+	constexpr size_t stale = 3;
+	agesList->DeleteAllItems();
+	staleList->DeleteAllItems();
+	auto addRow = [](wxDataViewListCtrl* list, const wxString& first, fileSize bytes, fileSize of, const wxString& last){
+		wxVector<wxVariant> row;
+		row.push_back(first);
+		row.push_back((long)(of > 0 ? (long double)bytes / of * 100 : 0));
+		row.push_back(last);
+		list->AppendItem(row);
+	};
+	
+	const ageBuckets& total = *tree->agesAt(folder);
+	for (size_t i = 0; i < ageBuckets::count; i++){
+		addRow(agesList, ageBuckets::name(i), total.bytes[i], total.from(0), sizeToString(total.bytes[i]));
+	}
+	
+	vector<pair<fileSize, nodeIndex>> folders;
+	vector<nodeIndex> pending{folder};
+	while (pending.size() > 0){
+		const DirectoryData* item = tree->at(pending.back());
+		pending.pop_back();
+		if (item->isSymlink){
+			continue;
+		}
+		for (uint32_t i = 0; i < item->numFolders; i++){
+			nodeIndex sub = item->firstChild + i;
+			folders.push_back({tree->agesAt(sub)->from(stale), sub});
+			pending.push_back(sub);
+		}
+	}
+	size_t count = min(numFolders, folders.size());
+	partial_sort(folders.begin(), folders.begin() + count, folders.end(), [](const pair<fileSize, nodeIndex>& a, const pair<fileSize, nodeIndex>& b){
+		return a.first > b.first;
+	});
+	for (size_t i = 0; i < count && folders[i].first > 0; i++){
+		addRow(staleList, sizeToString(folders[i].first), folders[i].first, tree->agesAt(folders[i].second)->from(0), wxString::FromUTF8(tree->pathOf(tree->at(folders[i].second)).c_str()));
+	}
+	agesSummary->SetLabel(sizeToString(total.from(stale)) + " of " + sizeToString(total.from(0)) + " in " + tree->pathOf(tree->at(folder)) + " not used in over a year");
+}
+
+/**
+ Called when another of the files' times is chosen to measure their ages by. Counts the buckets again from the stored times.
+ @param event the event from the choice
+ */
+void Ages::OnBasis(wxCommandEvent& event){
+	tree->agesBy = (DirectoryTree::ageBasis)event.GetSelection();
+	tree->recountAges();
+	Fill();
+}
+
+/**
+ Called when a scan limit is toggled in the file menu. The limits apply the next time a folder is sized.
+ @param event the event from the menu item
+ */
+void MainFrame::OnLimits(wxCommandEvent& event){
+	switch (event.GetId()){
+		case ONEFILESYSTEM:
+			limits.oneFileSystem = event.IsChecked();
+			break;
+		case SKIPVIRTUAL:
+			limits.excludedTypes = event.IsChecked() ? scanLimits::virtualTypes() : vector<string>();
+			break;
+		case LOWPRIORITY:
+			limits.rate.lowPriority = event.IsChecked();
+			break;
+	}
+}
+
+/**
+ Called when the skip items by name menu is selected. Asks for the patterns to skip, which apply the next time a folder is sized.
+ @param event (unused) event from sender
+ */
+void MainFrame::OnSkipNames(wxCommandEvent& event){
+	wxTextEntryDialog dlg(this, "Names of files and folders to skip, one per line. * and ? match any characters.\nStart a line with + to size only the files that match it.", "Skip Items by Name", wxString::FromUTF8(skipPatterns.c_str()), wxOK | wxCANCEL | wxTE_MULTILINE);
+	if (dlg.ShowModal() == wxID_CANCEL){
+		return;
+	}
+	string text = dlg.GetValue().ToStdString();
+	nameFilter names;
+	istringstream lines(text);
+	string line;
+	try{
+		while (getline(lines, line)){
+			//ignore blank lines and stray carriage returns
+			line.erase(line.find_last_not_of(" \t\r") + 1);
+			if (line.empty()){
+				continue;
+			}
+			if (line[0] == '+'){
+				names.include(line.substr(1));
+			}
+			else{
+				names.exclude(line);
+			}
+		}
+	}
+	catch(invalid_argument& e){
+		wxMessageBox(e.what(), "Cannot use pattern");
+		return;
+	}
+	limits.names = names;
+	skipPatterns = text;
+}
+
+/**
+ Called when the limit sizing rate menu is selected. Asks for the most operations per second, which applies the next time a folder is sized.
+ @param event (unused) event from sender
+ */
+void MainFrame::OnRateLimit(wxCommandEvent& event){
+	long value = wxGetNumberFromUser("The most files and folders to read each second while sizing.\nUse 0 to read as fast as possible.", "Operations per second:", "Limit Sizing Rate", limits.rate.operationsPerSecond, 0, 1000000, this);
+	//-1 if cancelled
+	if (value >= 0){
+		limits.rate.operationsPerSecond = (uint32_t)value;
+	}
+}
+
+/**
+ Stop watching for changes, discarding any that were not applied
+ */
+void MainFrame::StopWatching(){
+	watchTimer.Stop();
+#if defined __linux__
+	watcher.reset();
+#endif
+	watchMenu->Check(false);
+}
+
+/**
+ Remove every display except the first, and clear the selection and the item the sidebar refreshes
+ */
+void MainFrame::CloseSubDisplays(){
+	for (int i = 1; i < currentDisplay.size(); i++){
+		currentDisplay[i]->Stop();
+		currentDisplay[i]->Destroy();
+	}
+	currentDisplay.erase(currentDisplay.begin() + 1, currentDisplay.end());
+	scrollSizer->SetCols(1);
+	selected = nullptr;
+	//drop a sidebar refresh still on its way. Request numbers start at 1, so none matches.
+	sidebarItem = nullptr;
+	sidebarRequest = 0;
+}
+
+/**
+ Called when the save scan menu is selected. Saves the current tree to a snapshot file.
+ @param event (unused) event from sender
+ */
+void MainFrame::OnSaveScan(wxCommandEvent& event){
+	if (tree == nullptr){
+		return;
+	}
+	if (IsSizing()){
+		wxMessageBox("Wait for sizing to finish before saving the scan.", "Sizing in progress");
+		return;
+	}
+	wxFileDialog dlg(this, "Save scan", "", "scan.fffscan", "FatFileFinder scans (*.fffscan)|*.fffscan", wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+	if (dlg.ShowModal() == wxID_CANCEL){
+		return;
+	}
+	try{
+		tree->save(dlg.GetPath().ToStdString());
+	}
+	catch(exception& e){
+		wxMessageBox(e.what(), "Cannot save scan");
+	}
+}
+
+/**
+ Show an item in the sidebar from the details stored in the tree, without reading the file system, then read the item again
+ in the background. Moving through items quickly, even on a slow network mount, never waits on a stat.
+ @param ptr the item to show
  */
 void MainFrame::PopulateSidebar(DirectoryData* ptr){
-	path p = ptr->Path;
+	ShowSidebar(ptr, itemDetails::stored(*tree, tree->indexOf(ptr)));
+	//the stored details are as of sizing, or the watcher's last change to the item
+	sidebarRequest = sidebarRefresher->request(tree->pathOf(ptr));
+}
+
+/**
+ Called when the refresher has read the item in the sidebar. Shows the item again only if it changed since it was sized.
+ @param event the event, holding the request number and the details that were read
+ */
+void MainFrame::OnSidebarRefresh(wxCommandEvent& event){
+	auto* result = (pair<uint64_t, itemDetails>*)event.GetClientData();
+	//ignore reads that a newer selection replaced, or whose item is no longer shown
+	if (result->first == sidebarRequest && tree != nullptr && sidebarItem != nullptr && sidebarItem == selected && result->second != sidebarDetails){
+		ShowSidebar(sidebarItem, result->second);
+	}
+	delete result;
+}
+
+/**
+ Fill the sidebar with an item's properties
+ @param ptr the item to show
+ @param details the item's details, from the tree or read again
+ */
+void MainFrame::ShowSidebar(DirectoryData* ptr, const itemDetails& details){
+	sidebarItem = ptr;
+	sidebarDetails = details;
+	string itemPath = tree->pathOf(ptr);
+	path p = itemPath;
 	propertyList->SetTextValue(p.filename().string(), 0, 1);
 	//make sure it exists
-	if (!exists(ptr->Path)){
+	if (!details.exists){
 		for (int i = 1; i < propertyList->GetItemCount(); i++){
 			propertyList->SetTextValue("[Deleted]", i, 1);
 		}
@@ -142,47 +893,49 @@ void MainFrame::PopulateSidebar(DirectoryData* ptr){
 	}
 	
 	propertyList->SetTextValue(ptr->isFolder? "" : to_string(ptr->num_items),3,1);
-	propertyList->SetTextValue(FolderDisplay::sizeToString(ptr->size), 1, 1);
+	propertyList->SetTextValue(sizeToString(tree->sizeOf(ptr)), 1, 1);
 
 	string ext = p.extension().string();
 	//special case for files with no extension
 	string suffix = ptr->isFolder? "Folder" : (ext.size() == 0? "" : ext.substr(1)) + " File";
-	propertyList->SetTextValue(FolderDisplay::iconForExtension(ptr) + " " + suffix, 2, 1);
+	propertyList->SetTextValue(FolderDisplay::iconForExtension(p.filename().string(), ptr->isFolder) + " " + suffix, 2, 1);
 	
-	//modified date
-	propertyList->SetTextValue(timeToString(file_modify_time(ptr->Path)),4,1);
-	propertyList->SetTextValue(timeToString(file_create_time(ptr->Path)), 5, 1);
-	propertyList->SetTextValue(timeToString(file_access_time(ptr->Path)), 6, 1);
+	//items that were never stat'ed, such as folders that were not entered, are left blank until they are read
+	bool known = details.mode.known();
+	auto showTime = [&](int64_t time, int row){
+		propertyList->SetTextValue(known ? timeToString((time_t)time) : "", row, 1);
+	};
+	showTime(details.times.modified, 4);
+	showTime(details.times.changed, 5);
+	showTime(details.times.accessed, 6);
 	
 	//Is read only
-	propertyList->SetTextValue(is_writable(ptr->Path)? "No" : "Yes", 8, 1);
+	propertyList->SetTextValue(!known ? "" : is_writable(details.mode.mode)? "No" : "Yes", 8, 1);
 	
 	//Is executable
-	propertyList->SetTextValue(is_executable(ptr->Path)? "Yes" : "No", 9, 1);
+	propertyList->SetTextValue(!known ? "" : is_executable(details.mode.mode)? "Yes" : "No", 9, 1);
 	
 	//is symbolic link
 	propertyList->SetTextValue(ptr->isSymlink? "Yes" : "No", 10, 1);
 	
-	//Is Hidden
-	propertyList->SetTextValue(is_hidden(ptr->Path)? "Yes" : "No", 7, 1);
-	
 #if defined __APPLE__ || defined __linux__
+	//Is Hidden, decided by the name
+	propertyList->SetTextValue(is_hidden(itemPath)? "Yes" : "No", 7, 1);
+	
 	//mode_t
-	propertyList->SetTextValue(modet_type_for(ptr->Path), 11, 1);
+	propertyList->SetTextValue(known ? modet_type_for(details.mode.mode) : "", 11, 1);
 
 	//perms string
-	propertyList->SetTextValue(permstr_for(ptr->Path), 12, 1);
+	propertyList->SetTextValue(known ? permstr_for(details.mode.mode) : "", 12, 1);
 	
 	//Size on disk
-	propertyList->SetTextValue(!ptr->isFolder? FolderDisplay::sizeToString(size_on_disk(ptr->Path)) : "-", 13, 1);
+	propertyList->SetTextValue(!ptr->isFolder? (known ? sizeToString(details.allocated) : "") : "-", 13, 1);
 	
 # elif defined _WIN32
-
-	//file args windows
-	auto args = file_attributes_for(ptr->Path);
-
-	for (int i = 0; i < args.size(); i++) {
-		propertyList->SetTextValue(args[i] ? "Yes" : "No", 11+i, 1);
+	//the attributes are not stored in the tree, so they are shown once the item is read
+	propertyList->SetTextValue(!details.attributesRead ? "" : details.hidden ? "Yes" : "No", 7, 1);
+	for (int i = 0; i < details.attributes.size(); i++) {
+		propertyList->SetTextValue(!details.attributesRead ? "" : details.attributes[i] ? "Yes" : "No", 11+i, 1);
 	}
 
 #endif
@@ -194,24 +947,26 @@ void MainFrame::PopulateSidebar(DirectoryData* ptr){
 }
 
 /**
- Refresh the UI on progress updates
- @param event the command event from the sender. Must have client data set on it.
+ Refresh the UI on progress updates. Called on the main thread at a fixed rate while the root folder sizes.
+ @param progress the sizer's counters
+ @param data the folder being sized
  */
-void MainFrame::OnUpdateUI(wxCommandEvent& event){
+void MainFrame::UpdateProgress(const progressSnapshot& progress, DirectoryData* data){
 	//TODO: this only updates the main progress bar
-	
-	//update pointer
-	DirectoryData* fd = (DirectoryData*)event.GetClientData();
-	folderData = fd;
-	//update progress
-	int prog = event.GetInt();
+	folderData = data;
+	int prog = progress.fraction * 100;
 	progressBar->SetValue(prog);
-	if(prog == 100){
-		currentDisplay[0]->data = fd;
-		currentDisplay[0]->display();
+	
+	//show the folder a worker is currently reading
+	if (!progress.done && progress.current != noNode && !pauseMenu->IsChecked()){
+		statusBar->SetStatusText(tree->pathOf(tree->at(progress.current)));
+	}
+	if (progress.done){
+		pauseMenu->Check(false);
+		treemap->SetTree(tree);
 	}
 	
-	UpdateTitlebar(prog, FolderDisplay::sizeToString(fd->size));
+	UpdateTitlebar(prog, sizeToString(progress.done ? tree->sizeOf(data) : progress.bytes) + ", " + to_string(progress.items) + " items");
 }
 
 /**
@@ -231,7 +986,7 @@ void MainFrame::OnCopy(wxCommandEvent& event){
 	}
 	//copy values to the clipboard
 	if(wxTheClipboard->Open()){
-		 wxTheClipboard->SetData( new wxTextDataObject(data->Path) );
+		 wxTheClipboard->SetData( new wxTextDataObject(tree->pathOf(data)) );
 		wxTheClipboard->Flush();
 		wxTheClipboard->Close();
 	}
@@ -267,7 +1022,7 @@ void MainFrame::OnReloadFolder(wxCommandEvent& event){
 	
 	FolderDisplay* toReload = nullptr;
 	for(FolderDisplay* disp : currentDisplay){
-		if (disp->data->Path == selected->Path){
+		if (disp->data == selected){
 			toReload = disp;
 			break;
 		}
@@ -279,13 +1034,17 @@ void MainFrame::OnReloadFolder(wxCommandEvent& event){
 		toReload->data = selected;
 	}
 	
-	auto reloadcallback = [&](float prog, DirectoryData* data){
+	auto reloadcallback = [this](const progressSnapshot& progress, DirectoryData* data){
 		//on completion, signal all folder displays higher in the hierarchy to re-calculate
 		//percentages. Showing files that aren't there / not showing files is ok.
+		if (progress.done){
+			treemap->SetTree(tree);
+		}
 	};
+	treemap->SetTree(nullptr);
 	
 	//signal it to size again
-	toReload->Size(reloadcallback);
+	toReload->Size(reloadcallback, limits);
 	
 }
 /** Brings up a folder selection dialog with a prompt
@@ -323,7 +1082,12 @@ void MainFrame::OnOpenFolder(wxCommandEvent& event){
 void MainFrame::OnExit(wxCommandEvent& event)
 {
 	//deallocate structure
-	delete folderData;
+	StopSizing();
+	StopWatching();
+	sidebarRefresher.reset();
+	treemap->SetTree(nullptr);
+	delete tree;
+	tree = nullptr;
 	Close( true );
 }
 /**
@@ -382,11 +1146,22 @@ void MainFrame::OnToggleLog(wxCommandEvent& event) {
 	}
 }
 
+/**
+Toggle the treemap below the folder displays
+Called when the menu is activated
+@param event the event from the caller (unused)
+*/
+void MainFrame::OnToggleTreemap(wxCommandEvent& event) {
+	treemap->Show(!treemap->IsShown());
+	scrollView->GetParent()->Layout();
+	menuToggleTreemap->SetItemLabel(treemap->IsShown() ? "Hide Treemap\tCtrl-M" : "Show Treemap\tCtrl-M");
+}
+
 void MainFrame::ChangeSelection(DirectoryData* sender){
 	//find where the sender is in the list
 	int idx;
 	for (idx = 0; idx < currentDisplay.size(); idx++){
-		if (currentDisplay[idx]->data == sender->parent){
+		if (currentDisplay[idx]->data == tree->parentOf(sender)){
 			break;
 		}
 	}
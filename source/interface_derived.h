@@ -12,6 +12,11 @@
 #include "interface.h"
 #include "folder_sizer.hpp"
 #include "FolderDisplay.hpp"
+#include "TreemapPanel.hpp"
+#include "tree_watcher.hpp"
+#include "duplicate_finder.hpp"
+#include "stat_refresher.hpp"
+#include <memory>
 #include <thread>
 #include <unordered_set>
 #include <wx/treebase.h>
@@ -21,6 +26,54 @@ using namespace std;
 
 class StructurePtrData;
 
+/**
+ Lists the largest files and folders found while sizing
+ */
+class LargestItems : public LargestItemsBase{
+public:
+	LargestItems(wxWindow*, const largestItems&);
+};
+
+/**
+ Shows how much space each category and extension of file takes
+ */
+class FileTypes : public FileTypesBase{
+public:
+	FileTypes(wxWindow*, const typeHistogram&, const string&);
+};
+
+/**
+ Shows how much space each user and group owns
+ */
+class Owners : public OwnersBase{
+public:
+	Owners(wxWindow*, const ownerHistogram&, const string&);
+};
+
+/**
+ Lists groups of files with the same contents
+ */
+class Duplicates : public DuplicatesBase{
+public:
+	Duplicates(wxWindow*, const vector<duplicateGroup>&, const string&, bool);
+};
+
+/**
+ Shows how long ago the files below a folder were last used, and the folders holding the most bytes not used in over a year
+ */
+class Ages : public AgesBase{
+public:
+	Ages(wxWindow*, DirectoryTree*, nodeIndex);
+
+private:
+	DirectoryTree* tree;
+	nodeIndex folder;
+
+	void Fill();
+	void OnBasis(wxCommandEvent&);
+	wxDECLARE_EVENT_TABLE();
+};
+
 /**
  Defines the main window and all of its behaviors and members.
  */
@@ -43,11 +96,13 @@ public:
 		Log(evt.GetString());
 	}
 	void PopulateSidebar(DirectoryData*);
+	void ShowSidebar(DirectoryData*, const itemDetails&);
+	void OnSidebarRefresh(wxCommandEvent&);
 	
 	void ChangeSelection(DirectoryData*);
 	
 	FolderDisplay* AddDisplay(DirectoryData* model){
-		FolderDisplay* f = new FolderDisplay(scrollView,this,model);
+		FolderDisplay* f = new FolderDisplay(scrollView,this,tree,model);
 		int count = (int)scrollSizer->GetItemCount();
 		scrollSizer->SetCols(++count);
 		scrollSizer->Add(f, wxGBPosition( 0, count-1), wxGBSpan( 1, 1 ), wxALL|wxEXPAND, 0);
@@ -71,6 +126,7 @@ public:
 	DirectoryData* selected = nullptr;
 	
 private:
+	DirectoryTree* tree = nullptr;
 	DirectoryData* folderData = nullptr;
 	unordered_set<string> loaded;
 	int progIndex = 0;
@@ -79,18 +135,61 @@ private:
 
 	string GetPathFromDialog(const string&);
 	void SizeRootFolder(const string&);
+	DirectoryData* SelectedFolder() const;
 	
 	vector<FolderDisplay*> currentDisplay;
+	//shown below the displays, hidden until toggled in the menu
+	TreemapPanel* treemap = nullptr;
+	//reads the item shown in the sidebar again, after it is shown from what the tree stores
+	unique_ptr<statRefresher> sidebarRefresher;
+	//the item in the sidebar, the details it shows, and the refresh that may replace them
+	DirectoryData* sidebarItem = nullptr;
+	itemDetails sidebarDetails;
+	uint64_t sidebarRequest = 0;
+	
+#if defined __linux__
+	unique_ptr<treeWatcher> watcher;
+#endif
+	wxTimer watchTimer;
+	//how sizes are shown, kept when another folder is sized or opened
+	DirectoryTree::sizeMode sizeMode = DirectoryTree::sizeMode::apparent;
+	//which folders sizing enters, chosen in the file menu
+	scanLimits limits;
+	//the text the name patterns in the limits were read from
+	string skipPatterns;
+	//how often to apply the changes the watcher found, in milliseconds
+	static constexpr int watchInterval = 500;
 	
 	void OnExit(wxCommandEvent&);
 	void OnAbout(wxCommandEvent&);
 	void OnOpenFolder(wxCommandEvent&);
 	void OnReloadFolder(wxCommandEvent&);
-	void OnUpdateUI(wxCommandEvent&);
+	void UpdateProgress(const progressSnapshot&, DirectoryData*);
 	void OnUpdateReload(wxCommandEvent&);
 	void OnCopy(wxCommandEvent&);
+	void OnOpenScan(wxCommandEvent&);
+	void OnSaveScan(wxCommandEvent&);
+	void OnRescan(wxCommandEvent&);
+	void OnWatch(wxCommandEvent&);
+	void OnWatchTimer(wxTimerEvent&);
+	void StopWatching();
+	void OnSizeMode(wxCommandEvent&);
+	void OnLimits(wxCommandEvent&);
+	void OnSkipNames(wxCommandEvent&);
+	void OnRateLimit(wxCommandEvent&);
+	void OnLargestItems(wxCommandEvent&);
+	void OnFileTypes(wxCommandEvent&);
+	void OnFindDuplicates(wxCommandEvent&);
+	void OnAges(wxCommandEvent&);
+	void OnOwners(wxCommandEvent&);
+	void CloseSubDisplays();
+	bool IsSizing();
+	void StopSizing();
+	void OnAbort(wxCommandEvent&);
+	void OnPause(wxCommandEvent&);
 	void OnToggleSidebar(wxCommandEvent&);
 	void OnToggleLog(wxCommandEvent&);
+	void OnToggleTreemap(wxCommandEvent&);
 	void OnReveal(wxCommandEvent&);
 
 
@@ -100,12 +199,6 @@ private:
 	void OnUpdates(wxCommandEvent& event){
 		wxLaunchDefaultBrowser("https://github.com/ravbug/FatFileFinderCPP/releases/latest");
 	}
-	void OnAbort(wxCommandEvent& event) {
-		//TODO: find any items with size operaions in progress, and signal them to stop
-				//if any were found, then display the below message
-		
-//			wxMessageBox("File percentage calculations will be incorrect.\nReload an individual item to size it, or Open this folder and resize it to calculate all items.","Stopped Sizing");
-	}
 	void OnClearLog(wxCommandEvent& event) {
 		logCtrl->SetValue("");
 	}
@@ -118,7 +211,7 @@ private:
 		}
 	}
 	void UpdateTitlebar(int prog, const string& size) {
-		SetTitle(AppName + " v" + AppVersion + " - Sizing " + to_string(prog) + "% " + folderData->Path + " [" + size + "]");
+		SetTitle(AppName + " v" + AppVersion + " - Sizing " + to_string(prog) + "% " + tree->pathOf(tree->root()) + " [" + size + "]");
 	}
 	wxDECLARE_EVENT_TABLE();
 	
@@ -0,0 +1,136 @@
+//
+//  largest_items.hpp
+//  mac
+//
+//  Copyright © 2020 Ravbug. All rights reserved.
+//
+
+#pragma once
+#include "DirectoryData.hpp"
+#include <algorithm>
+#include <string>
+#include <vector>
+
+/**
+ The largest files and folders found while sizing. Each worker offers items to its own bounded min-heaps,
+ so offering never takes a lock, and most items are turned away by one comparison with the smallest item kept.
+ The heaps are merged once sizing finishes, and the paths of the winners are looked up then.
+ */
+class largestItems{
+public:
+	/**
+	 One of the largest items, as it was when sizing finished
+	 */
+	struct ranked{
+		std::string path;
+		fileSize size;
+		//valid until the tree is changed
+		nodeIndex index;
+	};
+
+	/**
+	 Clear the heaps before sizing
+	 @param workers the number of workers that will offer items
+	 @param keep how many files, and how many folders, to keep. If 0, offers are ignored.
+	 */
+	void reset(unsigned int workers, size_t keep){
+		count = keep;
+		heaps.clear();
+		heaps.resize(workers);
+		topFiles.clear();
+		topFolders.clear();
+	}
+
+	/**
+	 @return true if items are being kept
+	 */
+	bool enabled() const{
+		return count > 0;
+	}
+
+	/**
+	 Offer an item. Called only by the worker that owns the heaps.
+	 @param worker the index of the calling worker
+	 @param isFolder true if the item is a folder
+	 @param size the item's size
+	 @param index the item's index in the tree
+	 */
+	void offer(unsigned int worker, bool isFolder, fileSize size, nodeIndex index){
+		std::vector<entry>& heap = isFolder ? heaps[worker].folders : heaps[worker].files;
+		if (heap.size() < count){
+			heap.push_back({size, index});
+			std::push_heap(heap.begin(), heap.end(), greater);
+		}
+		else if (count > 0 && size > heap.front().size){
+			std::pop_heap(heap.begin(), heap.end(), greater);
+			heap.back() = {size, index};
+			std::push_heap(heap.begin(), heap.end(), greater);
+		}
+	}
+
+	/**
+	 Combine the workers' heaps into the lists of the largest items
+	 @param tree the tree that was sized, to look up the paths of the items kept
+	 */
+	void merge(const DirectoryTree& tree){
+		collect(tree, false, topFiles);
+		collect(tree, true, topFolders);
+		heaps.clear();
+	}
+
+	/**
+	 @return the largest files, largest first
+	 */
+	const std::vector<ranked>& files() const{
+		return topFiles;
+	}
+	/**
+	 @return the largest folders below the folder that was sized, largest first
+	 */
+	const std::vector<ranked>& folders() const{
+		return topFolders;
+	}
+
+private:
+	struct entry{
+		fileSize size;
+		nodeIndex index;
+	};
+	//each worker's heaps on their own cache lines, so workers do not slow each other down
+	struct alignas(64) workerHeaps{
+		std::vector<entry> files;
+		std::vector<entry> folders;
+	};
+
+	size_t count = 0;
+	std::vector<workerHeaps> heaps;
+	std::vector<ranked> topFiles;
+	std::vector<ranked> topFolders;
+
+	/**
+	 Orders the heaps with the smallest item on top. Equal sizes are ordered by index, so the result does not depend on which worker found an item.
+	 */
+	static bool greater(const entry& a, const entry& b){
+		return a.size != b.size ? a.size > b.size : a.index < b.index;
+	}
+
+	/**
+	 Merge one kind of heap from every worker
+	 @param tree the tree that was sized
+	 @param isFolder true to merge the folder heaps
+	 @param out receives the largest items, largest first
+	 */
+	void collect(const DirectoryTree& tree, bool isFolder, std::vector<ranked>& out){
+		std::vector<entry> all;
+		for (const workerHeaps& h : heaps){
+			const std::vector<entry>& heap = isFolder ? h.folders : h.files;
+			all.insert(all.end(), heap.begin(), heap.end());
+		}
+		size_t kept = std::min(count, all.size());
+		std::partial_sort(all.begin(), all.begin() + kept, all.end(), greater);
+		out.clear();
+		for (size_t i = 0; i < kept; i++){
+			out.push_back({tree.pathOf(tree.at(all[i].index)), all[i].size, all[i].index});
+		}
+	}
+};
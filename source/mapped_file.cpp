@@ -0,0 +1,95 @@
+//
+//  mapped_file.cpp
+//  mac
+//
+//  Copyright © 2020 Ravbug. All rights reserved.
+//
+
+#include "mapped_file.hpp"
+#include <system_error>
+#include <cerrno>
+#if defined _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+using namespace std;
+
+/**
+ Map a file into memory
+ @param path the path to the file
+ @throws system_error if the file cannot be opened or mapped
+ */
+mappedFile::mappedFile(const string& path){
+#if defined _WIN32
+	file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE){
+		file = nullptr;
+		throw system_error(GetLastError(), system_category(), "Cannot open " + path);
+	}
+	LARGE_INTEGER fileLength;
+	GetFileSizeEx(file, &fileLength);
+	length = fileLength.QuadPart;
+	if (length == 0){
+		return;
+	}
+	mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+	if (mapping == nullptr){
+		DWORD err = GetLastError();
+		CloseHandle(file);
+		throw system_error(err, system_category(), "Cannot map " + path);
+	}
+	base = (char*)MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+	if (base == nullptr){
+		DWORD err = GetLastError();
+		CloseHandle(mapping);
+		CloseHandle(file);
+		throw system_error(err, system_category(), "Cannot map " + path);
+	}
+#else
+	int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0){
+		throw system_error(errno, system_category(), "Cannot open " + path);
+	}
+	struct stat info;
+	if (fstat(fd, &info) != 0){
+		int err = errno;
+		close(fd);
+		throw system_error(err, system_category(), "Cannot open " + path);
+	}
+	length = info.st_size;
+	if (length == 0){
+		close(fd);
+		return;
+	}
+	void* mapped = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	int err = errno;
+	//the mapping keeps its own reference to the file
+	close(fd);
+	if (mapped == MAP_FAILED){
+		throw system_error(err, system_category(), "Cannot map " + path);
+	}
+	base = (char*)mapped;
+#endif
+}
+
+mappedFile::~mappedFile(){
+#if defined _WIN32
+	if (base != nullptr){
+		UnmapViewOfFile(base);
+	}
+	if (mapping != nullptr){
+		CloseHandle(mapping);
+	}
+	if (file != nullptr){
+		CloseHandle(file);
+	}
+#else
+	if (base != nullptr){
+		munmap(base, length);
+	}
+#endif
+}
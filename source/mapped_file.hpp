@@ -0,0 +1,43 @@
+//
+//  mapped_file.hpp
+//  mac
+//
+//  Copyright © 2020 Ravbug. All rights reserved.
+//
+
+#pragma once
+#include <string>
+#include <stdint.h>
+
+/**
+ A read-only file mapped into memory with private, copy-on-write pages.
+ The pages can be modified in memory, but the changes are never written back to the file.
+ */
+class mappedFile{
+public:
+	mappedFile(const std::string&);
+	~mappedFile();
+	mappedFile(const mappedFile&) = delete;
+	mappedFile& operator=(const mappedFile&) = delete;
+
+	/**
+	 @return the start of the mapping
+	 */
+	char* data() const{
+		return base;
+	}
+	/**
+	 @return the size of the file in bytes
+	 */
+	uint64_t size() const{
+		return length;
+	}
+
+private:
+	char* base = nullptr;
+	uint64_t length = 0;
+#if defined _WIN32
+	void* file = nullptr;
+	void* mapping = nullptr;
+#endif
+};
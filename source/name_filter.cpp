@@ -0,0 +1,169 @@
+//
+//  name_filter.cpp
+//  mac
+//
+//  Copyright © 2020 Ravbug. All rights reserved.
+//
+
+#include "name_filter.hpp"
+#include <algorithm>
+#include <stdexcept>
+using namespace std;
+
+/**
+ Match one pattern element other than *
+ @param pattern the pattern
+ @param p the position of the element
+ @param c the character to match
+ @param next set to the position after the element
+ @return true if the character matches
+ */
+static bool matchOne(string_view pattern, size_t p, char c, size_t& next){
+	switch (pattern[p]){
+		case '?':
+			next = p + 1;
+			return true;
+		case '\\':
+			if (p + 1 < pattern.size()){
+				next = p + 2;
+				return pattern[p + 1] == c;
+			}
+			break;
+		case '[':{
+			size_t q = p + 1;
+			bool negate = q < pattern.size() && (pattern[q] == '!' || pattern[q] == '^');
+			if (negate){
+				q++;
+			}
+			bool found = false;
+			//a ] right after the opening bracket is part of the set
+			for (size_t first = q; q < pattern.size() && (pattern[q] != ']' || q == first); q++){
+				unsigned char low = pattern[q];
+				unsigned char high = low;
+				if (q + 2 < pattern.size() && pattern[q + 1] == '-' && pattern[q + 2] != ']'){
+					high = pattern[q + 2];
+					q += 2;
+				}
+				found |= (unsigned char)c >= low && (unsigned char)c <= high;
+			}
+			//without a closing bracket, the [ is literal
+			if (q < pattern.size()){
+				next = q + 1;
+				return found != negate;
+			}
+			break;
+		}
+	}
+	next = p + 1;
+	return pattern[p] == c;
+}
+
+/**
+ Match a name against a glob, backtracking to the most recent * on a mismatch
+ @param pattern the glob
+ @param name the name to match
+ @return true if the whole name matches
+ */
+static bool globMatch(string_view pattern, string_view name){
+	size_t p = 0, n = 0;
+	size_t starP = string_view::npos, starN = 0;
+	while (n < name.size()){
+		if (p < pattern.size()){
+			if (pattern[p] == '*'){
+				starP = ++p;
+				starN = n;
+				continue;
+			}
+			size_t next;
+			if (matchOne(pattern, p, name[n], next)){
+				p = next;
+				n++;
+				continue;
+			}
+		}
+		//let the last * take one more character
+		if (starP == string_view::npos){
+			return false;
+		}
+		p = starP;
+		n = ++starN;
+	}
+	while (p < pattern.size() && pattern[p] == '*'){
+		p++;
+	}
+	return p == pattern.size();
+}
+
+/**
+ Skip entries whose names match a pattern
+ @param pattern a glob, matched against names without their folder
+ @throws invalid_argument if the pattern is empty or contains a path separator
+ */
+void nameFilter::exclude(const string& pattern){
+	excluded.add(pattern);
+}
+
+/**
+ Keep only the files whose names match one of the include patterns. Folders are not affected.
+ @param pattern a glob, matched against names without their folder
+ @throws invalid_argument if the pattern is empty or contains a path separator
+ */
+void nameFilter::include(const string& pattern){
+	included.add(pattern);
+}
+
+/**
+ Add a pattern to the group for its shape
+ @param pattern the pattern to add
+ @throws invalid_argument if the pattern is empty or contains a path separator
+ */
+void nameFilter::patternSet::add(const string& pattern){
+	if (pattern.empty() || pattern.find('/') != string::npos){
+		throw invalid_argument("\"" + pattern + "\" is not a name pattern");
+	}
+	size_t special = pattern.find_first_of("*?[\\");
+	auto insertSorted = [](vector<string>& list, const string& item){
+		list.insert(upper_bound(list.begin(), list.end(), item), item);
+	};
+	if (special == string::npos){
+		insertSorted(names, pattern);
+	}
+	else if (special == pattern.size() - 1 && pattern.back() == '*'){
+		prefixes.push_back(pattern.substr(0, special));
+	}
+	else if (special == 0 && pattern[0] == '*' && pattern.find_first_of("*?[\\", 1) == string::npos){
+		suffixes.push_back(pattern.substr(1));
+	}
+	else{
+		globs.push_back(pattern);
+	}
+}
+
+/**
+ @param name the name to check
+ @return true if any pattern in the set matches the name
+ */
+bool nameFilter::patternSet::matches(string_view name) const{
+	auto found = lower_bound(names.begin(), names.end(), name, [](const string& a, string_view b){
+		return string_view(a) < b;
+	});
+	if (found != names.end() && *found == name){
+		return true;
+	}
+	for (const string& prefix : prefixes){
+		if (name.size() >= prefix.size() && name.compare(0, prefix.size(), prefix) == 0){
+			return true;
+		}
+	}
+	for (const string& suffix : suffixes){
+		if (name.size() >= suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0){
+			return true;
+		}
+	}
+	for (const string& glob : globs){
+		if (globMatch(glob, name)){
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,68 @@
+//
+//  name_filter.hpp
+//  mac
+//
+//  Copyright © 2020 Ravbug. All rights reserved.
+//
+
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ Decides which entries to skip from their names alone, so that a skipped entry is never stat'ed
+ and a skipped folder is never read. Patterns are globs matched against a single name:
+ * matches any run of characters, ? matches one character, [abc], [a-z] and [!abc] match a set,
+ and \ makes the next character literal.
+ Patterns are sorted by shape when added. Names, prefixes such as cache*, and suffixes such as *.o
+ are checked without running the general glob matcher.
+ */
+class nameFilter{
+public:
+	void exclude(const std::string&);
+	void include(const std::string&);
+
+	/**
+	 @return true if the filter has no patterns, and every entry is kept
+	 */
+	bool empty() const{
+		return excluded.empty() && included.empty();
+	}
+	/**
+	 @param name the name of a file or folder
+	 @return true if the entry should be skipped
+	 */
+	bool excludes(std::string_view name) const{
+		return excluded.matches(name);
+	}
+	/**
+	 @param name the name of a file
+	 @return true if the file should be kept. Files are kept if there are no include patterns.
+	 @note include patterns do not apply to folders, so that the files inside them can still be found
+	 */
+	bool includesFile(std::string_view name) const{
+		return included.empty() || included.matches(name);
+	}
+
+private:
+	/**
+	 A set of patterns, grouped by shape
+	 */
+	struct patternSet{
+		//exact names, sorted for binary search
+		std::vector<std::string> names;
+		//the rest are checked in turn, in the order they were added
+		std::vector<std::string> prefixes;
+		std::vector<std::string> suffixes;
+		std::vector<std::string> globs;
+
+		void add(const std::string&);
+		bool matches(std::string_view) const;
+		bool empty() const{
+			return names.empty() && prefixes.empty() && suffixes.empty() && globs.empty();
+		}
+	};
+	patternSet excluded;
+	patternSet included;
+};
@@ -0,0 +1,187 @@
+//
+//  name_pool.cpp
+//  mac
+//
+//  Copyright © 2020 Ravbug. All rights reserved.
+//
+
+#include "name_pool.hpp"
+#include <cstring>
+#include <algorithm>
+using namespace std;
+
+//marks an unused slot. Id 0 is the empty name, which is added by the constructor and never looked up.
+static constexpr nameId emptySlot = 0;
+
+namePool::namePool(){
+	storage.reserve(0, 1 << alignBits);
+	storageEnd = 1 << alignBits;
+	slots.resize(1024, emptySlot);
+	hashes.resize(slots.size());
+}
+
+/**
+ FNV-1a hash of a name
+ @param name the name to hash
+ @param length the length of the name
+ @return the hash
+ */
+uint32_t namePool::hash(const char* name, uint32_t length){
+	uint32_t h = 2166136261u;
+	for (uint32_t i = 0; i < length; i++){
+		h = (h ^ (unsigned char)name[i]) * 16777619u;
+	}
+	return h;
+}
+
+/**
+ Find a name, adding it if it is not in the pool
+ @param name the name to find
+ @param length the length of the name
+ @param h the hash of the name
+ @return the id of the name
+ @pre lock must be held
+ */
+nameId namePool::find(const char* name, uint32_t length, uint32_t h){
+	size_t mask = slots.size() - 1;
+	size_t i = h & mask;
+	while (slots[i] != emptySlot){
+		if (hashes[i] == h){
+			const char* existing = at(slots[i]);
+			if (memcmp(existing, name, length) == 0 && existing[length] == '\0'){
+				return slots[i];
+			}
+		}
+		i = (i + 1) & mask;
+	}
+
+	//not found, copy it in. Names never straddle chunks.
+	uint64_t needed = length + 1;
+	uint64_t offset = storageEnd;
+	if ((offset & (storage.chunkSize - 1)) + needed > storage.chunkSize){
+		offset = (offset | (storage.chunkSize - 1)) + 1;
+	}
+	if ((offset + needed) >> alignBits > UINT32_MAX){
+		throw bad_alloc();
+	}
+	storage.reserve(offset, needed);
+	char* copy = storage.at(offset);
+	memcpy(copy, name, length);
+	copy[length] = '\0';
+	//keep the next name aligned
+	storageEnd = (offset + needed + (1 << alignBits) - 1) & ~uint64_t((1 << alignBits) - 1);
+
+	nameId id = (nameId)(offset >> alignBits);
+	slots[i] = id;
+	hashes[i] = h;
+	if (++count * 2 > slots.size()){
+		grow();
+	}
+	return id;
+}
+
+/**
+ Double the size of the hash table
+ @pre lock must be held
+ */
+void namePool::grow(){
+	vector<nameId> oldSlots(slots.size() * 2, emptySlot);
+	vector<uint32_t> oldHashes(oldSlots.size());
+	//the larger tables become current, and the old ones are reinserted into them
+	oldSlots.swap(slots);
+	oldHashes.swap(hashes);
+	size_t mask = slots.size() - 1;
+	for (size_t j = 0; j < oldSlots.size(); j++){
+		if (oldSlots[j] == emptySlot){
+			continue;
+		}
+		size_t i = oldHashes[j] & mask;
+		while (slots[i] != emptySlot){
+			i = (i + 1) & mask;
+		}
+		slots[i] = oldSlots[j];
+		hashes[i] = oldHashes[j];
+	}
+}
+
+/**
+ Add a batch of names, taking the lock once. Safe to call from multiple threads.
+ @param requests the names to add. Each request's id is populated.
+ */
+void namePool::intern(vector<request>& requests){
+	//hash outside the lock
+	thread_local vector<uint32_t> hashed;
+	hashed.resize(requests.size());
+	for (size_t i = 0; i < requests.size(); i++){
+		hashed[i] = hash(requests[i].name, requests[i].length);
+	}
+	lock_guard<mutex> guard(lock);
+	if (!indexed){
+		index();
+	}
+	for (size_t i = 0; i < requests.size(); i++){
+		requests[i].id = find(requests[i].name, requests[i].length, hashed[i]);
+	}
+}
+
+/**
+ Add a single name. Safe to call from multiple threads.
+ @param name the name to add
+ @return the id of the name
+ */
+nameId namePool::intern(const string& name){
+	uint32_t length = (uint32_t)name.size();
+	uint32_t h = hash(name.c_str(), length);
+	lock_guard<mutex> guard(lock);
+	if (!indexed){
+		index();
+	}
+	return find(name.c_str(), length, h);
+}
+
+/**
+ Use the storage image of another pool, such as one saved in a snapshot, as the contents of this pool.
+ The names keep their ids. The hash table is rebuilt only when a name is next added.
+ @param image the storage image, as read chunk by chunk through bytesAt. Must outlive the pool.
+ @param length the size of the image in bytes
+ @note call at most once, before any names are added
+ */
+void namePool::adopt(char* image, uint64_t length){
+	lock_guard<mutex> guard(lock);
+	storage.adopt(image, length);
+	storageEnd = (length + (1 << alignBits) - 1) & ~uint64_t((1 << alignBits) - 1);
+	fill(slots.begin(), slots.end(), emptySlot);
+	count = 0;
+	indexed = false;
+}
+
+/**
+ Rebuild the hash table from the storage, after adopt
+ @pre lock must be held
+ */
+void namePool::index(){
+	indexed = true;
+	uint64_t offset = 1 << alignBits;
+	while (offset < storageEnd){
+		//names never straddle chunks, so the remainder of a chunk may be unused padding
+		const char* name = storage.at(offset);
+		uint64_t chunkLeft = storage.chunkSize - (offset & (storage.chunkSize - 1));
+		uint32_t length = (uint32_t)strnlen(name, chunkLeft);
+		if (length == 0){
+			offset = (offset | (storage.chunkSize - 1)) + 1;
+			continue;
+		}
+		uint32_t h = hash(name, length);
+		size_t mask = slots.size() - 1;
+		size_t i = h & mask;
+		while (slots[i] != emptySlot){
+			i = (i + 1) & mask;
+		}
+		slots[i] = (nameId)(offset >> alignBits);
+		hashes[i] = h;
+		if (++count * 2 > slots.size()){
+			grow();
+		}
+		offset = (offset + length + 1 + (1 << alignBits) - 1) & ~uint64_t((1 << alignBits) - 1);
+	}
+}
@@ -0,0 +1,90 @@
+//
+//  name_pool.hpp
+//  mac
+//
+//  Copyright © 2020 Ravbug. All rights reserved.
+//
+
+#pragma once
+#include "arena.hpp"
+#include <mutex>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+//position of a name in a namePool
+typedef uint32_t nameId;
+
+/**
+ Stores each distinct name once. Names that repeat across folders (index.js, Makefile, .git, ...)
+ share one copy. Adding names takes a lock, reading them does not.
+ */
+class namePool{
+public:
+	/**
+	 A name to add with intern
+	 */
+	struct request{
+		const char* name;
+		uint32_t length;
+		//populated by intern
+		nameId id;
+	};
+
+	namePool();
+
+	/**
+	 @param id the id of a name in this pool
+	 @return the null-terminated name
+	 */
+	const char* at(nameId id) const{
+		return storage.at(offsetOf(id));
+	}
+	/**
+	 @param id the id of a name
+	 @return the byte offset of the name in the pool's storage
+	 */
+	static uint64_t offsetOf(nameId id){
+		return uint64_t(id) << alignBits;
+	}
+
+	void intern(std::vector<request>&);
+	nameId intern(const std::string&);
+
+	/**
+	 @return the size of the pool's storage in bytes, including padding
+	 */
+	uint64_t bytes() const{
+		return storageEnd;
+	}
+	/**
+	 @param offset a byte offset in the storage, less than bytes()
+	 @return the storage from that offset to the end of its chunk, at most chunkBytes long
+	 */
+	const char* bytesAt(uint64_t offset) const{
+		return storage.at(offset);
+	}
+	static constexpr uint64_t chunkBytes = chunkArena<char, 22>::chunkSize;
+
+	void adopt(char*, uint64_t);
+
+private:
+	//names start on 4-byte boundaries, so a 32-bit id can address 16 GiB of names
+	static constexpr unsigned int alignBits = 2;
+
+	chunkArena<char, 22> storage;
+	uint64_t storageEnd = 0;
+
+	//open-addressed hash table of ids, with the hash of each name to skip most comparisons
+	std::vector<nameId> slots;
+	std::vector<uint32_t> hashes;
+	size_t count = 0;
+	//false after adopt, until the table is rebuilt by the next intern
+	bool indexed = true;
+	std::mutex lock;
+
+	static uint32_t hash(const char*, uint32_t);
+	nameId find(const char*, uint32_t, uint32_t);
+	void grow();
+	void index();
+};
@@ -0,0 +1,490 @@
+//
+//  platform.h
+//
+//	Place functions without classes that do not need wxWidgets in this file,
+//	so that they can be shared with builds that do not link it.
+//	globals.h includes this file.
+//
+//  Copyright © 2019 Ravbug. All rights reserved.
+//
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <ctime>
+#include <cmath>
+#include <cstdio>
+#include <array>
+#include <filesystem>
+#include <sys/stat.h>
+#pragma mark Shared functions
+static inline const std::string AppName = "FatFileFinder";
+static inline const std::string AppVersion = "2.0-alpha";
+typedef int64_t fileSize;
+
+/**
+ Calls stat on a path
+ @param path the path to get stat for
+ @return a stat struct representing the path
+ @note On Windows this function invokes stat, on other platforms it uses lstat
+ */
+inline struct stat get_stat(const std::string& path){
+	struct stat buf;
+#if defined _WIN32
+	stat(path.c_str(), &buf);
+#else
+	lstat(path.c_str(), &buf);
+#endif
+	return buf;
+}
+
+/**
+ @param path the path to the file
+ @return a time_t representing the modification date of the path
+ */
+static inline time_t file_modify_time(const std::string& path) {
+	return get_stat(path).st_mtime;
+}
+
+/**
+@param path the path to the file
+@return a time_t representing the creation time of the path
+*/
+static inline time_t file_create_time(const std::string& path) {
+	return get_stat(path).st_ctime;
+}
+
+/**
+@param path the path to the file
+@return a time_t representing the last access time of the path
+*/
+static inline time_t file_access_time(const std::string& path) {
+	return get_stat(path).st_atime;
+}
+
+/**
+@param path the path to the file
+@return a 64-bit int representing the size of the file as provided by stat
+*/
+static inline fileSize stat_file_size(const std::string& path) {
+	return get_stat(path).st_size;
+}
+
+/**
+ Determines if an item is accessible using std::filesystem
+ @param s the file_status object
+ @return true if accessible, false otherwise
+*/
+static inline bool can_access(const std::filesystem::file_status& s) {
+	return (s.permissions() & std::filesystem::perms::others_read) != std::filesystem::perms::none || (s.permissions() & std::filesystem::perms::owner_read) != std::filesystem::perms::none;
+}
+
+/**
+ Converts a time_t to a formatted date string
+ @param inTime the time_t to convert
+ @return formatted date string
+ */
+static inline std::string timeToString(const time_t& inTime) {
+	tm* time;
+	time_t tm = inTime;
+	time = localtime(&tm);
+	if (time != nullptr) {
+		char dateString[100];
+		strftime(dateString, 50, "%x %X", time);
+		return dateString;
+	}
+	return "Unavailable";
+}
+
+
+/**
+ Formats a raw file size to a string with a unit
+ @param fileSize the size of the item in bytes
+ @returns unitized string, example "12 KB"
+ */
+static inline std::string sizeToString(const fileSize& fileSize){
+	std::string formatted = "";
+	int size = 1000;		//MB = 1000, MiB = 1024
+	std::array<std::string,5> suffix { " bytes", " KB", " MB", " GB", " TB" };
+
+	for (int i = 0; i < suffix.size(); i++)
+	{
+		double compare = pow(size, i);
+		if (fileSize <= compare)
+		{
+			int minus = 0;
+			if (i > 0)
+			{
+				minus = 1;
+			}
+			//round to 2 decimal places, then attach unit
+			char buffer[10];
+			sprintf(buffer,"%.2f",fileSize / pow(size,i-minus));
+			formatted = std::string(buffer) + suffix[i - minus];
+			break;
+		}
+	}
+
+	return formatted;
+}
+
+#pragma mark Windows functions
+#if defined _WIN32
+//place windows-specific globals here
+
+//windows.h must be the first include, and must be placed before using namespace std.
+//if they are not in this order, the compiler will not be able to resolve byte
+//ensure globals.h is the first include in every file
+#include <windows.h>
+#include <winnt.h>
+#include <array>
+
+/**
+ Determines if a path is too long. On Windows using Win32 APIs, the maxiumum length of the entire path is 260 bytes, but to be safe this program reduces it to 247.
+ @param inPath the path to the file
+ @return true if path is too long, false otherwise
+ */
+static inline bool path_too_long(const std::string& inPath){
+	return inPath.size() > 247;
+}
+
+/**
+ Determines if with current permissions an item can be written to (Windows only)
+ @param mode the st_mode of the item
+ @return true if the item is writable
+ */
+static inline bool is_writable(uint32_t mode) {
+	return mode & _S_IWRITE;
+}
+
+/**
+ Determines if with current permissions the target path can be written to (Windows only)
+ @param inPath the path to the file
+ @return true if the path is writable
+ */
+static inline bool is_writable(const std::string& inPath) {
+	return is_writable((uint32_t)get_stat(inPath).st_mode);
+}
+
+/**
+Determines if with current permissions an item can be executed (Windows only)
+@param mode the st_mode of the item
+@return true if the item is executable
+*/
+static inline bool is_executable(uint32_t mode) {
+	return mode & _S_IEXEC && mode & _S_IFDIR;
+}
+
+/**
+Determines if with current permissions the target path can be executed (Windows only)
+@param inPath the path to the file
+@return true if the path is executable
+*/
+static inline bool is_executable(const std::string& inPath) {
+	return is_executable((uint32_t)get_stat(inPath).st_mode);
+}
+
+/**
+@param inPath the path to the file
+@return true if the file is hidden (according to GetFileAttributesA)
+ */
+static inline bool is_hidden(const std::string& inPath) {
+	DWORD attributes = GetFileAttributesA(inPath.c_str());
+	return attributes & FILE_ATTRIBUTE_HIDDEN;
+}
+
+
+/**
+Get the attributes for a file (Windows)
+@param path the path to the file
+@return a boolean array representing the different file properties
+*/
+static inline std::array<bool, 13> file_attributes_for(const std::string& path) {
+	DWORD attributes = GetFileAttributesA(path.c_str());
+	int attr_const[] = {FILE_ATTRIBUTE_ARCHIVE, FILE_ATTRIBUTE_COMPRESSED, FILE_ATTRIBUTE_ENCRYPTED, FILE_ATTRIBUTE_INTEGRITY_STREAM, FILE_ATTRIBUTE_NOT_CONTENT_INDEXED, FILE_ATTRIBUTE_NO_SCRUB_DATA, FILE_ATTRIBUTE_OFFLINE, FILE_ATTRIBUTE_RECALL_ON_DATA_ACCESS, FILE_ATTRIBUTE_RECALL_ON_OPEN, FILE_ATTRIBUTE_REPARSE_POINT, FILE_ATTRIBUTE_SPARSE_FILE, FILE_ATTRIBUTE_SYSTEM, FILE_ATTRIBUTE_TEMPORARY, FILE_ATTRIBUTE_VIRTUAL};
+
+	std::array<bool, 13> attr;
+
+	for (int i = 0; i < attr.size(); i++) {
+		attr[i] = attributes & attr_const[i];
+	}
+
+	return attr;
+}
+
+/**
+ @param info the result of stat'ing a file
+ @return the number of bytes the file takes on disk. stat does not report blocks on Windows, so this is the file's size.
+ */
+static inline fileSize allocated_size(const struct stat& info){
+	return info.st_size;
+}
+
+/**
+ Lower the I/O and CPU priority of the calling thread, so that its disk reads wait for other programs' (Windows)
+ */
+static inline void lower_thread_priority(){
+	//background mode lowers both the thread's scheduling priority and its I/O priority
+	SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+}
+
+#pragma mark macOS functions
+#elif defined __APPLE__
+//	#include <boost/filesystem.hpp>
+//	#include <boost/range/iterator_range.hpp>
+	#include <sys/statvfs.h>
+	#include <sys/resource.h>
+//	using namespace boost::filesystem;
+	using namespace std::filesystem;
+//place macOS-specific globals here
+
+/**
+ Determines if a file is hidden
+ @param strpath the path to the file
+ @return true if file is hidden (path starts with '.'), false otherwise
+ */
+static inline bool is_hidden(const std::string& strpath){
+	path p(strpath);
+	//true if path name starts with '.'
+	return p.filename().string()[0] == '.';
+}
+
+
+/**
+ Determines if a path is too long to process. On macOS (HFS/APFS), the file path length is unlimited, but the filename limit is 255 characters.
+ @note Uses statvfs to query the correct maximum path.
+ @param inPath the path to the file
+ @return true if the path is too long, false if not
+ */
+static inline bool path_too_long(const std::string& inPath){
+	path p = path(inPath);
+	struct statvfs buf;
+	statvfs(inPath.c_str(),&buf);
+	return p.filename().string().size() > buf.f_namemax;
+}
+
+/**
+ Lower the I/O and CPU priority of the calling thread, so that its disk reads wait for other programs' (macOS)
+ */
+static inline void lower_thread_priority(){
+	//a background thread has both its CPU and its I/O throttled
+	setpriority(PRIO_DARWIN_THREAD, 0, PRIO_DARWIN_BG);
+}
+
+#pragma mark Linux functions
+#elif defined __linux__
+#include <limits.h>
+#include <sys/statvfs.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/**
+ Lower the I/O and CPU priority of the calling thread, so that its disk reads wait for other programs' (Linux)
+ */
+static inline void lower_thread_priority(){
+	//glibc has no wrapper for ioprio_set. Who 1 is IOPRIO_WHO_PROCESS, and id 0 is the calling thread.
+	//The idle class (3) is only given disk time when no other process wants it.
+	const int ioprioWhoProcess = 1, ioprioClassIdle = 3, ioprioClassShift = 13;
+	syscall(SYS_ioprio_set, ioprioWhoProcess, 0, ioprioClassIdle << ioprioClassShift);
+	//Linux applies nice values to single threads
+	setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), 19);
+}
+/**
+ Determines if a path is too long to process. On Linux, a file path cannot exceed 4096 characters, and a filename cannot exceed 255 bytes.
+ @param inPath the path to the file
+ @return true if path is too long, false otherwise
+ */
+static inline bool path_too_long(const std::string& inPath){
+	std::filesystem::path p(inPath);
+	struct statvfs buf;
+	statvfs(inPath.c_str(),&buf);
+	if (p.filename().string().size() > buf.f_namemax){
+		return true;
+	}
+	return p.stem().string().size() > PATH_MAX;
+}
+
+
+/**
+ Determines if a file is hidden
+ @param strpath the path to the file
+ @return true if file is hidden (path starts with '.'), false otherwise
+ */
+static inline bool is_hidden(const std::string& strpath){
+	std::filesystem::path p(strpath);
+	//true if path name starts with '.'
+	return p.filename().string()[0] == '.';
+}
+
+#else
+//place globals for systems here
+
+#endif
+
+
+#pragma mark Win-Linux functions
+//globals for both linux and windows
+#if defined __linux__ || defined _WIN32
+#define leaf() filename()
+
+#endif
+
+#pragma mark Unix-like functions
+#if defined __APPLE__ || defined __linux__
+#include <sys/param.h>
+#include <unistd.h>
+
+
+/**
+ Spell a path the way a tree spells it. The kernel reports paths that are absolute with symbolic links resolved,
+ while a tree's paths start with its root as it was given, which may be relative or reached through a symbolic link.
+ @param resolved the path as the kernel reports it
+ @param resolvedRoot the tree's root, resolved the same way
+ @param root the tree's root as it was given
+ @return the path starting with root, or an empty string if it is not inside the root
+ */
+static inline std::string respell_path(const std::string& resolved, const std::string& resolvedRoot, const std::string& root){
+	if (resolved == resolvedRoot){
+		return root;
+	}
+	//the resolved root only ends in a separator if it is /
+	std::string prefix = resolvedRoot.size() > 0 && resolvedRoot.back() == '/' ? resolvedRoot : resolvedRoot + "/";
+	if (resolved.compare(0, prefix.size(), prefix) != 0){
+		return "";
+	}
+	std::string rest = resolved.substr(prefix.size());
+	return root.size() > 0 && root.back() == '/' ? root + rest : root + "/" + rest;
+}
+
+/**
+ Determines if an item is accessible using its stat mode
+ @param mode the st_mode of the item
+ @return true if accessible, false otherwise
+ */
+static inline bool can_access(mode_t mode){
+	return mode & S_IRUSR || mode & S_IROTH;
+}
+
+/**
+ Determines if an item is write-able using its stat mode
+ @param mode the st_mode of the item
+ @return true if the item can be written to, false otherwise
+ */
+static inline bool is_writable(uint32_t mode){
+	//owner or others can write
+	return mode & S_IWUSR || mode & S_IWOTH;
+}
+
+/**
+ Determines if an item is write-able using stat
+ @param path the path to the file
+ @return true if the file can be written to, false otherwise
+ */
+static inline bool is_writable(const std::string& path){
+	return is_writable((uint32_t)get_stat(path).st_mode);
+}
+
+/**
+ Determines if an item is executable using its stat mode
+ @param mode the st_mode of the item
+ @return true if the item is executable, false otherwise
+ */
+static inline bool is_executable(uint32_t mode){
+	//owner can exeucte or others can execute if the item is not a folder
+	return (mode & S_IXUSR || mode & S_IXOTH) && !S_ISDIR(mode);
+}
+
+/**
+ Determines if an item is executable using stat
+ @param path the path to the file
+ @return true if file is executable, false otherwise
+ */
+static inline bool is_executable(const std::string& path){
+	return is_executable((uint32_t)get_stat(path).st_mode);
+}
+
+/**
+ Gets a permissions string based on a stat mode
+ @param perm the st_mode of the item
+ @return string representing the permissions
+ */
+static inline std::string permstr_for(uint32_t perm){
+	char perms[10];
+	perms[0] = (perm & S_IRUSR) ? 'r' : '-';
+    perms[1] = (perm & S_IWUSR) ? 'w' : '-';
+    perms[2] = (perm & S_IXUSR) ? 'x' : '-';
+    perms[3] = (perm & S_IRGRP) ? 'r' : '-';
+    perms[4] = (perm & S_IWGRP) ? 'w' : '-';
+    perms[5] = (perm & S_IXGRP) ? 'x' : '-';
+    perms[6] = (perm & S_IROTH) ? 'r' : '-';
+    perms[7] = (perm & S_IWOTH) ? 'w' : '-';
+    perms[8] = (perm & S_IXOTH) ? 'x' : '-';
+    perms[9] = '\0';
+	
+	return std::string(perms);
+}
+
+/**
+ Gets a permissions string based on stat
+ @param path the path to the item
+ @return string representing the permissions
+ */
+static inline std::string permstr_for(const std::string& path){
+	return permstr_for((uint32_t)get_stat(path).st_mode);
+}
+
+/**
+ Determines the st_mode type of an item
+ @param perm the st_mode of the item
+ @return a string for the type
+ */
+static inline std::string modet_type_for(uint32_t perm){
+	//the type is one value in the S_IFMT bits, not a set of flags
+	switch (perm & S_IFMT){
+		case S_IFREG:
+			return "regular file";
+		case S_IFDIR:
+			return "directory";
+		case S_IFLNK:
+			return "symbolic link";
+		case S_IFBLK:
+			return "block device";
+		case S_IFCHR:
+			return "character device";
+		case S_IFIFO:
+			return "FIFO";
+		case S_IFSOCK:
+			return "socket";
+		default:
+			return "";
+	}
+}
+
+/**
+ Determines the st_mode type of a path
+ @param path the path to the file
+ @return a string for the type
+ */
+static inline std::string modet_type_for(const std::string& path){
+	return modet_type_for((uint32_t)get_stat(path).st_mode);
+}
+
+/**
+ @param info the result of stat'ing a file
+ @return the number of bytes the file's blocks take on disk, less than its size if it is sparse or compressed
+ */
+static inline fileSize allocated_size(const struct stat& info){
+	//st_blocks counts 512-byte units regardless of the file system's block size
+	return (fileSize)info.st_blocks * DEV_BSIZE;
+}
+
+/**
+ Returns the size of the file on disk, based on the number of blocks it consumes
+ @param path the path to the file
+ @return number of bytes representing the file	on disk
+ */
+static inline fileSize size_on_disk(const std::string& path){
+	return allocated_size(get_stat(path));
+}
+
+#endif
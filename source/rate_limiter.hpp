@@ -0,0 +1,57 @@
+//
+//  rate_limiter.hpp
+//  mac
+//
+//  Copyright © 2020 Ravbug. All rights reserved.
+//
+
+#pragma once
+#include <chrono>
+#include <mutex>
+#include <stdint.h>
+
+/**
+ Spaces out operations shared by many threads so that, on average, no more than a set number start each second.
+ Each caller reserves its operations and is given the time they may start. The wait is left to the caller,
+ so it can give up early. Time left unused while idle only carries over as a short burst.
+ */
+class rateLimiter{
+public:
+	typedef std::chrono::steady_clock clock;
+
+	/**
+	 @param perSecond the most operations to start each second, or 0 for no limit
+	 */
+	void setRate(uint32_t perSecond){
+		std::lock_guard<std::mutex> guard(lock);
+		interval = perSecond > 0 ? std::chrono::nanoseconds(1000000000 / perSecond) : std::chrono::nanoseconds(0);
+		next = clock::now();
+	}
+	/**
+	 @return true if operations are limited
+	 */
+	bool limited() const{
+		return interval.count() > 0;
+	}
+	/**
+	 Reserve operations
+	 @param count the number of operations
+	 @return the time at which the operations may start
+	 */
+	clock::time_point reserve(uint64_t count){
+		std::lock_guard<std::mutex> guard(lock);
+		clock::time_point now = clock::now();
+		if (next < now - burst){
+			next = now - burst;
+		}
+		clock::time_point start = next;
+		next += interval * count;
+		return start;
+	}
+
+private:
+	static constexpr std::chrono::milliseconds burst{100};
+	std::mutex lock;
+	std::chrono::nanoseconds interval{0};
+	clock::time_point next;
+};
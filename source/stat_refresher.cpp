@@ -0,0 +1,126 @@
+//
+//  stat_refresher.cpp
+//  mac
+//
+//  Copyright © 2020 Ravbug. All rights reserved.
+//
+
+#include "stat_refresher.hpp"
+
+/**
+ @param tree the tree
+ @param index the index of the item
+ @return the item's details as they were when it was sized, or last changed by the watcher. Reads nothing from the file system.
+ */
+itemDetails itemDetails::stored(const DirectoryTree& tree, nodeIndex index){
+	itemDetails details;
+	details.times = *tree.timesAt(index);
+	details.mode = *tree.modeAt(index);
+	//a hard link counted elsewhere is stored as taking no space, so it is shown once read
+	details.allocated = tree.at(index)->isFolder ? 0 : *tree.allocatedAt(index);
+	return details;
+}
+
+/**
+ Stat an item the same way sizing does, without following a symbolic link
+ @param path the path to the item
+ @return the item's current details
+ */
+itemDetails itemDetails::read(const std::string& path){
+	itemDetails details;
+	struct stat info;
+#if defined _WIN32
+	details.exists = stat(path.c_str(), &info) == 0;
+#else
+	details.exists = lstat(path.c_str(), &info) == 0;
+#endif
+	if (!details.exists){
+		return details;
+	}
+	details.times = {info.st_mtime, info.st_atime, info.st_ctime};
+	details.mode = {(uint32_t)info.st_mode, (uint32_t)info.st_nlink};
+	details.allocated = (info.st_mode & S_IFMT) == S_IFDIR ? 0 : allocated_size(info);
+#if defined _WIN32
+	details.attributes = file_attributes_for(path);
+	details.hidden = is_hidden(path);
+	details.attributesRead = true;
+#endif
+	return details;
+}
+
+/**
+ @return true if both describe the item the same way
+ */
+bool itemDetails::operator==(const itemDetails& other) const{
+	bool same = exists == other.exists && times.modified == other.times.modified && times.accessed == other.times.accessed
+		&& times.changed == other.times.changed && mode == other.mode && allocated == other.allocated;
+#if defined _WIN32
+	same = same && attributes == other.attributes && hidden == other.hidden && attributesRead == other.attributesRead;
+#endif
+	return same;
+}
+
+/**
+ Start the refresher's thread, which waits for requests
+ @param resultCallback the function to call with each item that was read. Invoked from the refresher's thread.
+ */
+statRefresher::statRefresher(const resultCallback& resultCallback) : state(std::make_shared<sharedState>()){
+	state->done = resultCallback;
+	std::thread(&statRefresher::run, state).detach();
+}
+
+/**
+ Stop the thread without waiting for a read in progress, whose result is not reported. The thread exits once the read returns.
+ */
+statRefresher::~statRefresher(){
+	{
+		std::lock_guard<std::mutex> guard(state->lock);
+		state->stopping = true;
+	}
+	state->wake.notify_one();
+}
+
+/**
+ Read an item's details in the background, replacing any request that has not been started
+ @param path the path to the item
+ @return the number of the request, which is passed to the callback with the result
+ */
+uint64_t statRefresher::request(const std::string& path){
+	uint64_t number;
+	{
+		std::lock_guard<std::mutex> guard(state->lock);
+		state->pending = path;
+		number = ++state->requested;
+	}
+	state->wake.notify_one();
+	return number;
+}
+
+/**
+ Read the latest request, one at a time, until the refresher is destroyed
+ @param state the requests, kept alive by the thread after the refresher is gone
+ */
+void statRefresher::run(std::shared_ptr<sharedState> state){
+	while (true){
+		std::string path;
+		uint64_t number;
+		{
+			std::unique_lock<std::mutex> guard(state->lock);
+			state->wake.wait(guard, [&state]{
+				return state->stopping || state->requested != state->taken;
+			});
+			if (state->stopping){
+				return;
+			}
+			path = state->pending;
+			number = state->taken = state->requested;
+		}
+		itemDetails details = itemDetails::read(path);
+		//reported under the lock, so that no result arrives once the destructor has returned
+		std::lock_guard<std::mutex> guard(state->lock);
+		if (state->stopping){
+			return;
+		}
+		state->done(number, details);
+	}
+}
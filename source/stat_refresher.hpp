@@ -0,0 +1,75 @@
+//
+//  stat_refresher.hpp
+//  mac
+//
+//  Copyright © 2020 Ravbug. All rights reserved.
+//
+
+#pragma once
+#include "DirectoryData.hpp"
+#include <array>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ The details of an item that the sidebar shows, either as stored in the tree when it was sized, or read again from the file system
+ */
+struct itemDetails{
+	//false if the item could not be stat'ed, such as after it was deleted
+	bool exists = true;
+	itemTimes times;
+	//not known for items that were never stat'ed, such as folders that were not entered
+	itemMode mode;
+	//the bytes a file takes on disk, 0 for folders
+	fileSize allocated = 0;
+#if defined _WIN32
+	//read with GetFileAttributes, which the tree does not store, so they are only known once the item is read again
+	std::array<bool, 13> attributes{};
+	bool hidden = false;
+	bool attributesRead = false;
+#endif
+
+	static itemDetails stored(const DirectoryTree&, nodeIndex);
+	static itemDetails read(const std::string&);
+	bool operator==(const itemDetails&) const;
+	bool operator!=(const itemDetails& other) const{
+		return !(*this == other);
+	}
+};
+
+/**
+ Reads the details of one item at a time on a background thread, so that a slow file system, such as a network mount,
+ never blocks the caller. Only the latest request is kept: requests made while a read is in progress replace each other,
+ so at most one read is outstanding no matter how quickly requests arrive.
+ */
+class statRefresher{
+public:
+	/**
+	 Called from the refresher's thread with the number of the request, and the details that were read
+	 */
+	typedef std::function<void(uint64_t, const itemDetails&)> resultCallback;
+
+	statRefresher(const resultCallback&);
+	~statRefresher();
+	uint64_t request(const std::string&);
+
+private:
+	//shared with the thread, which is detached so that a read stuck on a hung mount never blocks the destructor
+	struct sharedState{
+		resultCallback done;
+		std::mutex lock;
+		std::condition_variable wake;
+		std::string pending;
+		//the number of the latest request, and of the last one the thread took
+		uint64_t requested = 0;
+		uint64_t taken = 0;
+		bool stopping = false;
+	};
+	std::shared_ptr<sharedState> state;
+
+	static void run(std::shared_ptr<sharedState>);
+};
@@ -0,0 +1,405 @@
+//
+//  tree_watcher.cpp
+//  mac
+//
+//  Copyright © 2020 Ravbug. All rights reserved.
+//
+
+#if defined __linux__
+#include "platform.h"
+#include "tree_watcher.hpp"
+#include <filesystem>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/fanotify.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+using namespace std;
+
+//entry events that can change the size of a folder
+static constexpr uint32_t inotifyMask = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_MODIFY | IN_ATTRIB | IN_ONLYDIR | IN_DONT_FOLLOW;
+
+/**
+ Start watching a tree. The folders in the tree are watched as they are when the watcher is created.
+ @param tree the tree to watch. Only read during construction.
+ @param logCallback the function to call with error messages. Invoked from the watcher's thread.
+ */
+treeWatcher::treeWatcher(const DirectoryTree& tree, const logCallback& logCallback){
+	log = logCallback;
+	rootPath = tree.pathOf(tree.root());
+	//fanotify reports folders resolved, and they are spelled the tree's way before they are queued
+	std::error_code ec;
+	resolvedRoot = std::filesystem::canonical(rootPath, ec).string();
+	if (ec){
+		resolvedRoot = rootPath;
+	}
+	stopFd = eventfd(0, EFD_CLOEXEC);
+
+	if (!startFanotify()){
+		notifyFd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+		if (notifyFd < 0){
+			log(string("Cannot watch for changes: ") + strerror(errno));
+			return;
+		}
+		//watch every folder that was sized
+		vector<nodeIndex> pending = {0};
+		while (pending.size() > 0){
+			DirectoryData* folder = tree.at(pending.back());
+			pending.pop_back();
+			if (folder->isSymlink){
+				continue;
+			}
+			watchFolder(tree.pathOf(folder));
+			for (uint32_t i = 0; i < folder->numFolders; i++){
+				pending.push_back(folder->firstChild + i);
+			}
+		}
+	}
+	worker = thread(&treeWatcher::run, this);
+}
+
+treeWatcher::~treeWatcher(){
+	if (worker.joinable()){
+		uint64_t one = 1;
+		write(stopFd, &one, sizeof(one));
+		worker.join();
+	}
+	for (int fd : {notifyFd, mountFd, stopFd}){
+		if (fd >= 0){
+			close(fd);
+		}
+	}
+}
+
+/**
+ Watch the whole filesystem containing the root with fanotify, reporting the folder and name of each changed entry
+ @return true if fanotify is watching, false if it is unavailable or not permitted
+ */
+bool treeWatcher::startFanotify(){
+#if defined FAN_REPORT_DFID_NAME
+	int fd = fanotify_init(FAN_CLASS_NOTIF | FAN_CLOEXEC | FAN_NONBLOCK | FAN_REPORT_DFID_NAME, O_RDONLY | O_LARGEFILE);
+	if (fd < 0){
+		return false;
+	}
+	uint64_t mask = FAN_CREATE | FAN_DELETE | FAN_MOVED_FROM | FAN_MOVED_TO | FAN_MODIFY | FAN_ATTRIB | FAN_ONDIR;
+	if (fanotify_mark(fd, FAN_MARK_ADD | FAN_MARK_FILESYSTEM, mask, AT_FDCWD, rootPath.c_str()) != 0){
+		close(fd);
+		return false;
+	}
+	mountFd = open(rootPath.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (mountFd < 0){
+		close(fd);
+		return false;
+	}
+	notifyFd = fd;
+	fanotify = true;
+	return true;
+#else
+	return false;
+#endif
+}
+
+/**
+ Add an inotify watch for a single folder
+ @param folder the path to the folder
+ */
+void treeWatcher::watchFolder(const string& folder){
+	int wd = inotify_add_watch(notifyFd, folder.c_str(), inotifyMask);
+	if (wd >= 0){
+		watches[wd] = folder;
+	}
+	else if (errno == ENOSPC && !watchLimitLogged){
+		watchLimitLogged = true;
+		log("Cannot watch every folder for changes: the inotify watch limit was reached. Raise fs.inotify.max_user_watches to watch more.");
+	}
+}
+
+/**
+ Add inotify watches for a folder and every folder inside it, for folders that appear after watching started
+ @param folder the path to the folder
+ */
+void treeWatcher::watchRecursive(const string& folder){
+	watchFolder(folder);
+	error_code ec;
+	for (auto it = filesystem::recursive_directory_iterator(folder, filesystem::directory_options::skip_permission_denied, ec); !ec && it != filesystem::recursive_directory_iterator(); it.increment(ec)){
+		if (it->is_directory(ec) && !it->is_symlink(ec)){
+			watchFolder(it->path().string());
+		}
+	}
+}
+
+/**
+ Read notifications until the watcher is destroyed
+ */
+void treeWatcher::run(){
+	alignas(8) static thread_local char buffer[64 * 1024];
+	pollfd fds[2] = {{notifyFd, POLLIN, 0}, {stopFd, POLLIN, 0}};
+	while (true){
+		if (poll(fds, 2, -1) < 0){
+			if (errno == EINTR){
+				continue;
+			}
+			log(string("Stopped watching for changes: ") + strerror(errno));
+			return;
+		}
+		if (fds[1].revents != 0){
+			return;
+		}
+		ssize_t length;
+		while ((length = read(notifyFd, buffer, sizeof(buffer))) > 0){
+			if (fanotify){
+				readFanotify(buffer, length);
+			}
+			else{
+				readInotify(buffer, length);
+			}
+		}
+	}
+}
+
+/**
+ Queue the entries reported in a buffer of fanotify events
+ @param buffer the events
+ @param length the length of the events in bytes
+ */
+void treeWatcher::readFanotify(char* buffer, ssize_t length){
+#if defined FAN_REPORT_DFID_NAME
+	fanotify_event_metadata* event = (fanotify_event_metadata*)buffer;
+	for (; FAN_EVENT_OK(event, length); event = FAN_EVENT_NEXT(event, length)){
+		if (event->vers != FANOTIFY_METADATA_VERSION){
+			log("Stopped watching for changes: unsupported fanotify version");
+			return;
+		}
+		if (event->mask & FAN_Q_OVERFLOW){
+			log("Some changes were missed. Reload the folder to bring it up to date.");
+			continue;
+		}
+		fanotify_event_info_fid* info = (fanotify_event_info_fid*)(event + 1);
+		if ((char*)info >= (char*)event + event->event_len || info->hdr.info_type != FAN_EVENT_INFO_TYPE_DFID_NAME){
+			continue;
+		}
+		//the record holds a handle to the folder, followed by the entry's name
+		file_handle* handle = (file_handle*)info->handle;
+		const char* name = (const char*)(handle->f_handle + handle->handle_bytes);
+		int folderFd = open_by_handle_at(mountFd, handle, O_PATH | O_CLOEXEC);
+		if (folderFd < 0){
+			//the folder was deleted before the event was read, its parent reports the deletion
+			continue;
+		}
+		char link[64];
+		char folder[PATH_MAX];
+		snprintf(link, sizeof(link), "/proc/self/fd/%d", folderFd);
+		ssize_t folderLength = readlink(link, folder, sizeof(folder) - 1);
+		close(folderFd);
+		if (folderLength <= 0){
+			continue;
+		}
+		folder[folderLength] = '\0';
+		string spelled = respell_path(folder, resolvedRoot, rootPath);
+		if (!spelled.empty()){
+			queue(spelled, name);
+		}
+	}
+#endif
+}
+
+/**
+ Queue the entries reported in a buffer of inotify events
+ @param buffer the events
+ @param length the length of the events in bytes
+ */
+void treeWatcher::readInotify(char* buffer, ssize_t length){
+	for (char* p = buffer; p < buffer + length; p += sizeof(inotify_event) + ((inotify_event*)p)->len){
+		inotify_event* event = (inotify_event*)p;
+		if (event->mask & IN_Q_OVERFLOW){
+			log("Some changes were missed. Reload the folder to bring it up to date.");
+			continue;
+		}
+		if (event->mask & IN_IGNORED){
+			watches.erase(event->wd);
+			continue;
+		}
+		auto folder = watches.find(event->wd);
+		if (folder == watches.end() || event->len == 0){
+			continue;
+		}
+		//new folders need their own watches
+		if ((event->mask & IN_ISDIR) && (event->mask & (IN_CREATE | IN_MOVED_TO))){
+			watchRecursive(folder->second + "/" + event->name);
+		}
+		queue(folder->second, event->name);
+	}
+}
+
+/**
+ Add a change to the queue, unless the same entry is already queued
+ @param folder the path of the folder containing the entry
+ @param name the name of the entry
+ */
+void treeWatcher::queue(const string& folder, const string& name){
+	string key = folder + '\0' + name;
+	lock_guard<mutex> lock(changesLock);
+	if (queued.insert(key).second){
+		changes.push_back({folder, name});
+	}
+}
+
+/**
+ Move the queued changes into a vector
+ @param out receives the changes, in the order they were first reported
+ */
+void treeWatcher::takeChanges(vector<change>& out){
+	lock_guard<mutex> lock(changesLock);
+	out.insert(out.end(), changes.begin(), changes.end());
+	changes.clear();
+	queued.clear();
+}
+
+/**
+ Bring the tree up to date with a changed entry. The entry is stat'ed, and added, removed or resized to match,
+ then the difference is added to every folder above it. A folder that appears is sized on its own.
+ Applying the same change twice has no further effect.
+ @param tree the tree to update
+ @param item the entry that changed
+ @param limits the limits the tree was sized with. Entries they skip are left out, and folders they do not enter are listed as empty.
+ @param moved receives the items that moved to a new index or were removed
+ @param logCallback the function to call with error messages
+ @return true if the tree changed
+ */
+bool treeWatcher::apply(DirectoryTree& tree, const change& item, const scanLimits& limits, DirectoryTree::movedList& moved, const logCallback& logCallback){
+	nodeIndex index = tree.findPath(item.folder);
+	if (index == noNode || !tree.at(index)->isFolder || tree.at(index)->isSymlink){
+		return false;
+	}
+
+	//decide what the entry should be, the same way the sizer does. Skipped entries are never stat'ed.
+	string itemPath = item.folder + "/" + item.name;
+	struct stat info;
+	bool exists = !limits.names.excludes(item.name) && lstat(itemPath.c_str(), &info) == 0;
+	bool isFolder = false;
+	bool isSymlink = false;
+	fileSize size = 0;
+	fileSize allocated = 0;
+	itemTimes times;
+	itemOwner owner;
+	itemMode mode;
+	if (exists){
+		times = {info.st_mtime, info.st_atime, info.st_ctime};
+		owner = {(uint32_t)info.st_uid, (uint32_t)info.st_gid};
+		mode = {(uint32_t)info.st_mode, (uint32_t)info.st_nlink};
+		if (S_ISDIR(info.st_mode)){
+			isFolder = true;
+		}
+		else if (S_ISLNK(info.st_mode)){
+			struct stat target;
+			if (stat(itemPath.c_str(), &target) == 0){
+				exists = can_access(target.st_mode);
+				isFolder = S_ISDIR(target.st_mode);
+				isSymlink = isFolder;
+			}
+			size = isFolder ? 1 : info.st_size;
+			allocated = isFolder ? 0 : allocated_size(info);
+		}
+		else{
+			exists = can_access(info.st_mode);
+			size = info.st_size;
+			allocated = allocated_size(info);
+		}
+		//include patterns only apply to files
+		if (exists && !isFolder && !limits.names.includesFile(item.name)){
+			exists = false;
+		}
+	}
+
+	nodeIndex child = tree.findChild(index, item.name.c_str());
+	bool changed = false;
+	if (child != noNode){
+		DirectoryData* current = tree.at(child);
+		if (exists && current->isFolder == isFolder && current->isSymlink == isSymlink){
+			//folders report changes to their own contents, only their own details are kept here. Their totals are unchanged.
+			if (isFolder){
+				*tree.timesAt(child) = times;
+				*tree.ownerAt(child) = owner;
+				*tree.modeAt(child) = mode;
+				return false;
+			}
+			//a duplicate link stays a duplicate of the new size, and still takes no space
+			fileSize* linked = tree.linkedAt(child);
+			fileSize* currentAllocated = tree.allocatedAt(child);
+			bool duplicate = *linked != 0;
+			if (duplicate){
+				allocated = 0;
+			}
+			itemTimes* currentTimes = tree.timesAt(child);
+			itemOwner* currentOwner = tree.ownerAt(child);
+			itemMode* currentMode = tree.modeAt(child);
+			if (current->size == size && *currentAllocated == allocated && currentTimes->modified == times.modified && currentTimes->accessed == times.accessed
+				&& currentTimes->changed == times.changed && currentOwner->user == owner.user && currentOwner->group == owner.group && *currentMode == mode){
+				return false;
+			}
+			//the file may move to another age bucket as well as change size
+			ageBuckets before = tree.agesOf(child);
+			fileSize delta = size - current->size;
+			fileSize allocatedDelta = allocated - *currentAllocated;
+			current->size = size;
+			*currentAllocated = allocated;
+			tree.at(index)->files_size += delta;
+			fileSize linkedDelta = duplicate ? delta : 0;
+			*linked += linkedDelta;
+			*currentTimes = times;
+			*currentOwner = owner;
+			*currentMode = mode;
+			tree.addToTotals(index, delta, 0, linkedDelta, allocatedDelta);
+			tree.addToAges(index, before, -1);
+			tree.addToAges(index, tree.agesOf(child));
+			return true;
+		}
+		//gone, or replaced by a different kind of item
+		fileSize removed = current->size;
+		fileSize linkedRemoved = *tree.linkedAt(child);
+		fileSize allocatedRemoved = *tree.allocatedAt(child);
+		ageBuckets agesRemoved = tree.agesOf(child);
+		int64_t items = current->isFolder ? (int64_t)current->num_items + 1 : 1;
+		if (!current->isFolder){
+			tree.at(index)->files_size -= removed;
+		}
+		tree.removeChild(index, child, moved);
+		tree.addToTotals(index, -removed, -items, -linkedRemoved, -allocatedRemoved);
+		tree.addToAges(index, agesRemoved, -1);
+		changed = true;
+	}
+	if (!exists){
+		return changed;
+	}
+
+	nodeIndex added = tree.addChild(index, item.name, isFolder, size, moved);
+	DirectoryData* addedItem = tree.at(added);
+	addedItem->isSymlink = isSymlink;
+	if (isFolder && !isSymlink){
+		//a folder that was created or moved in may already have contents
+		folderSizer sizer(2);
+		sizer.limits = limits;
+		sizer.limitRoot = true;
+		sizer.Size(&tree, added, logCallback);
+		tree.addToTotals(index, addedItem->size, (int64_t)addedItem->num_items + 1, *tree.linkedAt(added), *tree.allocatedAt(added));
+		tree.addToAges(index, *tree.agesAt(added));
+	}
+	else{
+		if (!isFolder){
+			tree.at(index)->files_size += size;
+		}
+		*tree.allocatedAt(added) = allocated;
+		*tree.timesAt(added) = times;
+		*tree.ownerAt(added) = owner;
+		*tree.modeAt(added) = mode;
+		tree.addToTotals(index, addedItem->size, 1, 0, allocated);
+		tree.addToAges(index, tree.agesOf(added));
+	}
+	return true;
+}
+#endif
@@ -0,0 +1,79 @@
+//
+//  tree_watcher.hpp
+//  mac
+//
+//  Copyright © 2020 Ravbug. All rights reserved.
+//
+
+#pragma once
+#if defined __linux__
+#include "DirectoryData.hpp"
+#include "folder_sizer.hpp"
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/**
+ Watches a sized folder for changes and keeps its DirectoryTree up to date without sizing it again.
+ A background thread reads change notifications and queues the entries that changed. The owner applies
+ the queued changes to the tree with apply, on the thread that owns the tree.
+ Uses fanotify on the whole filesystem when permitted (CAP_SYS_ADMIN), otherwise an inotify watch per folder.
+ */
+class treeWatcher{
+public:
+	/**
+	 An entry that changed: created, deleted, moved, or modified
+	 */
+	struct change{
+		//full path of the folder containing the entry
+		std::string folder;
+		std::string name;
+	};
+
+	treeWatcher(const DirectoryTree&, const logCallback&);
+	~treeWatcher();
+
+	/**
+	 @return true if changes are reported by fanotify, false if by inotify
+	 */
+	bool usingFanotify() const{
+		return fanotify;
+	}
+
+	void takeChanges(std::vector<change>&);
+	static bool apply(DirectoryTree&, const change&, const scanLimits&, DirectoryTree::movedList&, const logCallback&);
+
+private:
+	std::string rootPath;
+	//the root with symbolic links resolved, as fanotify reports it
+	std::string resolvedRoot;
+	logCallback log;
+	bool fanotify = false;
+	int notifyFd = -1;
+	//a descriptor on the watched filesystem, used to open the folders fanotify reports
+	int mountFd = -1;
+	//signalled to stop the thread
+	int stopFd = -1;
+	std::thread worker;
+
+	//inotify watch descriptors and the folders they watch, only used by the thread
+	std::unordered_map<int, std::string> watches;
+	bool watchLimitLogged = false;
+
+	std::mutex changesLock;
+	std::vector<change> changes;
+	//the changes already queued, to collapse repeated events for the same entry
+	std::unordered_set<std::string> queued;
+
+	bool startFanotify();
+	void watchFolder(const std::string&);
+	void watchRecursive(const std::string&);
+	void run();
+	void readFanotify(char*, ssize_t);
+	void readInotify(char*, ssize_t);
+	void queue(const std::string&, const std::string&);
+};
+#endif
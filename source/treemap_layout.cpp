@@ -0,0 +1,217 @@
+//
+//  treemap_layout.cpp
+//  mac
+//
+//  Copyright © 2020 Ravbug. All rights reserved.
+//
+
+#include "treemap_layout.hpp"
+#include <algorithm>
+#include <limits>
+
+/**
+ Lay out the items below a folder to fill a rectangle
+ @param tree the tree, which must not change while it is rendered
+ @param root the item to fill the rectangle with
+ @param width the width of the rectangle
+ @param height the height of the rectangle
+ @param tiles receives the items to draw. Folders come before their contents, so drawing in order paints children over their parents.
+ */
+void treemapLayout::render(const DirectoryTree& tree, nodeIndex root, float width, float height, vector<treemapTile>& tiles){
+	tiles.clear();
+	renders++;
+	if (width < minimumSide || height < minimumSide){
+		return;
+	}
+	tiles.push_back({root, {0, 0, width, height}, 0, tree.at(root)->isFolder});
+	size_t used = 0;
+	//the tiles double as the queue, so the map is built breadth first
+	for (size_t i = 0; i < tiles.size(); i++){
+		const treemapTile tile = tiles[i];
+		const DirectoryData* folder = tree.at(tile.index);
+		if (!tile.isFolder || folder->isSymlink || folder->numChildren() == 0){
+			continue;
+		}
+		treemapRect inner{tile.rect.x + padding, tile.rect.y + padding, tile.rect.w - 2 * padding, tile.rect.h - 2 * padding};
+		if (inner.w < minimumSide || inner.h < minimumSide){
+			continue;
+		}
+		const folderLayout& layout = layoutOf(tree, tile.index, inner.w, inner.h);
+		used++;
+		for (const placed& child : layout.children){
+			if (child.index == noNode || child.rect.w < minimumSide || child.rect.h < minimumSide){
+				continue;
+			}
+			tiles.push_back({child.index, {inner.x + child.rect.x, inner.y + child.rect.y, child.rect.w, child.rect.h}, tile.depth + 1, tree.at(child.index)->isFolder});
+		}
+	}
+
+	//forget the layouts of folders that are no longer drawn, once they outnumber the ones that are
+	if (cache.size() > 2 * used + 1024){
+		for (auto it = cache.begin(); it != cache.end();){
+			it = it->second.used == renders ? next(it) : cache.erase(it);
+		}
+	}
+}
+
+/**
+ Forget every cached layout, such as when the tree is replaced
+ */
+void treemapLayout::clear(){
+	cache.clear();
+}
+
+/**
+ Find the item drawn at a point
+ @param tiles the tiles from render
+ @param x the horizontal position of the point
+ @param y the vertical position of the point
+ @return the deepest tile at the point, or nullptr if there is none
+ */
+const treemapTile* treemapLayout::hitTest(const vector<treemapTile>& tiles, float x, float y){
+	//tiles later in the list are nested inside, or beside, the ones before them
+	for (size_t i = tiles.size(); i > 0; i--){
+		if (tiles[i - 1].rect.contains(x, y)){
+			return &tiles[i - 1];
+		}
+	}
+	return nullptr;
+}
+
+/**
+ Get the layout of a folder's children, laying them out again if the folder changed since the cached layout
+ @param tree the tree
+ @param folder the index of the folder
+ @param width the width of the space for the children
+ @param height the height of the space for the children
+ @return the layout, valid until the next call
+ */
+const treemapLayout::folderLayout& treemapLayout::layoutOf(const DirectoryTree& tree, nodeIndex folder, float width, float height){
+	folderLayout& layout = cache[folder];
+	layout.used = renders;
+	const DirectoryData* item = tree.at(folder);
+	if (current(tree, item, folder, layout, width, height)){
+		return layout;
+	}
+	layout.width = width;
+	layout.height = height;
+	layout.size = tree.sizeAt(folder);
+	layout.firstChild = item->firstChild;
+	layout.numChildren = item->numChildren();
+	layout.children.clear();
+
+	//in some size modes a folder's size includes its own entries, so the area is split by the sizes of the children alone
+	fileSize total = 0;
+	for (uint32_t i = 0; i < item->numChildren(); i++){
+		total += tree.sizeAt(item->firstChild + i);
+	}
+	if (total == 0){
+		return layout;
+	}
+	//a child whose share of the area is less than the smallest tile can never be drawn, so it is not sorted or placed on its own
+	fileSize smallest = (fileSize)((long double)total * minimumSide * minimumSide / ((long double)width * height));
+	fileSize rest = 0;
+	for (uint32_t i = 0; i < item->numChildren(); i++){
+		nodeIndex child = item->firstChild + i;
+		fileSize size = tree.sizeAt(child);
+		if (size == 0){
+			continue;
+		}
+		if (size < smallest){
+			rest += size;
+		}
+		else{
+			layout.children.push_back({child, size, {}});
+		}
+	}
+	sort(layout.children.begin(), layout.children.end(), [](const placed& a, const placed& b){
+		return a.size > b.size;
+	});
+	if (rest > 0){
+		layout.children.push_back({noNode, rest, {}});
+	}
+	squarify(layout.children.data(), layout.children.size(), {0, 0, width, height});
+	return layout;
+}
+
+/**
+ Check whether a cached layout still matches its folder. Only the sizes of the children that were placed are compared,
+ the rest are covered by the folder's own size.
+ @param tree the tree
+ @param item the folder
+ @param folder the index of the folder
+ @param layout the cached layout
+ @param width the width of the space for the children
+ @param height the height of the space for the children
+ @return true if the layout can be drawn as it is
+ */
+bool treemapLayout::current(const DirectoryTree& tree, const DirectoryData* item, nodeIndex folder, const folderLayout& layout, float width, float height){
+	if (layout.width != width || layout.height != height || layout.firstChild != item->firstChild || layout.numChildren != item->numChildren() || layout.size != tree.sizeAt(folder)){
+		return false;
+	}
+	for (const placed& child : layout.children){
+		if (child.index != noNode && tree.sizeAt(child.index) != child.size){
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ Place items in a rectangle, in proportion to their sizes. Items are added to a row along the rectangle's shorter side
+ for as long as that makes the row's most stretched item closer to square, then the row is fixed and the rest of the rectangle is filled the same way.
+ @param items the items, largest first
+ @param count the number of items
+ @param space the rectangle to fill
+ */
+void treemapLayout::squarify(placed* items, size_t count, treemapRect space){
+	double total = 0;
+	for (size_t i = 0; i < count; i++){
+		total += items[i].size;
+	}
+	//area per byte
+	double scale = (double)space.w * space.h / total;
+	for (size_t start = 0, end; start < count; start = end){
+		double side = min(space.w, space.h);
+		double rowArea = 0, smallest = 0, largest = 0;
+		double worst = numeric_limits<double>::infinity();
+		for (end = start; end < count; end++){
+			double area = items[end].size * scale;
+			double sum = rowArea + area;
+			double lo = end == start ? area : min(smallest, area);
+			double hi = end == start ? area : max(largest, area);
+			//the worst aspect ratio in the row if the item joins it
+			double ratio = max(side * side * hi / (sum * sum), sum * sum / (side * side * lo));
+			if (end > start && ratio > worst){
+				break;
+			}
+			worst = ratio;
+			rowArea = sum;
+			smallest = lo;
+			largest = hi;
+		}
+
+		//the row runs along the shorter side
+		double thickness = rowArea / side;
+		bool alongLeft = space.w >= space.h;
+		double offset = 0;
+		for (size_t i = start; i < end; i++){
+			double length = items[i].size * scale / thickness;
+			if (alongLeft){
+				items[i].rect = {space.x, (float)(space.y + offset), (float)thickness, (float)length};
+			}
+			else{
+				items[i].rect = {(float)(space.x + offset), space.y, (float)length, (float)thickness};
+			}
+			offset += length;
+		}
+		if (alongLeft){
+			space.x += thickness;
+			space.w -= thickness;
+		}
+		else{
+			space.y += thickness;
+			space.h -= thickness;
+		}
+	}
+}
@@ -0,0 +1,90 @@
+//
+//  treemap_layout.hpp
+//  mac
+//
+//  Copyright © 2020 Ravbug. All rights reserved.
+//
+
+#pragma once
+#include "DirectoryData.hpp"
+#include <unordered_map>
+#include <vector>
+
+/**
+ A rectangle in pixels
+ */
+struct treemapRect{
+	float x, y, w, h;
+
+	/**
+	 @return true if a point is inside the rectangle
+	 */
+	bool contains(float px, float py) const{
+		return px >= x && py >= y && px < x + w && py < y + h;
+	}
+};
+
+/**
+ An item to draw, with the depth below the treemap's root
+ */
+struct treemapTile{
+	nodeIndex index;
+	treemapRect rect;
+	uint32_t depth;
+	bool isFolder;
+};
+
+/**
+ Lays out a sized tree as a squarified treemap: each folder's area is split among its children in proportion to their sizes,
+ in rows chosen to keep the rectangles close to square. Items too small to see are not laid out, so the work to draw the map
+ depends on the number of pixels rather than the number of items. Each folder's layout is cached, and only laid out again when
+ the folder's size, its children, or the space it is drawn in changes, so a change to one subtree relays out only that subtree
+ and the folders above it.
+ */
+class treemapLayout{
+public:
+	//items narrower or shorter than this, in pixels, are not drawn, nor is anything inside them
+	float minimumSide = 4;
+	//the space between a folder's edge and its contents, so that nesting is visible
+	float padding = 2;
+
+	void render(const DirectoryTree&, nodeIndex, float, float, vector<treemapTile>&);
+	void clear();
+	static const treemapTile* hitTest(const vector<treemapTile>&, float, float);
+
+	/**
+	 @return the number of folders whose layout is cached
+	 */
+	size_t cachedFolders() const{
+		return cache.size();
+	}
+
+private:
+	/**
+	 A child placed in its folder. Children too small to draw are lumped into one entry with no index.
+	 */
+	struct placed{
+		nodeIndex index;
+		fileSize size;
+		treemapRect rect;
+	};
+	/**
+	 The layout of one folder's children, and what it was laid out from
+	 */
+	struct folderLayout{
+		float width = 0, height = 0;
+		fileSize size = 0;
+		nodeIndex firstChild = noNode;
+		uint32_t numChildren = 0;
+		//the last render that used the layout
+		uint32_t used = 0;
+		//relative to the folder's inner rectangle
+		vector<placed> children;
+	};
+	unordered_map<nodeIndex, folderLayout> cache;
+	uint32_t renders = 0;
+
+	const folderLayout& layoutOf(const DirectoryTree&, nodeIndex, float, float);
+	static bool current(const DirectoryTree&, const DirectoryData*, nodeIndex, const folderLayout&, float, float);
+	static void squarify(placed*, size_t, treemapRect);
+};
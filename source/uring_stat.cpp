@@ -0,0 +1,238 @@
+//
+//  uring_stat.cpp
+//  mac
+//
+//  Copyright © 2020 Ravbug. All rights reserved.
+//
+
+#if defined __linux__
+#include "uring_stat.hpp"
+#include <linux/io_uring.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/sysmacros.h>
+
+//glibc does not provide wrappers for the io_uring syscalls
+static inline int io_uring_setup(unsigned int entries, io_uring_params* params){
+	return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+static inline int io_uring_enter(int fd, unsigned int submit, unsigned int complete, unsigned int flags){
+	return (int)syscall(__NR_io_uring_enter, fd, submit, complete, flags, nullptr, 0);
+}
+static inline int io_uring_register(int fd, unsigned int opcode, void* arg, unsigned int count){
+	return (int)syscall(__NR_io_uring_register, fd, opcode, arg, count);
+}
+
+/**
+ Ask the kernel whether a ring supports statx. io_uring predates IORING_OP_STATX, so a ring can be created on kernels that reject every request.
+ @param ringfd the ring to probe
+ @return true if IORING_OP_STATX is supported
+ */
+static bool supports_statx(int ringfd){
+	std::vector<char> storage(sizeof(io_uring_probe) + IORING_OP_LAST * sizeof(io_uring_probe_op), 0);
+	io_uring_probe* probe = (io_uring_probe*)storage.data();
+	if (io_uring_register(ringfd, IORING_REGISTER_PROBE, probe, IORING_OP_LAST) < 0){
+		//kernels without the probe also lack statx
+		return false;
+	}
+	return IORING_OP_STATX <= probe->last_op && (probe->ops[IORING_OP_STATX].flags & IO_URING_OP_SUPPORTED);
+}
+
+/**
+ Convert the result of statx into a stat struct
+ @param in the statx result
+ @param out the stat struct to populate
+ */
+static inline void statx_to_stat(const struct statx& in, struct stat& out){
+	memset(&out, 0, sizeof(out));
+	out.st_dev = makedev(in.stx_dev_major, in.stx_dev_minor);
+	out.st_ino = in.stx_ino;
+	out.st_mode = in.stx_mode;
+	out.st_nlink = in.stx_nlink;
+	out.st_uid = in.stx_uid;
+	out.st_gid = in.stx_gid;
+	out.st_rdev = makedev(in.stx_rdev_major, in.stx_rdev_minor);
+	out.st_size = in.stx_size;
+	out.st_blksize = in.stx_blksize;
+	out.st_blocks = in.stx_blocks;
+	out.st_atim.tv_sec = in.stx_atime.tv_sec;
+	out.st_atim.tv_nsec = in.stx_atime.tv_nsec;
+	out.st_mtim.tv_sec = in.stx_mtime.tv_sec;
+	out.st_mtim.tv_nsec = in.stx_mtime.tv_nsec;
+	out.st_ctim.tv_sec = in.stx_ctime.tv_sec;
+	out.st_ctim.tv_nsec = in.stx_ctime.tv_nsec;
+}
+
+/**
+ Create a ring. If io_uring or its statx operation is not available, ok() will return false.
+ @param entries the maximum number of stat requests to keep in flight
+ */
+statRing::statRing(unsigned int entries){
+	io_uring_params params;
+	memset(&params, 0, sizeof(params));
+	ringfd = io_uring_setup(entries, &params);
+	if (ringfd < 0){
+		ringfd = -1;
+		return;
+	}
+	if (!supports_statx(ringfd)){
+		teardown();
+		return;
+	}
+	depth = params.sq_entries;
+
+	//map the submission and completion rings, which share one mapping on newer kernels
+	sqMapSize = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+	cqMapSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+	bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+	if (single){
+		sqMapSize = cqMapSize = std::max(sqMapSize, cqMapSize);
+	}
+	sqMap = mmap(nullptr, sqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringfd, IORING_OFF_SQ_RING);
+	if (sqMap == MAP_FAILED){
+		sqMap = nullptr;
+		teardown();
+		return;
+	}
+	if (single){
+		cqMap = sqMap;
+	}
+	else{
+		cqMap = mmap(nullptr, cqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringfd, IORING_OFF_CQ_RING);
+		if (cqMap == MAP_FAILED){
+			cqMap = nullptr;
+			teardown();
+			return;
+		}
+	}
+	sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+	void* sqeMap = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringfd, IORING_OFF_SQES);
+	if (sqeMap == MAP_FAILED){
+		teardown();
+		return;
+	}
+	sqes = (io_uring_sqe*)sqeMap;
+
+	char* sq = (char*)sqMap;
+	sqHead = (unsigned int*)(sq + params.sq_off.head);
+	sqTail = (unsigned int*)(sq + params.sq_off.tail);
+	sqMask = (unsigned int*)(sq + params.sq_off.ring_mask);
+	sqArray = (unsigned int*)(sq + params.sq_off.array);
+	char* cq = (char*)cqMap;
+	cqHead = (unsigned int*)(cq + params.cq_off.head);
+	cqTail = (unsigned int*)(cq + params.cq_off.tail);
+	cqMask = (unsigned int*)(cq + params.cq_off.ring_mask);
+	cqes = (io_uring_cqe*)(cq + params.cq_off.cqes);
+
+	buffers.resize(depth);
+	owners.resize(depth);
+	for (unsigned int i = 0; i < depth; i++){
+		freeSlots.push_back(depth - 1 - i);
+	}
+}
+
+statRing::~statRing(){
+	teardown();
+}
+
+/**
+ Unmap the rings and close the ring, after which ok() returns false
+ */
+void statRing::teardown(){
+	if (sqes != nullptr){
+		munmap(sqes, sqesSize);
+	}
+	if (cqMap != nullptr && cqMap != sqMap){
+		munmap(cqMap, cqMapSize);
+	}
+	if (sqMap != nullptr){
+		munmap(sqMap, sqMapSize);
+	}
+	if (ringfd >= 0){
+		close(ringfd);
+	}
+	sqes = nullptr;
+	sqMap = cqMap = nullptr;
+	ringfd = -1;
+}
+
+/**
+ Stat every request relative to a directory. Keeps up to the ring's depth of requests in flight,
+ refilling the ring as completions are reaped. Returns once every request has completed.
+ @param dirfd the file descriptor of the directory the names are relative to
+ @param requests the entries to stat. Each request's result or error is populated.
+ @param follow true to follow symbolic links, false to stat the link itself
+ @return false if the requests must be stat'ed another way: either the ring failed, in which case ok() will return false,
+ or the kernel rejected the statx requests themselves
+ */
+bool statRing::statAll(int dirfd, std::vector<request>& requests, bool follow){
+	size_t submitted = 0;
+	size_t completed = 0;
+	bool rejected = false;
+	int flags = AT_STATX_SYNC_AS_STAT | (follow ? 0 : AT_SYMLINK_NOFOLLOW);
+
+	while (completed < requests.size()){
+		//fill the submission ring
+		unsigned int tail = *sqTail;
+		while (submitted < requests.size() && freeSlots.size() > 0){
+			unsigned int slot = freeSlots.back();
+			freeSlots.pop_back();
+			owners[slot] = submitted;
+
+			unsigned int index = tail & *sqMask;
+			io_uring_sqe* sqe = &sqes[index];
+			memset(sqe, 0, sizeof(*sqe));
+			sqe->opcode = IORING_OP_STATX;
+			sqe->fd = dirfd;
+			sqe->addr = (unsigned long)requests[submitted].name;
+			sqe->len = STATX_BASIC_STATS;
+			sqe->off = (unsigned long)&buffers[slot];
+			sqe->statx_flags = flags;
+			sqe->user_data = slot;
+			sqArray[index] = index;
+
+			++tail;
+			++submitted;
+		}
+		__atomic_store_n(sqTail, tail, __ATOMIC_RELEASE);
+
+		//submit anything the kernel has not consumed yet, and wait for at least one completion
+		unsigned int toSubmit = tail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+		if (io_uring_enter(ringfd, toSubmit, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY){
+			//the ring is unusable, tear it down so the caller falls back
+			teardown();
+			return false;
+		}
+
+		//reap whatever has completed
+		unsigned int head = *cqHead;
+		unsigned int available = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+		while (head != available){
+			io_uring_cqe* cqe = &cqes[head & *cqMask];
+			unsigned int slot = (unsigned int)cqe->user_data;
+			request& req = requests[owners[slot]];
+			if (cqe->res == -EINVAL || cqe->res == -EOPNOTSUPP){
+				//the kernel does not understand this request, rather than the entry failing to stat
+				rejected = true;
+				req.error = -cqe->res;
+			}
+			else if (cqe->res < 0){
+				req.error = -cqe->res;
+			}
+			else{
+				req.error = 0;
+				statx_to_stat(buffers[slot], req.result);
+			}
+			freeSlots.push_back(slot);
+			++head;
+			++completed;
+		}
+		__atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+	}
+	return !rejected;
+}
+#endif
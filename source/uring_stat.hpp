@@ -0,0 +1,70 @@
+//
+//  uring_stat.hpp
+//  mac
+//
+//  Copyright © 2020 Ravbug. All rights reserved.
+//
+
+#pragma once
+#if defined __linux__
+#include <cstddef>
+#include <vector>
+#include <sys/stat.h>
+
+/**
+ Stats batches of directory entries through io_uring.
+ A whole directory's worth of statx requests is kept in flight at once, and completions are reaped as they arrive,
+ instead of waiting for one blocking stat at a time. Each ring must only be used by one thread.
+ */
+class statRing{
+public:
+	struct request{
+		//name of the entry, relative to the directory
+		const char* name;
+		//populated on success
+		struct stat result;
+		//0 on success, otherwise the errno of the failed stat
+		int error;
+	};
+
+	statRing(unsigned int depth = 256);
+	~statRing();
+
+	/**
+	 @return true if the ring was created and supports statx. io_uring may be unavailable on older kernels or blocked by seccomp.
+	 */
+	bool ok() const{
+		return ringfd >= 0;
+	}
+
+	bool statAll(int dirfd, std::vector<request>&, bool follow = false);
+
+private:
+	int ringfd = -1;
+	unsigned int depth = 0;
+
+	//shared ring memory
+	void* sqMap = nullptr;
+	void* cqMap = nullptr;
+	size_t sqMapSize = 0;
+	size_t cqMapSize = 0;
+	struct io_uring_sqe* sqes = nullptr;
+	size_t sqesSize = 0;
+
+	unsigned int* sqHead;
+	unsigned int* sqTail;
+	unsigned int* sqMask;
+	unsigned int* sqArray;
+	unsigned int* cqHead;
+	unsigned int* cqTail;
+	unsigned int* cqMask;
+	struct io_uring_cqe* cqes;
+
+	//one statx buffer per in-flight request, and the request each buffer belongs to
+	std::vector<struct statx> buffers;
+	std::vector<size_t> owners;
+	std::vector<unsigned int> freeSlots;
+
+	void teardown();
+};
+#endif